@@ -0,0 +1,356 @@
+/**
+ * @file
+ * @brief Throughput and latency benchmarks for the libopenshot render pipeline
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QDir>
+#include <QImage>
+
+#include "CacheDisk.h"
+#include "CacheMemory.h"
+#include "Clip.h"
+#include "DummyReader.h"
+#include "FFmpegReader.h"
+#include "FFmpegWriter.h"
+#include "Frame.h"
+#include "Json.h"
+#include "KeyFrame.h"
+#include "OpenShotVersion.h"
+#include "Timeline.h"
+#include "effects/Blur.h"
+#include "effects/Brightness.h"
+#include "effects/Saturation.h"
+
+using namespace openshot;
+
+namespace
+{
+	/// Options of a benchmark run (set from the command line)
+	struct Options {
+		int width = 1280;
+		int height = 720;
+		int frames = 120;
+		int repeat = 3;
+		std::string filter;
+		std::string json_path;
+		std::string work_path = QDir::tempPath().toStdString() + "/openshot-benchmark";
+	};
+
+	/// Latency samples (in milliseconds) of one benchmarked stage
+	struct Result {
+		std::string name;
+		std::vector<double> samples;
+
+		double Total() const {
+			double total = 0.0;
+			for (double sample : samples)
+				total += sample;
+			return total;
+		}
+
+		// Nearest-rank percentile (samples must be sorted)
+		double Percentile(double percent) const {
+			if (samples.empty())
+				return 0.0;
+			size_t rank = std::ceil(percent / 100.0 * samples.size());
+			return samples[std::min(std::max(rank, size_t(1)), samples.size()) - 1];
+		}
+
+		double Throughput() const {
+			double total = Total();
+			return total > 0.0 ? samples.size() * 1000.0 / total : 0.0;
+		}
+	};
+
+	/// Time each call of @a operation (after one untimed warm-up call), for @a repeat passes of
+	/// @a count calls. Each pass calls @a setup first (untimed), so passes start from the same state.
+	Result measure(const Options& options, const std::string& name, int count,
+				   std::function<void()> setup, std::function<void(int)> operation)
+	{
+		using milli_sec = std::chrono::duration<double, std::milli>;
+
+		Result result;
+		result.name = name;
+		for (int pass = 0; pass < options.repeat; pass++) {
+			if (setup)
+				setup();
+			if (pass == 0)
+				operation(0);
+			for (int i = 0; i < count; i++) {
+				const auto start = std::chrono::steady_clock::now();
+				operation(i);
+				result.samples.push_back(milli_sec(std::chrono::steady_clock::now() - start).count());
+			}
+		}
+		std::sort(result.samples.begin(), result.samples.end());
+		return result;
+	}
+
+	/// Generate a frame with a moving gradient and a sine tone (so encoders and effects get real work)
+	std::shared_ptr<Frame> synthetic_frame(int64_t number, int width, int height, Fraction fps,
+										   int sample_rate, int channels)
+	{
+		int samples = Frame::GetSamplesPerFrame(number, fps, sample_rate, channels);
+		auto frame = std::make_shared<Frame>(number, width, height, "#000000", samples, channels);
+		frame->SampleRate(sample_rate);
+
+		auto image = std::make_shared<QImage>(width, height, QImage::Format_RGBA8888_Premultiplied);
+		for (int y = 0; y < height; y++) {
+			unsigned char* line = image->scanLine(y);
+			for (int x = 0; x < width; x++) {
+				line[x * 4 + 0] = (x + number * 4) & 0xFF;
+				line[x * 4 + 1] = (y + number * 2) & 0xFF;
+				line[x * 4 + 2] = ((x ^ y) + number) & 0xFF;
+				line[x * 4 + 3] = 0xFF;
+			}
+		}
+		frame->AddImage(image);
+
+		std::vector<float> tone(samples);
+		int64_t first_sample = (number - 1) * int64_t(sample_rate / fps.ToDouble());
+		for (int i = 0; i < samples; i++)
+			tone[i] = 0.25 * std::sin(2.0 * M_PI * 440.0 * (first_sample + i) / sample_rate);
+		for (int channel = 0; channel < channels; channel++)
+			frame->AddAudio(true, channel, 0, tone.data(), samples, 1.0);
+
+		return frame;
+	}
+
+	void print_usage()
+	{
+		std::cout << "Usage: openshot-benchmark [options]\n"
+				  << "  --width N        Frame width (default 1280)\n"
+				  << "  --height N       Frame height (default 720)\n"
+				  << "  --frames N       Frames per pass (default 120)\n"
+				  << "  --repeat N       Passes per benchmark (default 3)\n"
+				  << "  --filter TEXT    Only run benchmarks whose name contains TEXT\n"
+				  << "  --json PATH      Write the results as JSON to PATH\n"
+				  << "  --work-dir PATH  Folder for the generated media (default: temp folder)\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "--width" && has_value)
+			options.width = std::atoi(argv[++i]);
+		else if (arg == "--height" && has_value)
+			options.height = std::atoi(argv[++i]);
+		else if (arg == "--frames" && has_value)
+			options.frames = std::atoi(argv[++i]);
+		else if (arg == "--repeat" && has_value)
+			options.repeat = std::atoi(argv[++i]);
+		else if (arg == "--filter" && has_value)
+			options.filter = argv[++i];
+		else if (arg == "--json" && has_value)
+			options.json_path = argv[++i];
+		else if (arg == "--work-dir" && has_value)
+			options.work_path = argv[++i];
+		else {
+			print_usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+	if (options.width < 16 || options.height < 16 || options.frames < 1 || options.repeat < 1) {
+		print_usage();
+		return 1;
+	}
+
+	const Fraction fps(30, 1);
+	const int sample_rate = 44100;
+	const int channels = 2;
+	const int frames = options.frames;
+	QDir().mkpath(QString::fromStdString(options.work_path));
+	const std::string video_path = options.work_path + "/synthetic.mp4";
+
+	// Synthetic source frames (served by a DummyReader)
+	CacheMemory source_frames;
+	for (int64_t number = 1; number <= frames; number++)
+		source_frames.Add(synthetic_frame(number, options.width, options.height, fps, sample_rate, channels));
+	DummyReader source(fps, options.width, options.height, sample_rate, channels,
+					   frames / fps.ToDouble(), &source_frames);
+	source.Open();
+
+	std::vector<Result> results;
+	auto run = [&](const std::string& name, int count, std::function<void()> setup,
+				   std::function<void(int)> operation) {
+		if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+			return;
+		results.push_back(measure(options, name, count, setup, operation));
+		const Result& r = results.back();
+		std::cout << std::left << std::setw(28) << r.name << std::right << std::fixed << std::setprecision(2)
+				  << std::setw(10) << r.Throughput() << " ops/s"
+				  << "   p50 " << std::setw(8) << r.Percentile(50) << " ms"
+				  << "   p90 " << std::setw(8) << r.Percentile(90) << " ms"
+				  << "   p99 " << std::setw(8) << r.Percentile(99) << " ms" << std::endl;
+	};
+
+	// Encode the synthetic frames (this also creates the media for the decoding benchmarks)
+	std::unique_ptr<FFmpegWriter> writer;
+	run("FFmpegWriter encode", frames,
+		[&] {
+			if (writer)
+				writer->Close();
+			writer.reset(new FFmpegWriter(video_path));
+			writer->SetAudioOptions(true, "aac", sample_rate, channels, LAYOUT_STEREO, 128000);
+			writer->SetVideoOptions(true, "libx264", fps, options.width, options.height, Fraction(1, 1), false, false, 3000000);
+			writer->Open();
+		},
+		[&](int i) { writer->WriteFrame(source.GetFrame(i + 1)); });
+	if (writer) {
+		writer->Close();
+	} else if (!QFile::exists(QString::fromStdString(video_path))) {
+		// Filtered out, but the decoding benchmarks still need the media
+		FFmpegWriter media(video_path);
+		media.SetAudioOptions(true, "aac", sample_rate, channels, LAYOUT_STEREO, 128000);
+		media.SetVideoOptions(true, "libx264", fps, options.width, options.height, Fraction(1, 1), false, false, 3000000);
+		media.Open();
+		media.WriteFrame(&source, 1, frames);
+		media.Close();
+	}
+
+	// Sequential decoding (a new reader each pass, so nothing is cached)
+	std::unique_ptr<FFmpegReader> reader;
+	const int decode_count = std::max(frames - 1, 1);
+	run("FFmpegReader decode", decode_count,
+		[&] {
+			reader.reset(new FFmpegReader(video_path));
+			reader->Open();
+		},
+		[&](int i) { reader->GetFrame(i + 1); });
+
+	// Random access decoding (seeks)
+	run("FFmpegReader seek", std::min(frames, 30),
+		[&] {
+			reader.reset(new FFmpegReader(video_path));
+			reader->Open();
+		},
+		[&](int i) { reader->GetFrame(((i * 37) % decode_count) + 1); });
+	reader.reset();
+
+	// Timeline composition: 2 overlapping video clips, and a scaled and faded copy on top
+	std::unique_ptr<Timeline> timeline;
+	std::vector<std::unique_ptr<Clip>> clips;
+	run("Timeline GetFrame", decode_count,
+		[&] {
+			timeline.reset();
+			clips.clear();
+			timeline.reset(new Timeline(options.width, options.height, fps, sample_rate, channels, LAYOUT_STEREO));
+			for (int layer = 1; layer <= 3; layer++) {
+				clips.emplace_back(new Clip(video_path));
+				clips.back()->Layer(layer);
+				if (layer == 3) {
+					clips.back()->scale_x = Keyframe(0.5);
+					clips.back()->scale_y = Keyframe(0.5);
+					clips.back()->alpha = Keyframe(0.5);
+					clips.back()->rotation.AddPoint(1, 0.0);
+					clips.back()->rotation.AddPoint(frames, 45.0);
+				}
+				timeline->AddClip(clips.back().get());
+			}
+			timeline->Open();
+		},
+		[&](int i) { timeline->GetFrame(i + 1); });
+	timeline.reset();
+	clips.clear();
+
+	// Effects (each applied to a fresh copy of a source frame)
+	Blur blur(Keyframe(6.0), Keyframe(6.0), Keyframe(3.0), Keyframe(3.0));
+	Brightness brightness(Keyframe(0.2), Keyframe(3.0));
+	Saturation saturation(Keyframe(1.5), Keyframe(1.0), Keyframe(1.0), Keyframe(1.0));
+	std::vector<std::pair<std::string, EffectBase*>> effects = {
+		{"Effect Blur", &blur}, {"Effect Brightness", &brightness}, {"Effect Saturation", &saturation}};
+	for (auto& effect : effects) {
+		std::shared_ptr<Frame> copy;
+		run(effect.first, std::min(frames, 30), nullptr, [&](int i) {
+			copy = std::make_shared<Frame>(*source.GetFrame(i + 1));
+			effect.second->GetFrame(copy, i + 1);
+		});
+	}
+
+	// Caches
+	CacheMemory memory_cache;
+	run("CacheMemory Add", frames,
+		[&] { memory_cache.Clear(); memory_cache.SetMaxBytes(0); },
+		[&](int i) { memory_cache.Add(source.GetFrame(i + 1)); });
+	run("CacheMemory GetFrame", frames, nullptr,
+		[&](int i) { memory_cache.GetFrame((i * 7) % frames + 1); });
+
+	const std::string disk_path = options.work_path + "/cache";
+	CacheDisk disk_cache(disk_path, "PPM", 1.0, 1.0);
+	int disk_count = std::min(frames, 30);
+	run("CacheDisk Add", disk_count,
+		[&] { disk_cache.Clear(); },
+		[&](int i) { disk_cache.Add(source.GetFrame(i + 1)); });
+	run("CacheDisk GetFrame", disk_count, nullptr,
+		[&](int i) { disk_cache.GetFrame((i * 7) % disk_count + 1); });
+	disk_cache.Clear();
+
+	// Keyframe evaluation (an animated curve with a mix of interpolation types)
+	Keyframe curve;
+	for (int point = 0; point < 200; point++)
+		curve.AddPoint(point * 50 + 1, std::sin(point) * 100.0, InterpolationType(point % 3));
+	double keyframe_sum = 0.0;
+	run("Keyframe GetValue x1000", frames, nullptr, [&](int i) {
+		for (int n = 0; n < 1000; n++)
+			keyframe_sum += curve.GetValue((i * 1000 + n * 13) % 10000 + 1);
+	});
+
+	source.Close();
+	if (keyframe_sum == 0.0)
+		std::cout << std::endl; // Keeps the keyframe results in use
+
+	// Machine-readable results
+	if (!options.json_path.empty()) {
+		Json::Value root;
+		root["version"] = OPENSHOT_VERSION_FULL;
+		root["width"] = options.width;
+		root["height"] = options.height;
+		root["frames"] = options.frames;
+		root["repeat"] = options.repeat;
+		root["results"] = Json::Value(Json::arrayValue);
+		for (const Result& r : results) {
+			Json::Value item;
+			item["name"] = r.name;
+			item["count"] = Json::UInt64(r.samples.size());
+			item["ops_per_second"] = r.Throughput();
+			item["mean_ms"] = r.samples.empty() ? 0.0 : r.Total() / r.samples.size();
+			item["p50_ms"] = r.Percentile(50);
+			item["p90_ms"] = r.Percentile(90);
+			item["p99_ms"] = r.Percentile(99);
+			item["max_ms"] = r.samples.empty() ? 0.0 : r.samples.back();
+			root["results"].append(item);
+		}
+
+		std::ofstream output(options.json_path);
+		output << root.toStyledString();
+		if (!output.good()) {
+			std::cerr << "Failed to write " << options.json_path << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
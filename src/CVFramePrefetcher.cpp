@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief Source file for CVFramePrefetcher class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "CVFramePrefetcher.h"
+
+using namespace openshot;
+
+// Constructor, which starts the decoder thread
+CVFramePrefetcher::CVFramePrefetcher(std::function<cv::Mat(size_t)> read, std::vector<size_t> frame_numbers, size_t queue_size)
+: readFrame(read), frameNumbers(frame_numbers), maxQueued(std::max<size_t>(queue_size, 1)),
+  finished(false), cancelled(false), failed(false)
+{
+	decoder = std::thread(&CVFramePrefetcher::run, this);
+}
+
+// Destructor, which stops and joins the decoder thread
+CVFramePrefetcher::~CVFramePrefetcher()
+{
+	Cancel();
+	if (decoder.joinable())
+		decoder.join();
+}
+
+// Read all the frames into the queue (decoder thread)
+void CVFramePrefetcher::run()
+{
+	for (size_t frame_number : frameNumbers)
+	{
+		cv::Mat image;
+		try {
+			image = readFrame(frame_number);
+		}
+		catch (const std::exception& e) {
+			std::lock_guard<std::mutex> lck(queueMutex);
+			failed = true;
+			break;
+		}
+
+		std::unique_lock<std::mutex> lck(queueMutex);
+		queueChanged.wait(lck, [this]{ return cancelled || queue.size() < maxQueued; });
+		if (cancelled)
+			break;
+		queue.emplace_back(frame_number, image);
+		queueChanged.notify_all();
+	}
+
+	std::lock_guard<std::mutex> lck(queueMutex);
+	finished = true;
+	queueChanged.notify_all();
+}
+
+// Get the next decoded frame (waiting for it, if needed)
+bool CVFramePrefetcher::Next(size_t &frame_number, cv::Mat &image)
+{
+	std::unique_lock<std::mutex> lck(queueMutex);
+	queueChanged.wait(lck, [this]{ return finished || cancelled || !queue.empty(); });
+	if (cancelled || queue.empty())
+		return false;
+
+	frame_number = queue.front().first;
+	image = queue.front().second;
+	queue.pop_front();
+	queueChanged.notify_all();
+	return true;
+}
+
+// Stop decoding frames
+void CVFramePrefetcher::Cancel()
+{
+	std::lock_guard<std::mutex> lck(queueMutex);
+	cancelled = true;
+	queueChanged.notify_all();
+}
+
+// True if reading a frame threw an exception
+bool CVFramePrefetcher::Failed()
+{
+	std::lock_guard<std::mutex> lck(queueMutex);
+	return failed;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Header file for CVFramePrefetcher class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef OPENSHOT_CVFRAMEPREFETCHER_H
+#define OPENSHOT_CVFRAMEPREFETCHER_H
+
+#define int64 opencv_broken_int
+#define uint64 opencv_broken_uint
+#include <opencv2/core.hpp>
+#undef uint64
+#undef int64
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openshot
+{
+	/**
+	 * @brief Decode frames ahead of an OpenCV processing loop, on a separate thread.
+	 *
+	 * Frames are read (in the given order) into a bounded queue, so decoding the clip overlaps
+	 * with the processing of the previous frames. The thread is stopped and joined on destruction.
+	 *
+	 * @code
+	 * CVFramePrefetcher prefetcher([&](size_t n){ return reader->GetFrame(n)->GetImageCV(); }, frame_numbers);
+	 * size_t frame_number;
+	 * cv::Mat image;
+	 * while (prefetcher.Next(frame_number, image)) {
+	 *     // process image
+	 * }
+	 * @endcode
+	 */
+	class CVFramePrefetcher {
+	private:
+		std::function<cv::Mat(size_t)> readFrame;
+		std::vector<size_t> frameNumbers;
+		size_t maxQueued;
+
+		std::deque<std::pair<size_t, cv::Mat>> queue;
+		std::mutex queueMutex;
+		std::condition_variable queueChanged;
+		bool finished;
+		bool cancelled;
+		bool failed;
+
+		std::thread decoder;
+
+		/// Read all the frames into the queue (decoder thread)
+		void run();
+
+	public:
+		/// @brief Constructor, which starts the decoder thread
+		/// @param read Function returning the image of a frame number (called from the decoder thread)
+		/// @param frame_numbers Frame numbers to read (in order)
+		/// @param queue_size Max number of decoded frames waiting to be processed
+		CVFramePrefetcher(std::function<cv::Mat(size_t)> read, std::vector<size_t> frame_numbers, size_t queue_size=16);
+
+		/// Destructor, which stops and joins the decoder thread
+		~CVFramePrefetcher();
+
+		/// @brief Get the next decoded frame (waiting for it, if needed)
+		/// @returns false if there are no more frames
+		bool Next(size_t &frame_number, cv::Mat &image);
+
+		/// Stop decoding frames
+		void Cancel();
+
+		/// True if reading a frame threw an exception
+		bool Failed();
+	};
+}
+
+#endif
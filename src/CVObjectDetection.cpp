@@ -16,6 +16,8 @@
 #include <iostream>
 
 #include "CVObjectDetection.h"
+#include "CVFramePrefetcher.h"
+#include "ProtobufFrameFile.h"
 #include "Exceptions.h"
 
 #include "objdetectdata.pb.h"
@@ -26,7 +28,7 @@ using namespace openshot;
 using google::protobuf::util::TimeUtil;
 
 CVObjectDetection::CVObjectDetection(std::string processInfoJson, ProcessingController &processingController)
-: processingController(&processingController), processingDevice("CPU"){
+: processingController(&processingController), processingDevice("CPU"), batchSize(4), frameStride(1), decodeQueueSize(16){
     SetJson(processInfoJson);
     confThreshold = 0.5;
     nmsThreshold = 0.1;
@@ -66,64 +68,115 @@ void CVObjectDetection::detectObjectsClip(openshot::Clip &video, size_t _start,
         return;
     net = cv::dnn::readNetFromDarknet(modelConfiguration, modelWeights);
     setProcessingDevice();
+    outputNames = getOutputsNames(net);
 
-    size_t frame_number;
     if(!process_interval || end <= 1 || end-start == 0){
         // Get total number of frames in video
         start = (int)(video.Start() * video.Reader()->info.fps.ToFloat());
         end = (int)(video.End() * video.Reader()->info.fps.ToFloat());
     }
 
-    for (frame_number = start; frame_number <= end; frame_number++)
+    // Frames to run the inference on (the last frame is always included, so the interpolation covers the whole interval)
+    std::vector<size_t> frameNumbers;
+    for (size_t frame_number = start; frame_number <= end; frame_number += frameStride)
+        frameNumbers.push_back(frame_number);
+    if (!frameNumbers.empty() && frameNumbers.back() != end)
+        frameNumbers.push_back(end);
+
+    // Decode frames on a separate thread, so the clip's decoding overlaps with the network inference
+    CVFramePrefetcher prefetcher([&](size_t frame_number){
+        // Grab OpenCV Mat image
+        return video.GetFrame(frame_number)->GetImageCV();
+    }, frameNumbers, decodeQueueSize);
+
+    std::vector<cv::Mat> batchFrames;
+    std::vector<size_t> batchFrameNumbers;
+    while (true)
     {
-         // Stop the feature tracker process
+        // Stop the feature tracker process
         if(processingController->ShouldStop()){
-            return;
+            break;
         }
 
-        std::shared_ptr<openshot::Frame> f = video.GetFrame(frame_number);
+        // Collect a full batch (or the last frames of the clip)
+        batchFrames.clear(); batchFrameNumbers.clear();
+        size_t frame_number;
+        cv::Mat cvimage;
+        while (batchFrames.size() < batchSize && prefetcher.Next(frame_number, cvimage)){
+            batchFrameNumbers.push_back(frame_number);
+            batchFrames.push_back(cvimage);
+        }
 
-        // Grab OpenCV Mat image
-        cv::Mat cvimage = f->GetImageCV();
+        if (batchFrames.empty())
+            break;
 
-        DetectObjects(cvimage, frame_number);
+        DetectObjectsBatch(batchFrames, batchFrameNumbers);
 
         // Update progress
-        processingController->SetProgress(uint(100*(frame_number-start)/(end-start)));
+        processingController->SetProgress(uint(100*(batchFrameNumbers.back()-start)/std::max<size_t>(end-start, 1)));
+    }
+
+    // Stop the decoder thread
+    prefetcher.Cancel();
+    if(prefetcher.Failed()){
+        processingController->SetError(true, "Failed to read the clip frames");
+    }
 
+    if(!processingController->ShouldStop() && frameStride > 1){
+        interpolateSkippedFrames();
     }
 }
 
 void CVObjectDetection::DetectObjects(const cv::Mat &frame, size_t frameId){
+    DetectObjectsBatch(std::vector<cv::Mat>{frame}, std::vector<size_t>{frameId});
+}
+
+void CVObjectDetection::DetectObjectsBatch(const std::vector<cv::Mat> &frames, const std::vector<size_t> &frameIds){
     // Get frame as OpenCV Mat
     cv::Mat blob;
 
-    // Create a 4D blob from the frame.
+    // Create a 4D blob from the frames.
     int inpWidth, inpHeight;
     inpWidth = inpHeight = 416;
 
-    cv::dnn::blobFromImage(frame, blob, 1/255.0, cv::Size(inpWidth, inpHeight), cv::Scalar(0,0,0), true, false);
+    cv::dnn::blobFromImages(frames, blob, 1/255.0, cv::Size(inpWidth, inpHeight), cv::Scalar(0,0,0), true, false);
 
     //Sets the input to the network
     net.setInput(blob);
 
     // Runs the forward pass to get output of the output layers
+    if (outputNames.empty())
+        outputNames = getOutputsNames(net);
     std::vector<cv::Mat> outs;
-    net.forward(outs, getOutputsNames(net));
+    net.forward(outs, outputNames);
 
-    // Remove the bounding boxes with low confidence
-    postprocess(frame.size(), outs, frameId);
+    // Collect the candidate boxes of each frame in parallel
+    std::vector<CVDetectionCandidates> candidates(frames.size());
+    #pragma omp parallel for
+    for (int b = 0; b < (int)frames.size(); b++)
+    {
+        // Batched outputs are 3D (batch, rows, cols), split them into one 2D output per frame
+        std::vector<cv::Mat> frameOuts(outs.size());
+        for (size_t i = 0; i < outs.size(); ++i){
+            if (outs[i].dims == 3)
+                frameOuts[i] = cv::Mat(outs[i].size[1], outs[i].size[2], CV_32F, (void*)outs[i].ptr<float>(b));
+            else
+                frameOuts[i] = outs[i];
+        }
+        candidates[b] = getCandidates(frames[b].size(), frameOuts, frameIds[b]);
+    }
 
+    // SORT is stateful, so the boxes must be tracked in frame order
+    for (auto &frameCandidates : candidates)
+        postprocess(frameCandidates);
 }
 
-
-// Remove the bounding boxes with low confidence using non-maxima suppression
-void CVObjectDetection::postprocess(const cv::Size &frameDims, const std::vector<cv::Mat>& outs, size_t frameId)
+// Collect the boxes with high confidence from the network output of a single frame
+CVDetectionCandidates CVObjectDetection::getCandidates(const cv::Size &frameDims, const std::vector<cv::Mat>& outs, size_t frameId) const
 {
-    std::vector<int> classIds;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
-    std::vector<int> objectIds;
+    CVDetectionCandidates candidates;
+    candidates.frameId = frameId;
+    candidates.frameDims = frameDims;
 
     for (size_t i = 0; i < outs.size(); ++i)
     {
@@ -147,9 +200,9 @@ void CVObjectDetection::postprocess(const cv::Size &frameDims, const std::vector
                 int left = centerX - width / 2;
                 int top = centerY - height / 2;
 
-                classIds.push_back(classIdPoint.x);
-                confidences.push_back((float)confidence);
-                boxes.push_back(cv::Rect(left, top, width, height));
+                candidates.classIds.push_back(classIdPoint.x);
+                candidates.confidences.push_back((float)confidence);
+                candidates.boxes.push_back(cv::Rect(left, top, width, height));
             }
         }
     }
@@ -157,7 +210,20 @@ void CVObjectDetection::postprocess(const cv::Size &frameDims, const std::vector
     // Perform non maximum suppression to eliminate redundant overlapping boxes with
     // lower confidences
     std::vector<int> indices;
-    cv::dnn::NMSBoxes(boxes, confidences, confThreshold, nmsThreshold, indices);
+    cv::dnn::NMSBoxes(candidates.boxes, candidates.confidences, confThreshold, nmsThreshold, indices);
+
+    return candidates;
+}
+
+// Track the candidate boxes with SORT and remove the duplicated ones
+void CVObjectDetection::postprocess(CVDetectionCandidates &candidates)
+{
+    const cv::Size &frameDims = candidates.frameDims;
+    size_t frameId = candidates.frameId;
+    std::vector<int> classIds = candidates.classIds;
+    std::vector<float> confidences = candidates.confidences;
+    std::vector<cv::Rect> boxes = candidates.boxes;
+    std::vector<int> objectIds;
 
     // Pass boxes to SORT algorithm
     std::vector<cv::Rect> sortBoxes;
@@ -245,6 +311,55 @@ void CVObjectDetection::postprocess(const cv::Size &frameDims, const std::vector
     detectionsData[frameId] = CVDetectionData(classIds, confidences, normalized_boxes, frameId, objectIds);
 }
 
+// Fill the frames skipped by frameStride, interpolating the boxes of the surrounding detected frames
+void CVObjectDetection::interpolateSkippedFrames()
+{
+    if (detectionsData.size() < 2)
+        return;
+
+    // Only the frames that went through the network (copied, since new frames are added while iterating)
+    std::vector<CVDetectionData> detected;
+    for (const auto &it : detectionsData)
+        detected.push_back(it.second);
+
+    for (size_t k = 0; k + 1 < detected.size(); k++)
+    {
+        const CVDetectionData &prev = detected[k];
+        const CVDetectionData &next = detected[k+1];
+
+        for (size_t frameId = prev.frameId + 1; frameId < next.frameId; frameId++)
+        {
+            float t = float(frameId - prev.frameId) / float(next.frameId - prev.frameId);
+
+            std::vector<int> classIds;
+            std::vector<float> confidences;
+            std::vector<cv::Rect_<float>> boxes;
+            std::vector<int> objectIds;
+
+            // Interpolate the objects found in both detected frames
+            for (size_t i = 0; i < prev.objectIds.size(); i++){
+                for (size_t j = 0; j < next.objectIds.size(); j++){
+                    if (prev.objectIds[i] != next.objectIds[j])
+                        continue;
+
+                    const cv::Rect_<float> &a = prev.boxes[i];
+                    const cv::Rect_<float> &b = next.boxes[j];
+                    boxes.push_back(cv::Rect_<float>(a.x + (b.x - a.x) * t,
+                                                     a.y + (b.y - a.y) * t,
+                                                     a.width + (b.width - a.width) * t,
+                                                     a.height + (b.height - a.height) * t));
+                    classIds.push_back(prev.classIds[i]);
+                    confidences.push_back(prev.confidences[i] + (next.confidences[j] - prev.confidences[i]) * t);
+                    objectIds.push_back(prev.objectIds[i]);
+                    break;
+                }
+            }
+
+            detectionsData[frameId] = CVDetectionData(classIds, confidences, boxes, frameId, objectIds);
+        }
+    }
+}
+
 // Compute IOU between 2 boxes
 bool CVObjectDetection::iou(cv::Rect pred_box, cv::Rect sort_box){
     // Determine the (x, y)-coordinates of the intersection rectangle
@@ -299,7 +414,7 @@ CVDetectionData CVObjectDetection::GetDetectionData(size_t frameId){
 }
 
 bool CVObjectDetection::SaveObjDetectedData(){
-    // Create tracker message
+    // Create object detection message, with the class names and timestamp (frames are written one by one)
     pb_objdetect::ObjDetect objMessage;
 
     //Save class names in protobuf message
@@ -308,28 +423,26 @@ bool CVObjectDetection::SaveObjDetectedData(){
         className->assign(classNames.at(i));
     }
 
-    // Iterate over all frames data and save in protobuf message
-    for(std::map<size_t,CVDetectionData>::iterator it=detectionsData.begin(); it!=detectionsData.end(); ++it){
-        CVDetectionData dData = it->second;
-        pb_objdetect::Frame* pbFrameData;
-        AddFrameDataToProto(objMessage.add_frame(), dData);
-    }
-
     // Add timestamp
     *objMessage.mutable_last_updated() = TimeUtil::SecondsToTimestamp(time(NULL));
 
     {
-        // Write the new message to disk.
-        std::fstream output(protobuf_data_path, ios::out | ios::trunc | ios::binary);
-        if (!objMessage.SerializeToOstream(&output)) {
+        ProtobufFrameWriter writer(protobuf_data_path, objMessage);
+
+        // Iterate over all frames data and save them in the frame-indexed file
+        for(std::map<size_t,CVDetectionData>::iterator it=detectionsData.begin(); it!=detectionsData.end(); ++it){
+            pb_objdetect::Frame pbFrameData;
+            AddFrameDataToProto(&pbFrameData, it->second);
+            writer.AddFrame(it->first, pbFrameData);
+        }
+
+        // Write the frame index to disk.
+        if (!writer.Close()) {
         cerr << "Failed to write protobuf message." << endl;
         return false;
         }
     }
 
-    // Delete all global objects allocated by libprotobuf.
-    google::protobuf::ShutdownProtobufLibrary();
-
     return true;
 
 }
@@ -374,7 +487,7 @@ void CVObjectDetection::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void CVObjectDetection::SetJsonValue(const Json::Value root) {
+void CVObjectDetection::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["protobuf_data_path"].isNull()){
@@ -401,6 +514,12 @@ void CVObjectDetection::SetJsonValue(const Json::Value root) {
         }
 
 	}
+    if (!root["batch-size"].isNull()){
+        batchSize = std::max(1, root["batch-size"].asInt());
+    }
+    if (!root["frame-stride"].isNull()){
+        frameStride = std::max(1, root["frame-stride"].asInt());
+    }
     if (!root["class-names"].isNull()){
 		classesFile = (root["class-names"].asString());
 
@@ -424,28 +543,11 @@ bool CVObjectDetection::_LoadObjDetectdData(){
     // Create tracker message
     pb_objdetect::ObjDetect objMessage;
 
-    {
-        // Read the existing tracker message.
-        fstream input(protobuf_data_path, ios::in | ios::binary);
-        if (!objMessage.ParseFromIstream(&input)) {
-            cerr << "Failed to parse protobuf message." << endl;
-            return false;
-        }
-    }
-
     // Make sure classNames and detectionsData are empty
     classNames.clear(); detectionsData.clear();
 
-    // Get all classes names and assign a color to them
-    for(int i = 0; i < objMessage.classnames_size(); i++){
-        classNames.push_back(objMessage.classnames(i));
-    }
-
-    // Iterate over all frames of the saved message
-    for (size_t i = 0; i < objMessage.frame_size(); i++) {
-        // Create protobuf message reader
-        const pb_objdetect::Frame& pbFrameData = objMessage.frame(i);
-
+    // Iterate over all frames of the saved data
+    bool loaded = ReadProtobufFrames(protobuf_data_path, objMessage, [&](const pb_objdetect::Frame& pbFrameData){
         // Get frame Id
         size_t id = pbFrameData.id();
 
@@ -476,10 +578,16 @@ bool CVObjectDetection::_LoadObjDetectdData(){
 
         // Assign data to object detector map
         detectionsData[id] = CVDetectionData(classIds, confidences, boxes, id, objectIds);
+    });
+    if (!loaded) {
+        cerr << "Failed to parse protobuf message." << endl;
+        return false;
     }
 
-    // Delete all global objects allocated by libprotobuf.
-    google::protobuf::ShutdownProtobufLibrary();
+    // Get all classes names
+    for(int i = 0; i < objMessage.classnames_size(); i++){
+        classNames.push_back(objMessage.classnames(i));
+    }
 
     return true;
 }
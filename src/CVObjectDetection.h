@@ -56,6 +56,15 @@ namespace openshot
         std::vector<int> objectIds;
     };
 
+    // Raw (pre-SORT) detections of a single frame, as returned by the network
+    struct CVDetectionCandidates{
+        size_t frameId;
+        cv::Size frameDims;
+        std::vector<int> classIds;
+        std::vector<float> confidences;
+        std::vector<cv::Rect> boxes;
+    };
+
     /**
      * @brief This class runs trought a clip to detect objects and returns the bounding boxes and its properties.
      *
@@ -82,6 +91,16 @@ namespace openshot
         size_t start;
         size_t end;
 
+        /// Number of frames passed to the network on each forward pass
+        size_t batchSize;
+        /// Run inference on every Nth frame only (boxes of the skipped frames are interpolated)
+        size_t frameStride;
+        /// Max number of decoded frames waiting for inference
+        size_t decodeQueueSize;
+
+        /// Cached names of the network output layers
+        std::vector<cv::String> outputNames;
+
         bool error = false;
 
         /// Will handle a Thread safely comutication between ClipProcessingJobs and the processing effect classes
@@ -92,10 +111,19 @@ namespace openshot
         // Detect onbects on a single frame
         void DetectObjects(const cv::Mat &frame, size_t frame_number);
 
+        // Detect objects on a batch of frames (one forward pass for the whole batch)
+        void DetectObjectsBatch(const std::vector<cv::Mat> &frames, const std::vector<size_t> &frame_numbers);
+
         bool iou(cv::Rect pred_box, cv::Rect sort_box);
 
-        // Remove the bounding boxes with low confidence using non-maxima suppression
-        void postprocess(const cv::Size &frameDims, const std::vector<cv::Mat>& out, size_t frame_number);
+        // Collect the boxes with high confidence from the network output of a single frame (thread safe)
+        CVDetectionCandidates getCandidates(const cv::Size &frameDims, const std::vector<cv::Mat>& out, size_t frame_number) const;
+
+        // Remove the bounding boxes with low confidence using non-maxima suppression, and track them with SORT
+        void postprocess(CVDetectionCandidates &candidates);
+
+        // Fill the frames skipped by frameStride, interpolating the boxes of the surrounding detected frames
+        void interpolateSkippedFrames();
 
         // Get the names of the output layers
         std::vector<cv::String> getOutputsNames(const cv::dnn::Net& net);
@@ -119,7 +147,7 @@ namespace openshot
 
         // Get and Set JSON methods
         void SetJson(const std::string value); ///< Load JSON string into this object
-        void SetJsonValue(const Json::Value root); ///< Load Json::Value into this object
+        void SetJsonValue(const Json::Value& root); ///< Load Json::Value into this object
 
         // Load protobuf file (ONLY FOR MAKE TEST)
         bool _LoadObjDetectdData();
@@ -17,6 +17,7 @@
 
 #include "CVStabilization.h"
 #include "Exceptions.h"
+#include "ProtobufFrameFile.h"
 
 #include "stabilizedata.pb.h"
 #include <google/protobuf/util/time_util.h>
@@ -266,31 +267,28 @@ std::map<size_t,TransformParam> CVStabilization::GenNewCamPosition(std::map <siz
 
 // Save stabilization data to protobuf file
 bool CVStabilization::SaveStabilizedData(){
-    using std::ios;
-
-    // Create stabilization message
+    // Create stabilization message, with the timestamp (frames are written one by one)
     pb_stabilize::Stabilization stabilizationMessage;
+    *stabilizationMessage.mutable_last_updated() = TimeUtil::SecondsToTimestamp(time(NULL));
+
+    ProtobufFrameWriter writer(protobuf_data_path, stabilizationMessage);
 
     std::map<size_t,CamTrajectory>::iterator trajData = trajectoryData.begin();
     std::map<size_t,TransformParam>::iterator transData = transformationData.begin();
 
-    // Iterate over all frames data and save in protobuf message
+    // Iterate over all frames data and save them in the frame-indexed file
     for(; trajData != trajectoryData.end(); ++trajData, ++transData){
-        AddFrameDataToProto(stabilizationMessage.add_frame(), trajData->second, transData->second, trajData->first);
+        pb_stabilize::Frame pbFrameData;
+        AddFrameDataToProto(&pbFrameData, trajData->second, transData->second, trajData->first);
+        writer.AddFrame(trajData->first, pbFrameData);
     }
-    // Add timestamp
-    *stabilizationMessage.mutable_last_updated() = TimeUtil::SecondsToTimestamp(time(NULL));
 
-    // Write the new message to disk.
-    std::fstream output(protobuf_data_path, ios::out | ios::trunc | ios::binary);
-    if (!stabilizationMessage.SerializeToOstream(&output)) {
+    // Write the frame index to disk.
+    if (!writer.Close()) {
         std::cerr << "Failed to write protobuf message." << std::endl;
         return false;
     }
 
-    // Delete all global objects allocated by libprotobuf.
-    google::protobuf::ShutdownProtobufLibrary();
-
     return true;
 }
 
@@ -353,7 +351,7 @@ void CVStabilization::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void CVStabilization::SetJsonValue(const Json::Value root) {
+void CVStabilization::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["protobuf_data_path"].isNull()){
@@ -372,24 +370,15 @@ void CVStabilization::SetJsonValue(const Json::Value root) {
 
 // Load protobuf data file
 bool CVStabilization::_LoadStabilizedData(){
-    using std::ios;
     // Create stabilization message
     pb_stabilize::Stabilization stabilizationMessage;
-    // Read the existing tracker message.
-    std::fstream input(protobuf_data_path, ios::in | ios::binary);
-    if (!stabilizationMessage.ParseFromIstream(&input)) {
-        std::cerr << "Failed to parse protobuf message." << std::endl;
-        return false;
-    }
 
     // Make sure the data maps are empty
     transformationData.clear();
     trajectoryData.clear();
 
-    // Iterate over all frames of the saved message and assign to the data maps
-    for (size_t i = 0; i < stabilizationMessage.frame_size(); i++) {
-        const pb_stabilize::Frame& pbFrameData = stabilizationMessage.frame(i);
-
+    // Iterate over all frames of the saved data and assign to the data maps
+    bool loaded = ReadProtobufFrames(protobuf_data_path, stabilizationMessage, [&](const pb_stabilize::Frame& pbFrameData){
         // Load frame number
         size_t id = pbFrameData.id();
 
@@ -408,10 +397,11 @@ bool CVStabilization::_LoadStabilizedData(){
 
         // Assing data to transformation map
         transformationData[id] = TransformParam(dx,dy,da);
+    });
+    if (!loaded) {
+        std::cerr << "Failed to parse protobuf message." << std::endl;
+        return false;
     }
 
-    // Delete all global objects allocated by libprotobuf.
-    google::protobuf::ShutdownProtobufLibrary();
-
     return true;
 }
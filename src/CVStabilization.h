@@ -125,7 +125,7 @@ class CVStabilization {
 
     // Get and Set JSON methods
     void SetJson(const std::string value); ///< Load JSON string into this object
-    void SetJsonValue(const Json::Value root); ///< Load Json::Value into this object
+    void SetJsonValue(const Json::Value& root); ///< Load Json::Value into this object
 
     // Load protobuf data file (ONLY FOR MAKE TEST)
     bool _LoadStabilizedData();
@@ -14,11 +14,15 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <thread>
 
 #include <google/protobuf/util/time_util.h>
 
 #include "OpenCVUtilities.h"
 #include "CVTracker.h"
+#include "CVFramePrefetcher.h"
+#include "FFmpegReader.h"
+#include "ProtobufFrameFile.h"
 #include "trackerdata.pb.h"
 #include "Exceptions.h"
 
@@ -27,7 +31,8 @@ using google::protobuf::util::TimeUtil;
 
 // Constructor
 CVTracker::CVTracker(std::string processInfoJson, ProcessingController &processingController)
-: processingController(&processingController), json_interval(false){
+: processingController(&processingController), json_interval(false),
+  analysisHeight(0), segmentLength(1800), segmentOverlap(15){
     SetJson(processInfoJson);
     start = 1;
     end = 1;
@@ -77,29 +82,59 @@ void CVTracker::trackClip(openshot::Clip& video, size_t _start, size_t _end, boo
     }
 
     processingController->SetError(false, "");
-    bool trackerInit = false;
 
-    size_t frame;
+    // Track the source frames: the clip's effects and keyframes don't matter to the tracker
+    ReaderBase* reader = video.Reader();
+
+    // Long clips are split into segments, each one decoded by its own reader
+    if(segmentLength > 0 && reader->Name() == "FFmpegReader" && end >= start + 2 * segmentLength){
+        trackSegments(reader->JsonValue()["path"].asString());
+        return;
+    }
+
+    std::atomic<size_t> frames_done(0);
+    trackInterval(reader, start, end, bbox, frames_done, end - start + 1);
+}
+
+// Read a source frame at the analysis resolution
+cv::Mat CVTracker::readFrame(openshot::ReaderBase* reader, size_t frameId){
+
+    cv::Mat cvimage = reader->GetFrame(frameId)->GetImageCV();
+
+    // Boxes are stored normalized, so tracking on smaller frames doesn't change the results' scale
+    if(analysisHeight > 0 && cvimage.rows > analysisHeight){
+        int width = std::max(1, (int)round(cvimage.cols * analysisHeight / (double)cvimage.rows));
+        cv::resize(cvimage, cvimage, cv::Size(width, analysisHeight), 0, 0, cv::INTER_AREA);
+    }
+    return cvimage;
+}
+
+// Track the object through [first, last], starting from a normalized bounding box
+void CVTracker::trackInterval(openshot::ReaderBase* reader, size_t first, size_t last, cv::Rect2d initial_box,
+                              std::atomic<size_t>& frames_done, size_t total_frames){
+
+    std::vector<size_t> frameNumbers;
+    for (size_t frame = first; frame <= last; frame++)
+        frameNumbers.push_back(frame);
+
+    // Decode the next frames while the current one is being tracked
+    CVFramePrefetcher prefetcher([&](size_t frame_number){ return readFrame(reader, frame_number); }, frameNumbers);
+
+    bool trackerInit = false;
+    size_t frame_number;
+    cv::Mat cvimage;
     // Loop through video
-    for (frame = start; frame <= end; frame++)
+    while (prefetcher.Next(frame_number, cvimage))
     {
-
         // Stop the feature tracker process
         if(processingController->ShouldStop()){
             return;
         }
 
-        size_t frame_number = frame;
-        // Get current frame
-        std::shared_ptr<openshot::Frame> f = video.GetFrame(frame_number);
-
-        // Grab OpenCV Mat image
-        cv::Mat cvimage = f->GetImageCV();
-
-        if(frame == start){
+        if(frame_number == first){
             // Take the normalized inital bounding box and multiply to the current video shape
-            bbox = cv::Rect2d(int(bbox.x*cvimage.cols), int(bbox.y*cvimage.rows),
-                              int(bbox.width*cvimage.cols), int(bbox.height*cvimage.rows));
+            bbox = cv::Rect2d(int(initial_box.x*cvimage.cols), int(initial_box.y*cvimage.rows),
+                              int(initial_box.width*cvimage.cols), int(initial_box.height*cvimage.rows));
         }
 
         // Pass the first frame to initialize the tracker
@@ -113,16 +148,162 @@ void CVTracker::trackClip(openshot::Clip& video, size_t _start, size_t _end, boo
         else{
             // Update the object tracker according to frame
             trackerInit = trackFrame(cvimage, frame_number);
+        }
+        // Update progress
+        processingController->SetProgress(uint(std::min<size_t>(100, 100*(++frames_done)/total_frames)));
+    }
 
-            // Draw box on image
-            FrameData fd = GetTrackedData(frame_number);
+    if(prefetcher.Failed()){
+        processingController->SetError(true, "Failed to read the clip frames");
+    }
+}
+
+// Intersection over union of two tracked boxes
+static float boxIoU(const FrameData& a, const FrameData& b){
+    float w = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    float h = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    if(w <= 0 || h <= 0)
+        return 0;
+    float intersection = w * h;
+    float area_a = (a.x2 - a.x1) * (a.y2 - a.y1);
+    float area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+    return intersection / (area_a + area_b - intersection);
+}
+
+// Track a long clip in segments running in parallel, and stitch them by IoU
+void CVTracker::trackSegments(const std::string& path){
+
+    // First frame owned by each segment. Segments after the first also track the
+    // segmentOverlap frames before it, which are compared with the previous segment
+    std::vector<size_t> boundaries;
+    for (size_t frame = start; frame <= end; frame += segmentLength)
+        boundaries.push_back(frame);
+    // Don't leave a last segment too short to be stitched
+    if(boundaries.size() > 1 && end - boundaries.back() + 1 <= segmentOverlap)
+        boundaries.pop_back();
+
+    size_t count = boundaries.size();
+    auto segmentFirst = [&](size_t k){ return k == 0 ? start : std::max(start, boundaries[k] - segmentOverlap); };
+    auto segmentLast = [&](size_t k){ return k + 1 < count ? boundaries[k+1] - 1 : end; };
+
+    // Each segment is tracked by a copy of this tracker
+    std::vector<CVTracker> segments(count, *this);
+    std::atomic<size_t> frames_done(0);
+    size_t total_frames = end - start + 1 + (count - 1) * segmentOverlap;
+    std::atomic<bool> failed(false);
+
+    // Appearance of the object on the first frame, to find it again where each segment starts
+    cv::Mat object_template;
+    try{
+        FFmpegReader reader(path, false);
+        reader.Open();
+        cv::Mat first_image = readFrame(&reader, start);
+        cv::Rect roi = cv::Rect(int(bbox.x*first_image.cols), int(bbox.y*first_image.rows),
+                                int(bbox.width*first_image.cols), int(bbox.height*first_image.rows))
+                       & cv::Rect(0, 0, first_image.cols, first_image.rows);
+        if(roi.area() > 0)
+            object_template = first_image(roi).clone();
+        reader.Close();
+    }
+    catch(const std::exception& e){
+        processingController->SetError(true, "Failed to read the clip frames");
+        return;
+    }
 
+    std::atomic<size_t> next_segment(0);
+    auto worker = [&](){
+        try{
+            // Every worker decodes with its own reader, so the segments don't fight over seeks
+            FFmpegReader reader(path, false);
+            reader.Open();
+            for (size_t k = next_segment++; k < count; k = next_segment++){
+                if(processingController->ShouldStop())
+                    break;
+                cv::Rect2d initial_box = bbox;
+                if(k > 0)
+                    initial_box = redetect(object_template, readFrame(&reader, segmentFirst(k)));
+                segments[k].trackInterval(&reader, segmentFirst(k), segmentLast(k), initial_box, frames_done, total_frames);
+            }
+            reader.Close();
+        }
+        catch(const std::exception& e){
+            failed = true;
+        }
+    };
+
+    unsigned int worker_count = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < worker_count; i++)
+        workers.emplace_back(worker);
+    for (auto& w : workers)
+        w.join();
+
+    if(failed){
+        processingController->SetError(true, "Failed to read the clip frames");
+        return;
+    }
+
+    // Stitch the segments in order
+    trackedDataById = segments[0].trackedDataById;
+    for (size_t k = 1; k < count; k++){
+        if(processingController->ShouldStop())
+            return;
+
+        // Compare both segments on the frames they have in common
+        const std::map<size_t, FrameData>& data = segments[k].trackedDataById;
+        float iou_sum = 0;
+        size_t iou_count = 0;
+        for (size_t frame = segmentFirst(k); frame < boundaries[k]; frame++){
+            auto previous = trackedDataById.find(frame);
+            auto current = data.find(frame);
+            if(previous != trackedDataById.end() && current != data.end()){
+                iou_sum += boxIoU(previous->second, current->second);
+                iou_count++;
+            }
+        }
+
+        if(iou_count > 0 && iou_sum / iou_count >= 0.5){
+            for (auto it = data.lower_bound(boundaries[k]); it != data.end(); ++it)
+                trackedDataById[it->first] = it->second;
+            continue;
+        }
+
+        // The segment locked on something else: carry on from the previous segment's last box instead
+        try{
+            FFmpegReader reader(path, false);
+            reader.Open();
+            const FrameData& last_box = trackedDataById[boundaries[k] - 1];
+            CVTracker continuation(segments[k]);
+            continuation.trackedDataById.clear();
+            continuation.trackInterval(&reader, boundaries[k] - 1, segmentLast(k),
+                                       cv::Rect2d(last_box.x1, last_box.y1, last_box.x2 - last_box.x1, last_box.y2 - last_box.y1),
+                                       frames_done, total_frames);
+            reader.Close();
+            for (auto it = continuation.trackedDataById.lower_bound(boundaries[k]); it != continuation.trackedDataById.end(); ++it)
+                trackedDataById[it->first] = it->second;
+        }
+        catch(const std::exception& e){
+            processingController->SetError(true, "Failed to read the clip frames");
+            return;
         }
-        // Update progress
-        processingController->SetProgress(uint(100*(frame_number-start)/(end-start)));
     }
 }
 
+// Find the object on a frame (by its appearance on the first frame), as a normalized bounding box
+cv::Rect2d CVTracker::redetect(const cv::Mat &object_template, const cv::Mat &frame){
+
+    if(object_template.empty() || object_template.cols > frame.cols || object_template.rows > frame.rows)
+        return bbox;
+
+    cv::Mat result;
+    cv::matchTemplate(frame, object_template, result, cv::TM_CCOEFF_NORMED);
+    cv::Point max_loc;
+    cv::minMaxLoc(result, nullptr, nullptr, nullptr, &max_loc);
+
+    return cv::Rect2d(max_loc.x / (double)frame.cols, max_loc.y / (double)frame.rows,
+                      object_template.cols / (double)frame.cols, object_template.rows / (double)frame.rows);
+}
+
 // Initialize the tracker
 bool CVTracker::initTracker(cv::Mat &frame, size_t frameId){
 
@@ -203,32 +384,26 @@ cv::Rect2d CVTracker::filter_box_jitter(size_t frameId){
 }
 
 bool CVTracker::SaveTrackedData(){
-    using std::ios;
-
-    // Create tracker message
+    // Create tracker message, with the timestamp (frames are written one by one)
     pb_tracker::Tracker trackerMessage;
-
-    // Iterate over all frames data and save in protobuf message
-    for(std::map<size_t,FrameData>::iterator it=trackedDataById.begin(); it!=trackedDataById.end(); ++it){
-        FrameData fData = it->second;
-        pb_tracker::Frame* pbFrameData;
-        AddFrameDataToProto(trackerMessage.add_frame(), fData);
-    }
-
-    // Add timestamp
     *trackerMessage.mutable_last_updated() = TimeUtil::SecondsToTimestamp(time(NULL));
 
     {
-        // Write the new message to disk.
-        std::fstream output(protobuf_data_path, ios::out | ios::trunc | ios::binary);
-        if (!trackerMessage.SerializeToOstream(&output)) {
-        std::cerr << "Failed to write protobuf message." << std::endl;
-        return false;
+        ProtobufFrameWriter writer(protobuf_data_path, trackerMessage);
+
+        // Iterate over all frames data and save them in the frame-indexed file
+        for(std::map<size_t,FrameData>::iterator it=trackedDataById.begin(); it!=trackedDataById.end(); ++it){
+            pb_tracker::Frame pbFrameData;
+            AddFrameDataToProto(&pbFrameData, it->second);
+            writer.AddFrame(it->first, pbFrameData);
         }
-    }
 
-    // Delete all global objects allocated by libprotobuf.
-    google::protobuf::ShutdownProtobufLibrary();
+        // Write the frame index to disk.
+        if (!writer.Close()) {
+            std::cerr << "Failed to write protobuf message." << std::endl;
+            return false;
+        }
+    }
 
     return true;
 
@@ -281,7 +456,7 @@ void CVTracker::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void CVTracker::SetJsonValue(const Json::Value root) {
+void CVTracker::SetJsonValue(const Json::Value& root) {
 
     // Set data from Json (if key is found)
     if (!root["protobuf_data_path"].isNull()){
@@ -290,6 +465,15 @@ void CVTracker::SetJsonValue(const Json::Value root) {
     if (!root["tracker-type"].isNull()){
         trackerType = (root["tracker-type"].asString());
     }
+    if (!root["analysis-height"].isNull()){
+        analysisHeight = std::max(0, root["analysis-height"].asInt());
+    }
+    if (!root["segment-length"].isNull()){
+        segmentLength = root["segment-length"].asUInt64();
+    }
+    if (!root["segment-overlap"].isNull()){
+        segmentOverlap = root["segment-overlap"].asUInt64();
+    }
 
     if (!root["region"].isNull()){
         double x = root["region"]["normalized_x"].asDouble();
@@ -324,27 +508,14 @@ void CVTracker::SetJsonValue(const Json::Value root) {
 
 // Load protobuf data file
 bool CVTracker::_LoadTrackedData(){
-    using std::ios;
-
     // Create tracker message
     pb_tracker::Tracker trackerMessage;
 
-    {
-        // Read the existing tracker message.
-        std::fstream input(protobuf_data_path, ios::in | ios::binary);
-        if (!trackerMessage.ParseFromIstream(&input)) {
-            std::cerr << "Failed to parse protobuf message." << std::endl;
-            return false;
-        }
-    }
-
     // Make sure the trackedData is empty
     trackedDataById.clear();
 
-    // Iterate over all frames of the saved message
-    for (size_t i = 0; i < trackerMessage.frame_size(); i++) {
-        const pb_tracker::Frame& pbFrameData = trackerMessage.frame(i);
-
+    // Iterate over all frames of the saved data
+    bool loaded = ReadProtobufFrames(protobuf_data_path, trackerMessage, [&](const pb_tracker::Frame& pbFrameData){
         // Load frame and rotation data
         size_t id = pbFrameData.id();
         float rotation = pbFrameData.rotation();
@@ -358,10 +529,11 @@ bool CVTracker::_LoadTrackedData(){
 
         // Assign data to tracker map
         trackedDataById[id] = FrameData(id, rotation, x1, y1, x2, y2);
+    });
+    if (!loaded) {
+        std::cerr << "Failed to parse protobuf message." << std::endl;
+        return false;
     }
 
-    // Delete all global objects allocated by libprotobuf.
-    google::protobuf::ShutdownProtobufLibrary();
-
     return true;
 }
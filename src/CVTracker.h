@@ -33,6 +33,8 @@
 
 #include "sort_filter/sort.hpp"
 
+#include <atomic>
+
 // Forward decl
 namespace pb_tracker {
     class Frame;
@@ -92,6 +94,10 @@ namespace openshot
 			size_t start;
 			size_t end;
 
+			int analysisHeight; // Height of the frames used for tracking (0 = source height)
+			size_t segmentLength; // Frames per segment, when tracking long clips in parallel (0 = never split)
+			size_t segmentOverlap; // Frames tracked by two consecutive segments, used to stitch them
+
 			bool error = false;
 
 			// Initialize the tracker
@@ -100,6 +106,19 @@ namespace openshot
 			// Update the object tracker according to frame
 			bool trackFrame(cv::Mat &frame, size_t frameId);
 
+			// Read a source frame (without the clip's effects and keyframes) at the analysis resolution
+			cv::Mat readFrame(openshot::ReaderBase* reader, size_t frameId);
+
+			// Track the object through [first, last], starting from a normalized bounding box
+			void trackInterval(openshot::ReaderBase* reader, size_t first, size_t last, cv::Rect2d initial_box,
+							   std::atomic<size_t>& frames_done, size_t total_frames);
+
+			// Track a long clip in segments running in parallel, and stitch them by IoU
+			void trackSegments(const std::string& path);
+
+			// Find the object on a frame (by its appearance on the first frame), as a normalized bounding box
+			cv::Rect2d redetect(const cv::Mat &object_template, const cv::Mat &frame);
+
 		public:
 
 			// Constructor
@@ -110,7 +129,8 @@ namespace openshot
 
 			/// Track object in the hole clip or in a given interval
 			///
-			/// If start, end and process_interval are passed as argument, clip will be processed in [start,end)
+			/// If start, end and process_interval are passed as argument, clip will be processed in [start,end).
+			/// Long clips are split into segments, tracked in parallel with their own decoders.
 			void trackClip(openshot::Clip& video, size_t _start=0, size_t _end=0, bool process_interval=false);
 
 			/// Filter current bounding box jitter
@@ -127,7 +147,7 @@ namespace openshot
 
 			// Get and Set JSON methods
 			void SetJson(const std::string value); ///< Load JSON string into this object
-			void SetJsonValue(const Json::Value root); ///< Load Json::Value into this object
+			void SetJsonValue(const Json::Value& root); ///< Load Json::Value into this object
 
 			// Load protobuf file (ONLY FOR MAKE TEST)
 			bool _LoadTrackedData();
@@ -112,7 +112,7 @@ Json::Value CacheBase::JsonValue() {
 }
 
 // Load Json::Value into this object
-void CacheBase::SetJsonValue(const Json::Value root) {
+void CacheBase::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["max_bytes"].isNull())
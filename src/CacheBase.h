@@ -112,7 +112,7 @@ namespace openshot {
 		virtual std::string Json() = 0; ///< Generate JSON string of this object
 		virtual void SetJson(const std::string value) = 0; ///< Load JSON string into this object
 		virtual Json::Value JsonValue() = 0; ///< Generate Json::Value for this object
-		virtual void SetJsonValue(const Json::Value root) = 0; ///< Load Json::Value into this object
+		virtual void SetJsonValue(const Json::Value& root) = 0; ///< Load Json::Value into this object
 		virtual ~CacheBase() = default;
 
 	};
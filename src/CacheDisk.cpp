@@ -464,7 +464,7 @@ void CacheDisk::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void CacheDisk::SetJsonValue(const Json::Value root) {
+void CacheDisk::SetJsonValue(const Json::Value& root) {
 
 	// Close timeline before we do anything (this also removes all open and closing clips)
 	Clear();
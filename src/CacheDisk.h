@@ -106,7 +106,7 @@ namespace openshot {
 		std::string Json(); ///< Generate JSON string of this object
 		void SetJson(const std::string value); ///< Load JSON string into this object
 		Json::Value JsonValue(); ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root); ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root); ///< Load Json::Value into this object
 	};
 
 }
@@ -18,15 +18,11 @@ using namespace std;
 using namespace openshot;
 
 // Default constructor, no max bytes
-CacheMemory::CacheMemory() : CacheBase(0) {
-	// Set cache type name
-	cache_type = "CacheMemory";
-	range_version = 0;
-	needs_range_processing = false;
-}
+CacheMemory::CacheMemory() : CacheMemory(0) { }
 
 // Constructor that sets the max bytes to cache
-CacheMemory::CacheMemory(int64_t max_bytes) : CacheBase(max_bytes) {
+CacheMemory::CacheMemory(int64_t max_bytes) : CacheBase(max_bytes),
+	total_bytes(0), total_count(0), next_stamp(0), ranges_changed(false) {
 	// Set cache type name
 	cache_type = "CacheMemory";
 	range_version = 0;
@@ -45,66 +41,70 @@ CacheMemory::~CacheMemory()
 // Add a Frame to the cache
 void CacheMemory::Add(std::shared_ptr<Frame> frame)
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
 	int64_t frame_number = frame->number;
-
-	// Freshen frame if it already exists
-	if (frames.count(frame_number))
-		// Move frame to front of queue
-		MoveToFront(frame_number);
-
-	else
+	Shard& shard = shard_of(frame_number);
 	{
-		// Add frame to queue and map
-		frames[frame_number] = frame;
-		frame_numbers.push_front(frame_number);
-		ordered_frame_numbers.push_back(frame_number);
-		needs_range_processing = true;
-
-		// Clean up old frames
-		CleanUp();
+		// Only lock the shard of this frame
+		const std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+
+		auto itr = shard.frames.find(frame_number);
+		if (itr != shard.frames.end()) {
+			// Freshen frame if it already exists (move frame to front of queue)
+			freshen(shard, itr);
+		} else {
+			// Add frame to shard
+			Entry entry = {frame, frame->GetBytes(), next_stamp++};
+			shard.frames[frame_number] = entry;
+			shard.ages[entry.stamp] = frame_number;
+			total_bytes += entry.bytes;
+			total_count++;
+			ranges_changed = true;
+		}
 	}
+
+	// Clean up old frames
+	CleanUp();
 }
 
 // Check if frame is already contained in cache
 bool CacheMemory::Contains(int64_t frame_number) {
-	if (frames.count(frame_number) > 0) {
-		return true;
-	} else {
-		return false;
-	}
+	Shard& shard = shard_of(frame_number);
+	std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+	return shard.frames.count(frame_number) > 0;
 }
 
 // Get a frame from the cache (or NULL shared_ptr if no frame is found)
 std::shared_ptr<Frame> CacheMemory::GetFrame(int64_t frame_number)
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
+	// Lookups only share the lock of one shard
+	Shard& shard = shard_of(frame_number);
+	std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
 
 	// Does frame exists in cache?
-	if (frames.count(frame_number))
+	auto itr = shard.frames.find(frame_number);
+	if (itr != shard.frames.end())
 		// return the Frame object
-		return frames[frame_number];
+		return itr->second.frame;
 
 	else
 		// no Frame found
 		return std::shared_ptr<Frame>();
 }
 
-// @brief Get an array of all Frames
+// @brief Get an array of all Frames (ordered by frame number)
 std::vector<std::shared_ptr<openshot::Frame>> CacheMemory::GetFrames()
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
+	std::map<int64_t, std::shared_ptr<openshot::Frame>> ordered_frames;
+	for (Shard& shard : shards) {
+		std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+		for (const auto& item : shard.frames)
+			ordered_frames[item.first] = item.second.frame;
+	}
 
 	std::vector<std::shared_ptr<openshot::Frame>> all_frames;
-	std::vector<int64_t>::iterator itr_ordered;
-	for(itr_ordered = ordered_frame_numbers.begin(); itr_ordered != ordered_frame_numbers.end(); ++itr_ordered)
-	{
-		int64_t frame_number = *itr_ordered;
-		all_frames.push_back(GetFrame(frame_number));
-	}
+	all_frames.reserve(ordered_frames.size());
+	for (const auto& item : ordered_frames)
+		all_frames.push_back(item.second);
 
 	return all_frames;
 }
@@ -112,152 +112,160 @@ std::vector<std::shared_ptr<openshot::Frame>> CacheMemory::GetFrames()
 // Get the smallest frame number (or NULL shared_ptr if no frame is found)
 std::shared_ptr<Frame> CacheMemory::GetSmallestFrame()
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
-
-	// Loop through frame numbers
-	std::deque<int64_t>::iterator itr;
-	int64_t smallest_frame = -1;
-	for(itr = frame_numbers.begin(); itr != frame_numbers.end(); ++itr)
-	{
-		if (*itr < smallest_frame || smallest_frame == -1)
-			smallest_frame = *itr;
+	// Loop through the shards
+	std::shared_ptr<Frame> smallest_frame;
+	int64_t smallest_number = 0;
+	for (Shard& shard : shards) {
+		std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+		for (const auto& item : shard.frames) {
+			if (!smallest_frame || item.first < smallest_number) {
+				smallest_number = item.first;
+				smallest_frame = item.second.frame;
+			}
+		}
 	}
 
 	// Return frame (if any)
-	if (smallest_frame != -1) {
-		return frames[smallest_frame];
-	} else {
-		return NULL;
-	}
+	return smallest_frame;
 }
 
 // Gets the maximum bytes value
 int64_t CacheMemory::GetBytes()
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
+	return total_bytes;
+}
 
-	int64_t total_bytes = 0;
+// Remove a frame from a (locked) shard
+void CacheMemory::erase(Shard& shard, std::unordered_map<int64_t, Entry>::iterator itr)
+{
+	total_bytes -= itr->second.bytes;
+	total_count--;
+	shard.ages.erase(itr->second.stamp);
+	shard.frames.erase(itr);
+}
 
-	// Loop through frames, and calculate total bytes
-	std::deque<int64_t>::reverse_iterator itr;
-	for(itr = frame_numbers.rbegin(); itr != frame_numbers.rend(); ++itr)
-	{
-		total_bytes += frames[*itr]->GetBytes();
-	}
+// Move a frame of a (locked) shard to the front of the queue, and measure its size again
+void CacheMemory::freshen(Shard& shard, std::unordered_map<int64_t, Entry>::iterator itr)
+{
+	shard.ages.erase(itr->second.stamp);
+	itr->second.stamp = next_stamp++;
+	shard.ages[itr->second.stamp] = itr->first;
 
-	return total_bytes;
+	int64_t bytes = itr->second.frame->GetBytes();
+	total_bytes += bytes - itr->second.bytes;
+	itr->second.bytes = bytes;
 }
 
 // Remove a specific frame
 void CacheMemory::Remove(int64_t frame_number)
 {
-	Remove(frame_number, frame_number);
+	Shard& shard = shard_of(frame_number);
+	{
+		const std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+		auto itr = shard.frames.find(frame_number);
+		if (itr == shard.frames.end())
+			return;
+		erase(shard, itr);
+	}
+
+	// Needs range processing (since cache has changed)
+	ranges_changed = true;
 }
 
 // Remove range of frames
 void CacheMemory::Remove(int64_t start_frame_number, int64_t end_frame_number)
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
-
-	// Loop through frame numbers
-	std::deque<int64_t>::iterator itr;
-	for(itr = frame_numbers.begin(); itr != frame_numbers.end();)
-	{
-		if (*itr >= start_frame_number && *itr <= end_frame_number)
-		{
-			// erase frame number
-			itr = frame_numbers.erase(itr);
-		}else
-			itr++;
+	if (start_frame_number == end_frame_number) {
+		Remove(start_frame_number);
+		return;
 	}
 
-	// Loop through ordered frame numbers
-	std::vector<int64_t>::iterator itr_ordered;
-	for(itr_ordered = ordered_frame_numbers.begin(); itr_ordered != ordered_frame_numbers.end();)
-	{
-		if (*itr_ordered >= start_frame_number && *itr_ordered <= end_frame_number)
-		{
-			// erase frame number
-			frames.erase(*itr_ordered);
-			itr_ordered = ordered_frame_numbers.erase(itr_ordered);
-		}else
-			itr_ordered++;
+	// Lock one shard at a time
+	for (Shard& shard : shards) {
+		const std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+		for (auto itr = shard.frames.begin(); itr != shard.frames.end();) {
+			if (itr->first >= start_frame_number && itr->first <= end_frame_number)
+				erase(shard, itr++);
+			else
+				itr++;
+		}
 	}
 
 	// Needs range processing (since cache has changed)
-	needs_range_processing = true;
+	ranges_changed = true;
 }
 
 // Move frame to front of queue (so it lasts longer)
 void CacheMemory::MoveToFront(int64_t frame_number)
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
-
-	// Does frame exists in cache?
-	if (frames.count(frame_number))
+	Shard& shard = shard_of(frame_number);
 	{
-		// Loop through frame numbers
-		std::deque<int64_t>::iterator itr;
-		for(itr = frame_numbers.begin(); itr != frame_numbers.end(); ++itr)
-		{
-			if (*itr == frame_number)
-			{
-				// erase frame number
-				frame_numbers.erase(itr);
-
-				// add frame number to 'front' of queue
-				frame_numbers.push_front(frame_number);
-				break;
-			}
-		}
+		const std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+
+		// Does frame exists in cache?
+		auto itr = shard.frames.find(frame_number);
+		if (itr == shard.frames.end())
+			return;
+		freshen(shard, itr);
 	}
+
+	// Clean up old frames (if the frame grew since it was added)
+	CleanUp();
 }
 
 // Clear the cache of all frames
 void CacheMemory::Clear()
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
-
-	frames.clear();
-	frame_numbers.clear();
-	frame_numbers.shrink_to_fit();
-	ordered_frame_numbers.clear();
-	ordered_frame_numbers.shrink_to_fit();
-	needs_range_processing = true;
+	for (Shard& shard : shards) {
+		const std::lock_guard<std::shared_timed_mutex> lock(shard.mutex);
+		for (auto itr = shard.frames.begin(); itr != shard.frames.end();)
+			erase(shard, itr++);
+	}
+	ranges_changed = true;
 }
 
 // Count the frames in the queue
 int64_t CacheMemory::Count()
 {
-	// Create a scoped lock, to protect the cache from multiple threads
-	const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
-
 	// Return the number of frames in the cache
-	return frames.size();
+	return total_count;
 }
 
 // Clean up cached frames that exceed the number in our max_bytes variable
 void CacheMemory::CleanUp()
 {
 	// Do we auto clean up?
-	if (max_bytes > 0)
+	if (max_bytes <= 0 || total_bytes <= max_bytes)
+		return;
+
+	// Only one thread evicts at a time (others keep adding, and leave the clean up to it)
+	std::unique_lock<std::mutex> cleanup_lock(cleanup_mutex, std::try_to_lock);
+	if (!cleanup_lock.owns_lock())
+		return;
+
+	while (total_bytes > max_bytes && total_count > 20)
 	{
-		// Create a scoped lock, to protect the cache from multiple threads
-		const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
+		// Find the oldest frame (checking the oldest frame of each shard)
+		Shard* oldest_shard = nullptr;
+		uint64_t oldest_stamp = 0;
+		for (Shard& shard : shards) {
+			std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+			if (!shard.ages.empty() && (!oldest_shard || shard.ages.begin()->first < oldest_stamp)) {
+				oldest_shard = &shard;
+				oldest_stamp = shard.ages.begin()->first;
+			}
+		}
+		if (!oldest_shard)
+			break;
 
-		while (GetBytes() > max_bytes && frame_numbers.size() > 20)
+		// Remove it (unless it was freshened or removed in the meantime)
 		{
-			// Get the oldest frame number.
-			int64_t frame_to_remove = frame_numbers.back();
-
-			// Remove frame_number and frame
-			Remove(frame_to_remove);
+			const std::lock_guard<std::shared_timed_mutex> lock(oldest_shard->mutex);
+			auto age = oldest_shard->ages.find(oldest_stamp);
+			if (age != oldest_shard->ages.end())
+				erase(*oldest_shard, oldest_shard->frames.find(age->second));
 		}
+		ranges_changed = true;
 	}
 }
 
@@ -273,7 +281,19 @@ std::string CacheMemory::Json() {
 Json::Value CacheMemory::JsonValue() {
 
 	// Process range data (if anything has changed)
-	CalculateRanges();
+	{
+		const std::lock_guard<std::recursive_mutex> lock(*cacheMutex);
+		if (ranges_changed.exchange(false)) {
+			ordered_frame_numbers.clear();
+			for (Shard& shard : shards) {
+				std::shared_lock<std::shared_timed_mutex> shard_lock(shard.mutex);
+				for (const auto& item : shard.frames)
+					ordered_frame_numbers.push_back(item.first);
+			}
+			needs_range_processing = true;
+		}
+		CalculateRanges();
+	}
 
 	// Create root json object
 	Json::Value root = CacheBase::JsonValue(); // get parent properties
@@ -309,7 +329,7 @@ void CacheMemory::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void CacheMemory::SetJsonValue(const Json::Value root) {
+void CacheMemory::SetJsonValue(const Json::Value& root) {
 
 	// Close timeline before we do anything (this also removes all open and closing clips)
 	Clear();
@@ -15,6 +15,12 @@
 
 #include "CacheBase.h"
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
 namespace openshot {
 	class Frame;
 
@@ -25,11 +31,47 @@ namespace openshot {
 	 * high cost of decoding streams, once a frame is decoded, converted to RGB, and a Frame object is created,
 	 * it critical to keep these Frames cached for performance reasons.  However, the larger the cache, the more memory
 	 * is required.  You can set the max number of bytes to cache.
+	 *
+	 * Frames are spread over shards by frame number, each with its own reader/writer lock, so
+	 * concurrent lookups (which only take a shared lock on one shard) don't contend with each other,
+	 * or with frames being added to other shards. The byte budget is tracked with atomic counters,
+	 * and the oldest frames are evicted one shard at a time (by one thread at a time).
 	 */
 	class CacheMemory : public CacheBase {
 	private:
-		std::map<int64_t, std::shared_ptr<openshot::Frame> > frames;	///< This map holds the frame number and Frame objects
-		std::deque<int64_t> frame_numbers;	///< This queue holds a sequential list of cached Frame numbers
+		/// A cached frame (and its size and age)
+		struct Entry {
+			std::shared_ptr<openshot::Frame> frame;
+			int64_t bytes;
+			uint64_t stamp; ///< Position in the eviction order (larger is newer)
+		};
+
+		/// A group of cached frames, sharing one lock
+		struct Shard {
+			std::unordered_map<int64_t, Entry> frames; ///< Frame number and cached frame
+			std::map<uint64_t, int64_t> ages; ///< Frame numbers, from the oldest to the newest
+			mutable std::shared_timed_mutex mutex;
+		};
+
+		static const int SHARD_COUNT = 16;
+		Shard shards[SHARD_COUNT];
+		std::atomic<int64_t> total_bytes; ///< Bytes of all cached frames
+		std::atomic<int64_t> total_count; ///< Number of cached frames
+		std::atomic<uint64_t> next_stamp; ///< Age of the next added (or freshened) frame
+		std::atomic<bool> ranges_changed; ///< Frames were added or removed since the ranges were calculated
+		std::mutex cleanup_mutex; ///< Only one thread evicts frames at a time
+
+		/// Get the shard of a frame number
+		Shard& shard_of(int64_t frame_number) {
+			return shards[((frame_number % SHARD_COUNT) + SHARD_COUNT) % SHARD_COUNT];
+		}
+
+		/// Remove a frame from a (locked) shard
+		void erase(Shard& shard, std::unordered_map<int64_t, Entry>::iterator itr);
+
+		/// Move a frame of a (locked) shard to the front of the queue, and measure its size again
+		/// (frames are often added before their image or audio is)
+		void freshen(Shard& shard, std::unordered_map<int64_t, Entry>::iterator itr);
 
 		/// Clean up cached frames that exceed the max number of bytes
 		void CleanUp();
@@ -89,7 +131,7 @@ namespace openshot {
 		std::string Json(); ///< Generate JSON string of this object
 		void SetJson(const std::string value); ///< Load JSON string into this object
 		Json::Value JsonValue(); ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root); ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root); ///< Load Json::Value into this object
 	};
 
 }
@@ -10,18 +10,22 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include <algorithm>
 #include <fstream>
 
 #include "ChunkReader.h"
+#include "Clip.h"
 #include "Exceptions.h"
 #include "FFmpegReader.h"
+#include "Timeline.h"
 
 #include <QDir>
 
 using namespace openshot;
 
 ChunkReader::ChunkReader(std::string path, ChunkVersion chunk_version)
-		: path(path), chunk_size(24 * 3), is_open(false), version(chunk_version), local_reader(NULL)
+		: path(path), chunk_size(24 * 3), is_open(false), version(chunk_version), reader_version(chunk_version),
+		  local_reader(NULL)
 {
 	// Check if folder exists?
 	if (!does_folder_exist(path))
@@ -179,18 +183,51 @@ std::string ChunkReader::get_chunk_path(int64_t chunk_number, std::string folder
 		return "";
 }
 
+// Choose the version to read
+ChunkVersion ChunkReader::get_version()
+{
+	if (version != AUTO)
+		return version;
+
+	// Without a timeline, there's no preview size to fit
+	Clip *parent = static_cast<Clip *>(ParentClip());
+	if (!parent || !parent->ParentTimeline() || info.width <= 0 || info.height <= 0)
+		return FINAL;
+
+	// Size needed on the preview (the same way FFmpegReader limits its image size)
+	Timeline *t = static_cast<Timeline *>(parent->ParentTimeline());
+	float max_scale_x = std::max(1.0, parent->scale_x.GetMaxPoint().co.Y);
+	float max_scale_y = std::max(1.0, parent->scale_y.GetMaxPoint().co.Y);
+	float needed_width = t->preview_width * max_scale_x;
+	float needed_height = t->preview_height * max_scale_y;
+	if (parent->scale == SCALE_NONE && t->info.width > 0) {
+		float preview_ratio = t->preview_width / float(t->info.width);
+		needed_width = info.width * max_scale_x * preview_ratio;
+		needed_height = info.height * max_scale_y * preview_ratio;
+	}
+
+	// Smallest stream (1/4, 1/2 or full size) that still covers it
+	if (info.width * 0.25 >= needed_width && info.height * 0.25 >= needed_height)
+		return THUMBNAIL;
+	if (info.width * 0.5 >= needed_width && info.height * 0.5 >= needed_height)
+		return PREVIEW;
+	return FINAL;
+}
+
 // Get an openshot::Frame object for a specific frame number of this reader.
 std::shared_ptr<Frame> ChunkReader::GetFrame(int64_t requested_frame)
 {
 	// Determine what chunk contains this frame
 	ChunkLocation location = find_chunk_frame(requested_frame);
 
-	// New Chunk (Close the old reader, and open the new one)
-	if (previous_location.number != location.number)
+	// Determine version of chunk (the AUTO version follows the preview size)
+	ChunkVersion current_version = get_version();
+
+	// New Chunk or version (Close the old reader, and open the new one)
+	if (previous_location.number != location.number || reader_version != current_version || !local_reader)
 	{
-		// Determine version of chunk
 		std::string folder_name = "";
-		switch (version)
+		switch (current_version)
 		{
 		case THUMBNAIL:
 			folder_name = "thumb";
@@ -199,6 +236,7 @@ std::shared_ptr<Frame> ChunkReader::GetFrame(int64_t requested_frame)
 			folder_name = "preview";
 			break;
 		case FINAL:
+		case AUTO:
 			folder_name = "final";
 			break;
 		}
@@ -212,6 +250,7 @@ std::shared_ptr<Frame> ChunkReader::GetFrame(int64_t requested_frame)
 			// Close and delete old reader
 			local_reader->Close();
 			delete local_reader;
+			local_reader = NULL;
 		}
 
 		try
@@ -228,6 +267,7 @@ std::shared_ptr<Frame> ChunkReader::GetFrame(int64_t requested_frame)
 
 		// Set the new location
 		previous_location = location;
+		reader_version = current_version;
 	}
 
 	// Get the frame (from the current reader)
@@ -280,7 +320,7 @@ void ChunkReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void ChunkReader::SetJsonValue(const Json::Value root) {
+void ChunkReader::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
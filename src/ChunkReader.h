@@ -50,7 +50,8 @@ namespace openshot
 	{
 		THUMBNAIL,	///< The lowest quality stream contained in this chunk file
 		PREVIEW,	///< The medium quality stream contained in this chunk file
-		FINAL		///< The highest quality stream contained in this chunk file
+		FINAL,		///< The highest quality stream contained in this chunk file
+		AUTO		///< The smallest stream that still covers the preview size of the parent timeline
 	};
 
 	/**
@@ -84,6 +85,7 @@ namespace openshot
 		openshot::ReaderBase *local_reader;
 		ChunkLocation previous_location;
 		ChunkVersion version;
+		ChunkVersion reader_version; ///< Version of the open chunk (never AUTO)
 		std::shared_ptr<openshot::Frame> last_frame;
 
 		/// Check if folder path existing
@@ -98,12 +100,15 @@ namespace openshot
 		/// Load JSON meta data about this chunk folder
 		void load_json();
 
+		/// Choose the version to read (based on the parent clip and timeline, for the AUTO version)
+		ChunkVersion get_version();
+
 	public:
 
 		/// @brief Constructor for ChunkReader.  This automatically opens the chunk file or folder and loads
 		/// frame 1, or it throws one of the following exceptions.
 		/// @param path				The folder path / location of a chunk (chunks are stored as folders)
-		/// @param chunk_version	Choose the video version / quality (THUMBNAIL, PREVIEW, or FINAL)
+		/// @param chunk_version	Choose the video version / quality (THUMBNAIL, PREVIEW, FINAL, or AUTO)
 		ChunkReader(std::string path, ChunkVersion chunk_version);
 
 		/// Close the reader
@@ -135,7 +140,7 @@ namespace openshot
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Open the reader. This is required before you can access frames or data from the reader.
 		void Open() override;
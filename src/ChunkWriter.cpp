@@ -14,8 +14,51 @@
 #include "Exceptions.h"
 #include "Frame.h"
 
+#include <algorithm>
+
+#include <QImage>
+
 using namespace openshot;
 
+// Max number of frames queued for each rendition (before WriteFrame waits for the encoders)
+static const size_t RENDITION_QUEUE_SIZE = 8;
+
+// Average two packed 32-bit pixels (each 8-bit channel separately, rounded down)
+static inline uint32_t average_pixels(uint32_t a, uint32_t b)
+{
+	return (a & b) + (((a ^ b) & 0xFEFEFEFE) >> 1);
+}
+
+// Scale an image to half its size, averaging each 2x2 block of pixels. This works 4 channels
+// at a time on each packed pixel, so the inner loop vectorizes well.
+static std::shared_ptr<QImage> half_scale(std::shared_ptr<QImage> source)
+{
+	if (source->depth() != 32)
+		source = std::make_shared<QImage>(source->convertToFormat(QImage::Format_RGBA8888_Premultiplied));
+
+	const int width = std::max(source->width() / 2, 1);
+	const int height = std::max(source->height() / 2, 1);
+	auto scaled = std::make_shared<QImage>(width, height, source->format());
+	const QImage& input = *source;
+	const int last_x = input.width() - 1;
+	const int last_y = input.height() - 1;
+
+	#pragma omp parallel for
+	for (int y = 0; y < height; y++) {
+		const uint32_t* top = reinterpret_cast<const uint32_t*>(input.constScanLine(std::min(y * 2, last_y)));
+		const uint32_t* bottom = reinterpret_cast<const uint32_t*>(input.constScanLine(std::min(y * 2 + 1, last_y)));
+		uint32_t* output = reinterpret_cast<uint32_t*>(scaled->scanLine(y));
+		for (int x = 0; x < width; x++) {
+			const int left = std::min(x * 2, last_x);
+			const int right = std::min(x * 2 + 1, last_x);
+			output[x] = average_pixels(average_pixels(top[left], top[right]),
+									   average_pixels(bottom[left], bottom[right]));
+		}
+	}
+
+	return scaled;
+}
+
 ChunkWriter::ChunkWriter(std::string path, ReaderBase *reader) :
 		local_reader(reader), path(path), chunk_size(24*3), chunk_count(1), frame_count(1), is_writing(false),
 		default_extension(".webm"), default_vcodec("libvpx"), default_acodec("libvorbis"), last_frame_needed(false), is_open(false)
@@ -35,6 +78,20 @@ ChunkWriter::ChunkWriter(std::string path, ReaderBase *reader) :
 
 	// Open reader
 	local_reader->Open();
+
+	// Versions of each chunk (final, preview at 1/2 size, and thumb at 1/4 size)
+	const char* folders[] = {"final", "preview", "thumb"};
+	for (int i = 0; i < 3; i++) {
+		renditions.emplace_back(new Rendition());
+		renditions.back()->folder = folders[i];
+		renditions.back()->half_scales = i;
+	}
+}
+
+// Destructor
+ChunkWriter::~ChunkWriter()
+{
+	stop_renditions();
 }
 
 // get a formatted path of a specific chunk
@@ -60,6 +117,159 @@ std::string ChunkWriter::get_chunk_path(int64_t chunk_number, std::string folder
 		return "";
 }
 
+// Scale a frame for each rendition (halving the previous rendition's image)
+std::vector<std::shared_ptr<Frame>> ChunkWriter::scale_frame(std::shared_ptr<Frame> frame)
+{
+	std::vector<std::shared_ptr<Frame>> frames;
+	frames.push_back(frame);
+
+	std::shared_ptr<QImage> image = frame->GetImage();
+	for (size_t i = 1; i < renditions.size(); i++) {
+		if (image) {
+			// Half the size of the previous rendition (all renditions are computed from one image)
+			image = half_scale(image);
+			auto scaled_frame = std::make_shared<Frame>(*frame);
+			scaled_frame->AddImage(image);
+			frames.push_back(scaled_frame);
+		} else {
+			frames.push_back(frame);
+		}
+	}
+
+	return frames;
+}
+
+// Encoding thread of a rendition (runs its jobs in order)
+void ChunkWriter::run_rendition(Rendition* rendition)
+{
+	std::unique_lock<std::mutex> lock(rendition->mutex);
+	while (true) {
+		rendition->condition.wait(lock, [rendition] { return rendition->stopping || !rendition->jobs.empty(); });
+		if (rendition->jobs.empty())
+			break;
+
+		std::function<void()> job = std::move(rendition->jobs.front());
+		rendition->jobs.pop_front();
+		bool failed = (rendition->error != nullptr);
+		lock.unlock();
+
+		// Once a job fails, skip the remaining jobs of this rendition
+		std::exception_ptr job_error;
+		try {
+			if (!failed)
+				job();
+		} catch (...) {
+			job_error = std::current_exception();
+		}
+
+		lock.lock();
+		if (job_error && !rendition->error)
+			rendition->error = job_error;
+		rendition->condition.notify_all();
+	}
+}
+
+// Start the encoding thread of each rendition
+void ChunkWriter::start_renditions()
+{
+	for (auto& rendition : renditions) {
+		if (rendition->thread.joinable())
+			continue;
+		{
+			const std::lock_guard<std::mutex> lock(rendition->mutex);
+			rendition->stopping = false;
+			rendition->error = nullptr;
+		}
+		rendition->thread = std::thread(&ChunkWriter::run_rendition, this, rendition.get());
+	}
+}
+
+// Finish the queued jobs, and stop the encoding threads
+void ChunkWriter::stop_renditions()
+{
+	for (auto& rendition : renditions) {
+		if (!rendition->thread.joinable())
+			continue;
+		{
+			const std::lock_guard<std::mutex> lock(rendition->mutex);
+			rendition->stopping = true;
+		}
+		rendition->condition.notify_all();
+		rendition->thread.join();
+	}
+}
+
+// Add a job to a rendition's thread (waits if too many frames are already queued)
+void ChunkWriter::queue_job(Rendition* rendition, std::function<void()> job)
+{
+	std::unique_lock<std::mutex> lock(rendition->mutex);
+	rendition->condition.wait(lock, [rendition] { return rendition->jobs.size() < RENDITION_QUEUE_SIZE; });
+	if (rendition->error)
+		std::rethrow_exception(rendition->error);
+	rendition->jobs.push_back(std::move(job));
+	rendition->condition.notify_all();
+}
+
+// Queue a frame (scaled for each rendition) for encoding
+void ChunkWriter::write_frames(const std::vector<std::shared_ptr<Frame>>& frames)
+{
+	for (size_t i = 0; i < renditions.size(); i++) {
+		Rendition* rendition = renditions[i].get();
+		std::shared_ptr<Frame> frame = frames[i];
+		queue_job(rendition, [rendition, frame] { rendition->writer->WriteFrame(frame); });
+	}
+}
+
+// Create, and open the writers of a new chunk
+void ChunkWriter::start_chunk()
+{
+	for (auto& rendition : renditions) {
+		// Create FFmpegWriter (at 1, 1/2 or 1/4 of the final size and bitrate)
+		create_folder(get_chunk_path(chunk_count, rendition->folder, ""));
+		std::string chunk_path = get_chunk_path(chunk_count, rendition->folder, default_extension);
+		double scale = 1.0 / (1 << rendition->half_scales);
+
+		Rendition* r = rendition.get();
+		queue_job(r, [this, r, chunk_path, scale] {
+			r->writer = new FFmpegWriter(chunk_path);
+			r->writer->SetAudioOptions(true, default_acodec, info.sample_rate, info.channels, info.channel_layout, 128000);
+			r->writer->SetVideoOptions(true, default_vcodec, info.fps, info.width * scale, info.height * scale, info.pixel_ratio, false, false, info.video_bit_rate * scale);
+
+			// Prepare Streams, and write header
+			r->writer->PrepareStreams();
+			r->writer->WriteHeader();
+		});
+	}
+}
+
+// Pad, and close the writers of the current chunk
+void ChunkWriter::finish_chunk()
+{
+	// Pad an additional 12 frames
+	for (int z = 0; z<12; z++)
+	{
+		// Repeat frame
+		write_frames(last_frames);
+	}
+
+	for (auto& rendition : renditions) {
+		Rendition* r = rendition.get();
+		queue_job(r, [r] {
+			// Write Footer, and close writer
+			r->writer->WriteTrailer();
+			r->writer->Close();
+			delete r->writer;
+			r->writer = nullptr;
+		});
+	}
+
+	// Increment chunk count
+	chunk_count++;
+
+	// Stop writing chunk
+	is_writing = false;
+}
+
 // Add a frame to the queue waiting to be encoded.
 void ChunkWriter::WriteFrame(std::shared_ptr<openshot::Frame> frame)
 {
@@ -73,33 +283,8 @@ void ChunkWriter::WriteFrame(std::shared_ptr<openshot::Frame> frame)
 		// Save thumbnail of chunk start frame
 		frame->Save(get_chunk_path(chunk_count, "", ".jpeg"), 1.0);
 
-		// Create FFmpegWriter (FINAL quality)
-		create_folder(get_chunk_path(chunk_count, "final", ""));
-		writer_final = new FFmpegWriter(get_chunk_path(chunk_count, "final", default_extension));
-		writer_final->SetAudioOptions(true, default_acodec, info.sample_rate, info.channels, info.channel_layout, 128000);
-		writer_final->SetVideoOptions(true, default_vcodec, info.fps, info.width, info.height, info.pixel_ratio, false, false, info.video_bit_rate);
-
-		// Create FFmpegWriter (PREVIEW quality)
-		create_folder(get_chunk_path(chunk_count, "preview", ""));
-		writer_preview = new FFmpegWriter(get_chunk_path(chunk_count, "preview", default_extension));
-		writer_preview->SetAudioOptions(true, default_acodec, info.sample_rate, info.channels, info.channel_layout, 128000);
-		writer_preview->SetVideoOptions(true, default_vcodec, info.fps, info.width * 0.5, info.height * 0.5, info.pixel_ratio, false, false, info.video_bit_rate * 0.5);
-
-		// Create FFmpegWriter (LOW quality)
-		create_folder(get_chunk_path(chunk_count, "thumb", ""));
-		writer_thumb = new FFmpegWriter(get_chunk_path(chunk_count, "thumb", default_extension));
-		writer_thumb->SetAudioOptions(true, default_acodec, info.sample_rate, info.channels, info.channel_layout, 128000);
-		writer_thumb->SetVideoOptions(true, default_vcodec, info.fps, info.width * 0.25, info.height * 0.25, info.pixel_ratio, false, false, info.video_bit_rate * 0.25);
-
-		// Prepare Streams
-		writer_final->PrepareStreams();
-		writer_preview->PrepareStreams();
-		writer_thumb->PrepareStreams();
-
-		// Write header
-		writer_final->WriteHeader();
-		writer_preview->WriteHeader();
-		writer_thumb->WriteHeader();
+		// Create the FFmpegWriters (FINAL, PREVIEW and LOW quality)
+		start_chunk();
 
 		// Keep track that a chunk is being written
 		is_writing = true;
@@ -113,67 +298,36 @@ void ChunkWriter::WriteFrame(std::shared_ptr<openshot::Frame> frame)
 		if (last_frame)
 		{
 			// Write the previous chunks LAST FRAME to the current chunk
-			writer_final->WriteFrame(last_frame);
-			writer_preview->WriteFrame(last_frame);
-			writer_thumb->WriteFrame(last_frame);
+			write_frames(last_frames);
 		} else {
 			// Write the 1st frame (of the 1st chunk)... since no previous chunk is available
 			auto blank_frame = std::make_shared<Frame>(
 				1, info.width, info.height, "#000000",
 				info.sample_rate, info.channels);
 			blank_frame->AddColor(info.width, info.height, "#000000");
-			writer_final->WriteFrame(blank_frame);
-			writer_preview->WriteFrame(blank_frame);
-			writer_thumb->WriteFrame(blank_frame);
+			write_frames(scale_frame(blank_frame));
 		}
 
 		// disable last frame
 		last_frame_needed = false;
 	}
 
+	// Keep track of the last frame added
+	last_frame = frame;
+	last_frames = scale_frame(frame);
 
 	//////////////////////////////////////////////////
 	// WRITE THE CURRENT FRAME TO THE CURRENT CHUNK
-	writer_final->WriteFrame(frame);
-	writer_preview->WriteFrame(frame);
-	writer_thumb->WriteFrame(frame);
+	write_frames(last_frames);
 	//////////////////////////////////////////////////
 
 
 	// Write the frames once it reaches the correct chunk size
 	if (frame_count % chunk_size == 0 && frame_count >= chunk_size)
-	{
-		// Pad an additional 12 frames
-		for (int z = 0; z<12; z++)
-		{
-			// Repeat frame
-			writer_final->WriteFrame(frame);
-			writer_preview->WriteFrame(frame);
-			writer_thumb->WriteFrame(frame);
-		}
-
-		// Write Footer
-		writer_final->WriteTrailer();
-		writer_preview->WriteTrailer();
-		writer_thumb->WriteTrailer();
-
-		// Close writer & reader
-		writer_final->Close();
-		writer_preview->Close();
-		writer_thumb->Close();
-
-		// Increment chunk count
-		chunk_count++;
-
-		// Stop writing chunk
-		is_writing = false;
-	}
+		finish_chunk();
 
 	// Increment frame counter
 	frame_count++;
-
-	// Keep track of the last frame added
-	last_frame = frame;
 }
 
 
@@ -208,33 +362,21 @@ void ChunkWriter::WriteFrame(int64_t start, int64_t length)
 // Close the writer
 void ChunkWriter::Close()
 {
-	// Write the frames once it reaches the correct chunk size
-	if (is_writing)
-	{
-		// Pad an additional 12 frames
-		for (int z = 0; z<12; z++)
-		{
-			// Repeat frame
-			writer_final->WriteFrame(last_frame);
-			writer_preview->WriteFrame(last_frame);
-			writer_thumb->WriteFrame(last_frame);
+	// Write the frames once it reaches the correct chunk size (which fails if an encoder
+	// already failed: the error is reported below, once the encoders are stopped)
+	if (is_writing) {
+		try {
+			finish_chunk();
+		} catch (...) {
+			is_writing = false;
 		}
+	}
 
-		// Write Footer
-		writer_final->WriteTrailer();
-		writer_preview->WriteTrailer();
-		writer_thumb->WriteTrailer();
-
-		// Close writer & reader
-		writer_final->Close();
-		writer_preview->Close();
-		writer_thumb->Close();
-
-		// Increment chunk count
-		chunk_count++;
-
-		// Stop writing chunk
-		is_writing = false;
+	// Wait for the encoders to finish (deleting the writers of a failed chunk)
+	stop_renditions();
+	for (auto& rendition : renditions) {
+		delete rendition->writer;
+		rendition->writer = nullptr;
 	}
 
 	// close writer
@@ -246,6 +388,17 @@ void ChunkWriter::Close()
 
 	// Open reader
 	local_reader->Close();
+
+	// Report any encoding error
+	for (auto& rendition : renditions) {
+		std::exception_ptr error;
+		{
+			const std::lock_guard<std::mutex> lock(rendition->mutex);
+			error = rendition->error;
+		}
+		if (error)
+			std::rethrow_exception(error);
+	}
 }
 
 // write JSON meta data
@@ -279,5 +432,8 @@ bool ChunkWriter::is_chunk_valid()
 // Open the writer
 void ChunkWriter::Open()
 {
+	// Start the encoding threads
+	start_renditions();
+
 	is_open = true;
 }
@@ -20,11 +20,19 @@
 #include "Json.h"
 
 #include <cmath>
+#include <condition_variable>
 #include <ctime>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <fstream>
 #include <cstdio>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 #include <unistd.h>
 #include <omp.h>
 #include <QtCore/QDir>
@@ -40,6 +48,10 @@ namespace openshot
 	 * computing environment, without needing to share the entire video file. They also allow a
 	 * chunk to be frame accurate, since seeking inaccuracies are removed.
 	 *
+	 * Each chunk is written in 3 versions (final, preview at half size, and thumb at quarter
+	 * size). The smaller images are averaged down from the final image once per frame, and each
+	 * version is encoded concurrently on its own thread.
+	 *
 	 * @code
 	 * // This example demonstrates how to feed a reader into a ChunkWriter
 	 * FFmpegReader *r = new FFmpegReader("MyAwesomeVideo.mp4"); // Get a reader
@@ -69,10 +81,23 @@ namespace openshot
 		bool is_open;
 		bool is_writing;
 		openshot::ReaderBase *local_reader;
-		openshot::FFmpegWriter *writer_thumb;
-		openshot::FFmpegWriter *writer_preview;
-		openshot::FFmpegWriter *writer_final;
+
+		/// One version of the chunks (final, preview or thumb), encoded on its own thread
+		struct Rendition {
+			std::string folder; ///< Sub-folder of the chunks
+			int half_scales; ///< Number of times the final size is halved
+			openshot::FFmpegWriter *writer = nullptr;
+			std::thread thread;
+			std::deque<std::function<void()>> jobs; ///< Encoding jobs waiting for the thread
+			bool stopping = false;
+			std::exception_ptr error; ///< First exception thrown by a job (rethrown to the caller)
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+		std::vector<std::unique_ptr<Rendition>> renditions;
+
 	    std::shared_ptr<Frame> last_frame;
+	    std::vector<std::shared_ptr<Frame>> last_frames; ///< last_frame, scaled for each rendition
 	    bool last_frame_needed;
 	    std::string default_extension;
 	    std::string default_vcodec;
@@ -90,6 +115,30 @@ namespace openshot
 		/// write json meta data
 		void write_json_meta_data();
 
+		/// Scale a frame for each rendition (halving the previous rendition's image)
+		std::vector<std::shared_ptr<openshot::Frame>> scale_frame(std::shared_ptr<openshot::Frame> frame);
+
+		/// Start the encoding thread of each rendition
+		void start_renditions();
+
+		/// Finish the queued jobs, and stop the encoding threads
+		void stop_renditions();
+
+		/// Encoding thread of a rendition (runs its jobs in order)
+		void run_rendition(Rendition* rendition);
+
+		/// Add a job to a rendition's thread (waits if too many frames are already queued)
+		void queue_job(Rendition* rendition, std::function<void()> job);
+
+		/// Queue a frame (scaled for each rendition) for encoding
+		void write_frames(const std::vector<std::shared_ptr<openshot::Frame>>& frames);
+
+		/// Create, and open the writers of a new chunk
+		void start_chunk();
+
+		/// Pad, and close the writers of the current chunk
+		void finish_chunk();
+
 	public:
 
 		/// @brief Constructor for ChunkWriter. Throws one of the following exceptions.
@@ -97,6 +146,9 @@ namespace openshot
 		/// @param reader The initial reader to base this chunk file's meta data on (such as fps, height, width, etc...)
 		ChunkWriter(std::string path, openshot::ReaderBase *reader);
 
+		/// Destructor (stops the encoding threads)
+		virtual ~ChunkWriter();
+
 		/// Close the writer
 		void Close();
 
@@ -16,6 +16,7 @@
 #include "Exceptions.h"
 #include "FFmpegReader.h"
 #include "FrameMapper.h"
+#include "MediaSource.h"
 #include "QtImageReader.h"
 #include "ChunkReader.h"
 #include "DummyReader.h"
@@ -173,8 +174,8 @@ Clip::Clip(std::string path) : resampler(NULL), reader(NULL), allocated_reader(N
 	{
 		try
 		{
-			// Open common video format
-			reader = new openshot::FFmpegReader(path);
+			// Open common video format (sharing the decoder of other clips of this file)
+			reader = new openshot::MediaSourceReader(MediaSourceRegistry::Instance()->Acquire(path));
 
 		} catch(...) { }
 	}
@@ -201,7 +202,7 @@ Clip::Clip(std::string path) : resampler(NULL), reader(NULL), allocated_reader(N
 			try
 			{
 				// Try a video reader
-				reader = new openshot::FFmpegReader(path);
+				reader = new openshot::MediaSourceReader(MediaSourceRegistry::Instance()->Acquire(path));
 
 			} catch(...) { }
 		}
@@ -379,10 +380,48 @@ void Clip::End(float value) {
 
 // Set associated Timeline pointer
 void Clip::ParentTimeline(openshot::TimelineBase* new_timeline) {
+	// Final image size on the previous timeline (which the reader may have cached images at)
+	int old_final_width = 0;
+	int old_final_height = 0;
+	bool had_final_size = reader_final_size(old_final_width, old_final_height);
+
 	timeline = new_timeline;
 
 	// Clear cache (it might have changed)
 	final_cache.Clear();
+
+	// Images the reader decoded at the previous final size would be scaled up (blurry) or down again
+	clear_resized_reader_cache(had_final_size, old_final_width, old_final_height);
+}
+
+// Clear the cached frames of the reader (and the reader it maps, if it's a FrameMapper)
+void Clip::clear_reader_cache()
+{
+	if (!reader)
+		return;
+
+	if (reader->GetCache())
+		reader->GetCache()->Clear();
+
+	FrameMapper* mapper = dynamic_cast<FrameMapper*>(reader);
+	if (mapper && mapper->Reader() && mapper->Reader()->GetCache())
+		mapper->Reader()->GetCache()->Clear();
+}
+
+// Get the final image size of the reader's images (if the reader decodes at the clip's final size)
+bool Clip::reader_final_size(int& width, int& height) const
+{
+	return reader && FinalImageSize(reader->info.width, reader->info.height, width, height);
+}
+
+// Clear the cached frames of the reader, if its final image size changed
+void Clip::clear_resized_reader_cache(bool had_final_size, int old_width, int old_height)
+{
+	int width = 0;
+	int height = 0;
+	bool has_final_size = reader_final_size(width, height);
+	if (has_final_size != had_final_size || width != old_width || height != old_height)
+		clear_reader_cache();
 }
 
 // Create an openshot::Frame object for a specific frame number of this reader.
@@ -412,8 +451,10 @@ std::shared_ptr<Frame> Clip::GetFrame(std::shared_ptr<openshot::Frame> backgroun
 		// Get frame object
 		std::shared_ptr<Frame> frame = NULL;
 
-		// Check cache
-		frame = final_cache.GetFrame(clip_frame_number);
+		// Check cache (scrubbing frames are rendered on a smaller canvas, so they skip the cache)
+		bool is_scrubbing = options && options->is_scrubbing;
+		if (!is_scrubbing)
+			frame = final_cache.GetFrame(clip_frame_number);
 		if (frame) {
 			// Debug output
 			ZmqLogger::Instance()->AppendDebugMethod(
@@ -427,6 +468,30 @@ std::shared_ptr<Frame> Clip::GetFrame(std::shared_ptr<openshot::Frame> backgroun
 		// Generate clip frame
 		frame = GetOrCreateFrame(clip_frame_number);
 
+		// Static clips (images and titles with constant properties) reuse their last transformed layer,
+		// so they only need to be composited onto the background
+		StaticLayerKey layer_key;
+		bool is_static_layer = get_static_layer_key(frame, background_frame, options, layer_key);
+		if (is_static_layer) {
+			QImage layer;
+			{
+				const std::lock_guard<std::mutex> lock(static_layer_mutex);
+				if (!static_layer.isNull() && static_layer_key == layer_key)
+					layer = static_layer;
+			}
+			if (!layer.isNull()) {
+				ZmqLogger::Instance()->AppendDebugMethod(
+						"Clip::GetFrame (Static layer reused)",
+						"requested_frame", clip_frame_number);
+
+				apply_timemapping(frame);
+				frame->AddImage(std::make_shared<QImage>(layer));
+				apply_background(frame, background_frame);
+				if (!is_scrubbing)
+					final_cache.Add(frame);
+				return frame;
+			}
+		}
 
         if (!openshot::Settings::Instance()->ENABLE_LEGACY_MODE) {
             apply_scale_options(frame, background_frame);
@@ -454,11 +519,19 @@ std::shared_ptr<Frame> Clip::GetFrame(std::shared_ptr<openshot::Frame> backgroun
 		// Apply effects AFTER applying keyframes (if any local or global effects are used)
 		apply_effects(frame, background_frame, options, false);
 
+		// Keep the transformed layer of a static clip (for the next frames)
+		if (is_static_layer && !is_scrubbing) {
+			const std::lock_guard<std::mutex> lock(static_layer_mutex);
+			static_layer = *frame->GetImage();
+			static_layer_key = layer_key;
+		}
+
 		// Apply background canvas (i.e. flatten this image onto previous layer image)
 		apply_background(frame, background_frame);
 
 		// Add final frame to cache
-		final_cache.Add(frame);
+		if (!is_scrubbing)
+			final_cache.Add(frame);
 
 		// Return processed 'frame'
 		return frame;
@@ -961,7 +1034,13 @@ void Clip::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Clip::SetJsonValue(const Json::Value root) {
+void Clip::SetJsonValue(const Json::Value& root) {
+
+	// Final image size of the current reader (which may have cached images decoded at this size)
+	int old_final_width = 0;
+	int old_final_height = 0;
+	ReaderBase* old_reader = reader;
+	bool had_final_size = reader_final_size(old_final_width, old_final_height);
 
 	// Set parent data
 	ClipBase::SetJsonValue(root);
@@ -1044,7 +1123,7 @@ void Clip::SetJsonValue(const Json::Value root) {
 		effects.clear();
 
 		// loop through effects
-		for (const auto existing_effect : root["effects"]) {
+		for (const auto& existing_effect : root["effects"]) {
 			// Skip NULL nodes
 			if (existing_effect.isNull()) {
 				continue;
@@ -1068,7 +1147,7 @@ void Clip::SetJsonValue(const Json::Value root) {
 	}
 	if (!root["reader"].isNull()) // does Json contain a reader?
 	{
-		if (!root["reader"]["type"].isNull()) // does the reader Json contain a 'type'?
+		if (!root["reader"]["type"].isNull() && !HasReaderSettings(root["reader"])) // does the reader Json contain a 'type' (and new settings)?
 		{
 			// Close previous reader (if any)
 			bool already_open = false;
@@ -1086,9 +1165,10 @@ void Clip::SetJsonValue(const Json::Value root) {
 
 			if (type == "FFmpegReader") {
 
-				// Create new reader
-				reader = new openshot::FFmpegReader(root["reader"]["path"].asString(), false);
-				reader->SetJsonValue(root["reader"]);
+				// Create new reader (sharing the decoder of other clips of the same file, unless the timeline doesn't)
+				Timeline* parentTimeline = static_cast<Timeline *>(ParentTimeline());
+				bool share = !parentTimeline || parentTimeline->ShareMediaSources();
+				reader = new openshot::MediaSourceReader(MediaSourceRegistry::Instance()->Acquire(root["reader"], share));
 
 			} else if (type == "QtImageReader") {
 
@@ -1144,6 +1224,10 @@ void Clip::SetJsonValue(const Json::Value root) {
 
 	// Clear cache (it might have changed)
 	final_cache.Clear();
+
+	// Images the reader decoded at the previous final size would be scaled up (blurry) or down again
+	if (reader == old_reader)
+		clear_resized_reader_cache(had_final_size, old_final_width, old_final_height);
 }
 
 // Sort effects by order
@@ -1156,6 +1240,11 @@ void Clip::sort_effects()
 // Add an effect to the clip
 void Clip::AddEffect(EffectBase* effect)
 {
+	// Final image size without this effect (which the reader may have cached images at)
+	int old_final_width = 0;
+	int old_final_height = 0;
+	bool had_final_size = reader_final_size(old_final_width, old_final_height);
+
 	// Set parent clip pointer
 	effect->ParentClip(this);
 
@@ -1198,15 +1287,26 @@ void Clip::AddEffect(EffectBase* effect)
 
 	// Clear cache (it might have changed)
 	final_cache.Clear();
+
+	// Images the reader decoded at the previous final size would be scaled up (blurry) or down again
+	clear_resized_reader_cache(had_final_size, old_final_width, old_final_height);
 }
 
 // Remove an effect from the clip
 void Clip::RemoveEffect(EffectBase* effect)
 {
+	// Final image size with this effect (which the reader may have cached images at)
+	int old_final_width = 0;
+	int old_final_height = 0;
+	bool had_final_size = reader_final_size(old_final_width, old_final_height);
+
 	effects.remove(effect);
 
 	// Clear cache (it might have changed)
 	final_cache.Clear();
+
+	// Images the reader decoded at the previous final size would be scaled up (blurry) or down again
+	clear_resized_reader_cache(had_final_size, old_final_width, old_final_height);
 }
 
 // Apply background image to the current clip image (i.e. flatten this image onto previous layer)
@@ -1318,21 +1418,41 @@ void Clip::apply_keyframes(std::shared_ptr<Frame> frame, std::shared_ptr<Frame>
 
 void Clip::apply_scale_options(std::shared_ptr<Frame> frame, std::shared_ptr<openshot::Frame> background_frame)
 {
+    // No canvas to scale against
+    if (!background_frame)
+        return;
+
     std::shared_ptr<QImage> source_image = frame->GetImage();
-    QSize source_size = source_image->size();
+
+    // Readers can decode straight to the final size (see FinalImageSize), leaving nothing to scale
+    int final_width = 0;
+    int final_height = 0;
+    if (FinalImageSize(reader->info.width, reader->info.height, final_width, final_height)
+        && source_image->width() == final_width && source_image->height() == final_height)
+        return;
+
+    QSize scaled_size = scale_size(source_image->size(), background_frame->GetWidth(), background_frame->GetHeight(), frame->number);
+    QImage scaledImg = source_image->scaled(scaled_size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    frame->AddImage(std::make_shared<QImage>(scaledImg));
+}
+
+// Get the size of a source image, after the scale mode and scale_x / scale_y are applied
+QSize Clip::scale_size(QSize source_size, int canvas_width, int canvas_height, int64_t frame_number) const
+{
+    QSize canvas_size = source_size;
 
     switch (scale)
     {
         case (SCALE_FIT): {
-            source_size.scale(background_frame->GetWidth(), background_frame->GetHeight(), Qt::KeepAspectRatio);
+            canvas_size.scale(canvas_width, canvas_height, Qt::KeepAspectRatio);
             break;
         }
         case (SCALE_STRETCH): {
-            source_size.scale(background_frame->GetWidth(), background_frame->GetHeight(), Qt::IgnoreAspectRatio);
+            canvas_size.scale(canvas_width, canvas_height, Qt::IgnoreAspectRatio);
             break;
         }
         case (SCALE_CROP): {
-            source_size.scale(background_frame->GetWidth(), background_frame->GetHeight(), Qt::KeepAspectRatioByExpanding);
+            canvas_size.scale(canvas_width, canvas_height, Qt::KeepAspectRatioByExpanding);
         }
         case (SCALE_NONE): {
             break;
@@ -1340,17 +1460,30 @@ void Clip::apply_scale_options(std::shared_ptr<Frame> frame, std::shared_ptr<ope
     }
 
     // Adjust size for scale x and scale y
-    float sx = scale_x.GetValue(frame->number); // percentage X scale
-    float sy = scale_y.GetValue(frame->number); // percentage Y scale
+    float sx = scale_x.GetValue(frame_number); // percentage X scale
+    float sy = scale_y.GetValue(frame_number); // percentage Y scale
 
-    float scaled_source_width = source_size.width() * sx;
-    float scaled_source_height = source_size.height() * sy;
+    float scaled_source_width = canvas_size.width() * sx;
+    float scaled_source_height = canvas_size.height() * sy;
 
-//    float source_width_scale = (float(source_size.width()) / float(source_image->width())) * sx;
-//    float source_height_scale = (float(source_size.height()) / float(source_image->height())) * sy;
+    return source_size.scaled(scaled_source_width, scaled_source_height, Qt::KeepAspectRatioByExpanding);
+}
 
-    QImage scaledImg = source_image->scaled(scaled_source_width, scaled_source_height, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-    frame->AddImage(std::make_shared<QImage>(scaledImg));
+// Get the final size of this clip's images (if it doesn't depend on the frame)
+bool Clip::FinalImageSize(int source_width, int source_height, int& width, int& height) const
+{
+    // Effects are applied to the source image (before it's scaled), so they need the full image
+    if (!timeline || openshot::Settings::Instance()->ENABLE_LEGACY_MODE || source_width <= 0 || source_height <= 0
+        || scale_x.GetCount() > 1 || scale_y.GetCount() > 1 || !effects.empty())
+        return false;
+
+    QSize final_size = scale_size(QSize(source_width, source_height), timeline->preview_width, timeline->preview_height, 1);
+    if (final_size.isEmpty())
+        return false;
+
+    width = final_size.width();
+    height = final_size.height();
+    return true;
 }
 
 // Apply apply_waveform image to the source frame (if any)
@@ -1650,6 +1783,73 @@ QTransform Clip::get_transform(std::shared_ptr<Frame> frame, int width, int heig
 	return transform;
 }
 
+// Check if the current reader already has the settings of reader JSON
+bool Clip::HasReaderSettings(const Json::Value& reader_root)
+{
+	// Only readers allocated by this clip are replaced (and timelines are always loaded from file again)
+	if (!allocated_reader || reader_root["type"].asString() == "Timeline")
+		return false;
+
+	// Compare the settings in the JSON with the current settings of the reader (which
+	// is the reader of the file, even if the clip's reader is wrapped in a FrameMapper)
+	const Json::Value current_root = allocated_reader->JsonValue();
+	for (const auto& name : reader_root.getMemberNames()) {
+		const Json::Value& value = reader_root[name];
+		const Json::Value& current_value = current_root[name];
+		if (value.isNumeric() && current_value.isNumeric()) {
+			if (value.asDouble() != current_value.asDouble())
+				return false;
+		} else if (value != current_value) {
+			return false;
+		}
+	}
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("Clip::HasReaderSettings (Keeping reader)", "type", reader_root["type"].asString());
+
+	return true;
+}
+
+// Check if the reader returns the same image for every frame
+bool Clip::has_static_reader()
+{
+	ReaderBase* source = reader;
+	if (source && source->Name() == "FrameMapper")
+		source = static_cast<FrameMapper*>(source)->Reader();
+	if (!source)
+		return false;
+
+	std::string name = source->Name();
+	return name == "QtImageReader" || name == "ImageReader" || name == "QtHtmlReader" || name == "QtTextReader"
+		|| name == "DummyReader";
+}
+
+// Get what the transformed layer of a frame depends on (if it can be reused for other frames)
+bool Clip::get_static_layer_key(std::shared_ptr<Frame> frame, std::shared_ptr<Frame> background_frame,
+								TimelineInfoStruct* options, StaticLayerKey& key)
+{
+	if (!background_frame || !frame->has_image_data || !effects.empty() || waveform || display != FRAME_DISPLAY_NONE
+		|| parentClipObject || parentTrackedObject || !has_static_reader())
+		return false;
+
+	// Transitions and masks on the timeline can change every frame
+	if (timeline && options && !static_cast<Timeline*>(timeline)->Effects().empty())
+		return false;
+
+	// The reader's image (a new image, or a changed one, has a different cache key), the canvas,
+	// and every property used by apply_scale_options and apply_keyframes
+	int64_t number = frame->number;
+	key.image_key = frame->GetImage()->cacheKey();
+	key.values = {
+		double(background_frame->GetWidth()), double(background_frame->GetHeight()),
+		double(scale), double(gravity), double(openshot::Settings::Instance()->ENABLE_LEGACY_MODE),
+		alpha.GetValue(number), scale_x.GetValue(number), scale_y.GetValue(number),
+		location_x.GetValue(number), location_y.GetValue(number), rotation.GetValue(number),
+		shear_x.GetValue(number), shear_y.GetValue(number), origin_x.GetValue(number), origin_y.GetValue(number)
+	};
+	return true;
+}
+
 // Adjust frame number for Clip position and start (which can result in a different number)
 int64_t Clip::adjust_timeline_framenumber(int64_t clip_frame_number) {
 
@@ -24,7 +24,11 @@
 #endif
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+#include <QImage>
 
 #include "AudioLocation.h"
 #include "ClipBase.h"
@@ -124,6 +128,20 @@ namespace openshot {
 		/// (reader member variable itself may have been replaced)
 		openshot::ReaderBase* allocated_reader;
 
+		/// What the transformed layer of a static clip depends on
+		struct StaticLayerKey {
+			qint64 image_key = 0; ///< QImage::cacheKey() of the reader's image
+			std::vector<double> values; ///< Canvas size, scale settings and keyframe values
+			bool operator==(const StaticLayerKey& other) const {
+				return image_key == other.image_key && values == other.values;
+			}
+		};
+
+		/// Last transformed layer of a static clip (i.e. an image or title with constant properties)
+		QImage static_layer;
+		StaticLayerKey static_layer_key;
+		std::mutex static_layer_mutex;
+
 		/// Adjust frame number minimum value
 		int64_t adjust_frame_number_minimum(int64_t frame_number);
 
@@ -138,11 +156,31 @@ namespace openshot {
 
         void apply_scale_options(std::shared_ptr<Frame> frame, std::shared_ptr<openshot::Frame> background_frame);
 
+		/// Get the size of a source image, after the scale mode (against a canvas size) and scale_x / scale_y are applied
+		QSize scale_size(QSize source_size, int canvas_width, int canvas_height, int64_t frame_number) const;
+
+		/// Clear the cached frames of the reader (and the reader it maps, if it's a FrameMapper)
+		void clear_reader_cache();
+
+		/// Get the final image size of the reader's images (returns false if the reader decodes at its own size)
+		bool reader_final_size(int& width, int& height) const;
+
+		/// Clear the cached frames of the reader, if its final image size changed (from an earlier reader_final_size)
+		void clear_resized_reader_cache(bool had_final_size, int old_width, int old_height);
+
         /// Apply waveform image to an openshot::Frame and use an existing background frame (if any)
         void apply_waveform(std::shared_ptr<Frame> frame, std::shared_ptr<Frame> background_frame);
 
 		/// Adjust frame number for Clip position and start (which can result in a different number)
 		int64_t adjust_timeline_framenumber(int64_t clip_frame_number);
+
+		/// Check if the reader returns the same image for every frame (images, titles and colors)
+		bool has_static_reader();
+
+		/// Get what the transformed layer of a frame depends on. Returns false if the layer can't be reused
+		/// for other frames (i.e. the reader isn't static, or effects, waveforms or parent objects are used)
+		bool get_static_layer_key(std::shared_ptr<Frame> frame, std::shared_ptr<Frame> background_frame,
+								  TimelineInfoStruct* options, StaticLayerKey& key);
 		
 		/// Get QTransform from keyframes
 		QTransform get_transform(std::shared_ptr<Frame> frame, int width, int height);
@@ -232,6 +270,10 @@ namespace openshot {
 		/// Look up an effect by ID
 		openshot::EffectBase* GetEffect(const std::string& id);
 
+		/// Check if the current reader already has the settings of reader JSON (so it can be kept open,
+		/// with its cached frames, instead of creating a new reader)
+		bool HasReaderSettings(const Json::Value& reader_root);
+
 		/// @brief Get an openshot::Frame object for a specific frame number of this clip. The image size and number
 		/// of samples match the source reader.
 		///
@@ -265,6 +307,16 @@ namespace openshot {
 		/// such as, if it's a top clip. This info is used to apply global transitions and masks, if needed.
 		std::shared_ptr<openshot::Frame> GetFrame(std::shared_ptr<openshot::Frame> background_frame, int64_t clip_frame_number, openshot::TimelineInfoStruct* options);
 
+		/// @brief Get the final size of this clip's images (its scale mode and scale_x / scale_y, applied against
+		/// the timeline's preview size), so a reader can decode straight to it, instead of the clip scaling each
+		/// image again.
+		/// @returns False if there is no single final size (scale keyframes are animated, the clip has effects, no timeline, or legacy mode)
+		/// @param source_width The width of the reader's images
+		/// @param source_height The height of the reader's images
+		/// @param width Set to the final width
+		/// @param height Set to the final height
+		bool FinalImageSize(int source_width, int source_height, int& width, int& height) const;
+
 		/// Open the internal reader
 		void Open() override;
 
@@ -285,7 +337,7 @@ namespace openshot {
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Get all properties for a specific frame (perfect for a UI to display the current state
 		/// of all properties at any time)
@@ -77,7 +77,7 @@ Json::Value ClipBase::JsonValue() const {
 }
 
 // Load Json::Value into this object
-void ClipBase::SetJsonValue(const Json::Value root) {
+void ClipBase::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["id"].isNull())
@@ -114,7 +114,7 @@ void Color::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Color::SetJsonValue(const Json::Value root) {
+void Color::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["red"].isNull())
@@ -67,7 +67,7 @@ void Coordinate::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Coordinate::SetJsonValue(const Json::Value root) {
+void Coordinate::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["X"].isNull())
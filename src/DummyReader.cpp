@@ -181,7 +181,7 @@ void DummyReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void DummyReader::SetJsonValue(const Json::Value root) {
+void DummyReader::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
@@ -129,7 +129,7 @@ namespace openshot
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Open File - which is called by the constructor automatically
 		void Open() override;
@@ -112,7 +112,7 @@ void EffectBase::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void EffectBase::SetJsonValue(const Json::Value root) {
+void EffectBase::SetJsonValue(const Json::Value& root) {
 
 	if (ParentTimeline()){
 		// Get parent timeline
@@ -97,7 +97,7 @@ namespace openshot
 		virtual std::string Json() const; ///< Generate JSON string of this object
 		virtual void SetJson(const std::string value); ///< Load JSON string into this object
 		virtual Json::Value JsonValue() const; ///< Generate Json::Value for this object
-		virtual void SetJsonValue(const Json::Value root); ///< Load Json::Value into this object
+		virtual void SetJsonValue(const Json::Value& root); ///< Load Json::Value into this object
 
 		virtual std::string Json(int64_t requested_frame) const{
 			return "";
@@ -15,8 +15,17 @@
 
 #include <thread>	// for std::this_thread::sleep_for
 #include <chrono>	// for std::chrono::milliseconds
+#include <algorithm>
 #include <unistd.h>
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
 #include "FFmpegUtilities.h"
 
 #include "FFmpegReader.h"
@@ -75,7 +84,9 @@ FFmpegReader::FFmpegReader(const std::string &path, bool inspect_reader)
 		  current_video_frame(0), packet(NULL), max_concurrent_frames(OPEN_MP_NUM_PROCESSORS), audio_pts(0),
 		  video_pts(0), pFormatCtx(NULL), videoStream(-1), audioStream(-1), pCodecCtx(NULL), aCodecCtx(NULL),
 		  pStream(NULL), aStream(NULL), pFrame(NULL), previous_packet_location{-1,0},
-		  hold_packet(false) {
+		  hold_packet(false), avr(NULL), avr_sample_fmt(AV_SAMPLE_FMT_NONE), avr_channel_layout(0),
+		  keyframe_index_loaded(false), read_ahead_running(false), read_ahead_position(0), read_ahead_direction(1),
+		  read_ahead_stalled(0), read_ahead_frames(0) {
 
 	// Initialize FFMpeg, and register all formats and codecs
 	AV_REGISTER_ALL
@@ -101,6 +112,7 @@ FFmpegReader::~FFmpegReader() {
 	if (is_open)
 		// Auto close reader if not already done
 		Close();
+	StopReadAhead();
 }
 
 // This struct holds the associated video frame and starting sample # for an audio packet.
@@ -558,9 +570,13 @@ void FFmpegReader::Open() {
 		previous_packet_location.frame = -1;
 		previous_packet_location.sample_start = 0;
 
-		// Adjust cache size based on size of frame and audio
+		// Adjust cache size based on size of frame and audio (the final cache also holds the frames decoded ahead)
+		read_ahead_frames = std::max(openshot::Settings::Instance()->READ_AHEAD_FRAMES, 0);
 		working_cache.SetMaxBytesFromInfo(max_concurrent_frames * info.fps.ToDouble() * 2, info.width, info.height, info.sample_rate, info.channels);
-		final_cache.SetMaxBytesFromInfo(max_concurrent_frames * 2, info.width, info.height, info.sample_rate, info.channels);
+		final_cache.SetMaxBytesFromInfo(std::max(max_concurrent_frames, read_ahead_frames) * 2, info.width, info.height, info.sample_rate, info.channels);
+
+		// Index the keyframes of the video stream (if enabled)
+		LoadKeyframeIndex();
 
 		// Scan PTS for any offsets (i.e. non-zero starting streams). At least 1 stream must start at zero timestamp.
 		// This method allows us to shift timestamps to ensure at least 1 stream is starting at zero.
@@ -580,12 +596,19 @@ void FFmpegReader::Open() {
 		if (!is_seeking) {
 			Seek(1);
 		}
+
+		// Start decoding ahead (if enabled)
+		StartReadAhead();
 	}
 }
 
 void FFmpegReader::Close() {
 	// Close all objects, if reader is 'open'
 	if (is_open) {
+		// Stop decoding ahead (unless the read-ahead thread is closing the reader itself, to seek)
+		if (std::this_thread::get_id() != read_ahead_thread.get_id())
+			StopReadAhead();
+
 		// Prevent async calls to the following code
 		const std::lock_guard<std::recursive_mutex> lock(getFrameMutex);
 
@@ -642,6 +665,14 @@ void FFmpegReader::Close() {
 			AV_FREE_CONTEXT(aCodecCtx);
 		}
 
+		// Free the audio resampler
+		if (avr) {
+			SWR_CLOSE(avr);
+			SWR_FREE(&avr);
+			avr = NULL;
+		}
+		audio_planes.clear();
+
 		// Clear final cache
 		final_cache.Clear();
 		working_cache.Clear();
@@ -909,8 +940,16 @@ std::shared_ptr<Frame> FFmpegReader::GetFrame(int64_t requested_frame) {
 	// Debug output
 	ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::GetFrame", "requested_frame", requested_frame, "last_frame", last_frame);
 
+	// Move the read-ahead position (and direction) to this frame
+	if (read_ahead_running && std::this_thread::get_id() != read_ahead_thread.get_id()) {
+		int64_t previous_frame = read_ahead_position.exchange(requested_frame);
+		if (requested_frame != previous_frame)
+			read_ahead_direction = (requested_frame > previous_frame) ? 1 : -1;
+		read_ahead_condition.notify_one();
+	}
+
 	// Check the cache for this frame
-	std::shared_ptr<Frame> frame = final_cache.GetFrame(requested_frame);
+	std::shared_ptr<Frame> frame = GetCachedFrame(requested_frame);
 	if (frame) {
 		// Debug output
 		ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::GetFrame", "returned cached frame", requested_frame);
@@ -923,7 +962,7 @@ std::shared_ptr<Frame> FFmpegReader::GetFrame(int64_t requested_frame) {
 		const std::lock_guard<std::recursive_mutex> lock(getFrameMutex);
 
 		// Check the cache a 2nd time (due to the potential previous lock)
-		frame = final_cache.GetFrame(requested_frame);
+		frame = GetCachedFrame(requested_frame);
 		if (frame) {
 			// Debug output
 			ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::GetFrame", "returned cached frame on 2nd look", requested_frame);
@@ -933,9 +972,14 @@ std::shared_ptr<Frame> FFmpegReader::GetFrame(int64_t requested_frame) {
 			// Reset seek count
 			seek_count = 0;
 
-			// Are we within X frames of the requested frame?
+			// Are we within X frames of the requested frame? (or is there no keyframe to seek to in between)
 			int64_t diff = requested_frame - last_frame;
-			if (diff >= 1 && diff <= 20) {
+			bool keyframe_in_between = true;
+			if (diff > 20 && last_frame > 0 && !keyframe_index.empty() && !is_seeking) {
+				auto keyframe = FindKeyframe(requested_frame);
+				keyframe_in_between = KeyframeToFrame(keyframe->pts) > last_frame;
+			}
+			if (diff >= 1 && (diff <= 20 || !keyframe_in_between)) {
 				// Continue walking the stream
 				frame = ReadStream(requested_frame);
 			} else {
@@ -958,6 +1002,92 @@ std::shared_ptr<Frame> FFmpegReader::GetFrame(int64_t requested_frame) {
 	}
 }
 
+// Start the read-ahead thread (if enabled)
+void FFmpegReader::StartReadAhead() {
+	if (read_ahead_frames <= 0 || read_ahead_thread.joinable())
+		return;
+
+	read_ahead_position = 0;
+	read_ahead_direction = 1;
+	read_ahead_stalled = 0;
+	read_ahead_running = true;
+	read_ahead_thread = std::thread(&FFmpegReader::ReadAhead, this);
+}
+
+// Stop the read-ahead thread (if running)
+void FFmpegReader::StopReadAhead() {
+	if (!read_ahead_thread.joinable())
+		return;
+
+	{
+		const std::lock_guard<std::mutex> lock(read_ahead_mutex);
+		read_ahead_running = false;
+	}
+	read_ahead_condition.notify_all();
+	read_ahead_thread.join();
+}
+
+// Get the next frame the read-ahead thread should decode (or 0 if all of them are cached)
+int64_t FFmpegReader::NextReadAheadFrame() {
+	int64_t position = read_ahead_position;
+	if (position <= 0 || position == read_ahead_stalled)
+		return 0;
+
+	if (read_ahead_direction > 0) {
+		// Forwards: the next frames after the requested frame
+		int64_t last = std::min(position + read_ahead_frames, info.video_length);
+		for (int64_t number = position + 1; number <= last; number++) {
+			if (!final_cache.Contains(number))
+				return number;
+		}
+	} else {
+		// Backwards: the frames before the requested frame, decoded forwards from the
+		// earliest missing one (so the block only needs one seek)
+		int64_t first = std::max(position - read_ahead_frames, int64_t(1));
+		for (int64_t number = first; number < position; number++) {
+			if (!final_cache.Contains(number))
+				return number;
+		}
+	}
+	return 0;
+}
+
+// Decode frames ahead of the requested frames, one at a time, so GetFrame() calls from other
+// threads only wait for (at most) one frame. Seeks pause this thread (it can't lock the reader
+// while a seek is in progress), and it resumes from the new position afterwards.
+void FFmpegReader::ReadAhead() {
+	while (read_ahead_running) {
+		// Wait for frames to decode
+		int64_t number = 0;
+		{
+			std::unique_lock<std::mutex> lock(read_ahead_mutex);
+			read_ahead_condition.wait_for(lock, std::chrono::milliseconds(100), [this, &number] {
+				number = read_ahead_running ? NextReadAheadFrame() : 0;
+				return !read_ahead_running || number > 0;
+			});
+		}
+		if (!read_ahead_running || number <= 0)
+			continue;
+
+		// Don't block while another thread reads (or closes) this reader
+		std::unique_lock<std::recursive_mutex> lock(getFrameMutex, std::try_to_lock);
+		if (!lock.owns_lock()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if (!is_open || number != NextReadAheadFrame())
+			continue;
+
+		try {
+			GetFrame(number);
+		} catch (const ExceptionBase&) {
+			// Stop decoding ahead until other frames are requested
+			read_ahead_stalled = read_ahead_position;
+			ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::ReadAhead (failed)", "number", number);
+		}
+	}
+}
+
 // Read the stream until we find the requested Frame
 std::shared_ptr<Frame> FFmpegReader::ReadStream(int64_t requested_frame) {
 	// Allocate video frame
@@ -1350,51 +1480,10 @@ bool FFmpegReader::CheckSeek(bool is_video) {
 	return is_seeking;
 }
 
-// Process a video packet
-void FFmpegReader::ProcessVideoPacket(int64_t requested_frame) {
-	// Get the AVFrame from the current packet
-	// This sets the video_pts to the correct timestamp
-	int frame_finished = GetAVFrame();
-
-	// Check if the AVFrame is finished and set it
-	if (!frame_finished) {
-		// No AVFrame decoded yet, bail out
-		if (pFrame) {
-			RemoveAVFrame(pFrame);
-		}
-		return;
-	}
-
-	// Calculate current frame #
-	int64_t current_frame = ConvertVideoPTStoFrame(video_pts);
-
-	// Track 1st video packet after a successful seek
-	if (!seek_video_frame_found && is_seeking)
-		seek_video_frame_found = current_frame;
-
-	// Create or get the existing frame object. Requested frame needs to be created
-	// in working_cache at least once. Seek can clear the working_cache, so we must
-	// add the requested frame back to the working_cache here. If it already exists,
-	// it will be moved to the top of the working_cache.
-	working_cache.Add(CreateFrame(requested_frame));
-
-	// Debug output
-	ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::ProcessVideoPacket (Before)", "requested_frame", requested_frame, "current_frame", current_frame);
-
-	// Init some things local (for OpenMP)
-	PixelFormat pix_fmt = AV_GET_CODEC_PIXEL_FORMAT(pStream, pCodecCtx);
-	int height = info.height;
-	int width = info.width;
-	int64_t video_length = info.video_length;
-
-	// Create variables for a RGB Frame (since most videos are not in RGB, we must convert it)
-	AVFrame *pFrameRGB = nullptr;
-	uint8_t *buffer = nullptr;
-
-	// Allocate an AVFrame structure
-	pFrameRGB = AV_ALLOCATE_FRAME();
-	if (pFrameRGB == nullptr)
-		throw OutOfMemory("Failed to allocate frame buffer", path);
+// Get the size to decode images at for a clip
+bool FFmpegReader::ClipImageSize(Clip* parent, int& width, int& height) {
+	width = info.width;
+	height = info.height;
 
 	// Determine the max size of this source image (based on the timeline's size, the scaling mode,
 	// and the scaling keyframes). This is a performance improvement, to keep the images as small as possible,
@@ -1404,7 +1493,6 @@ void FFmpegReader::ProcessVideoPacket(int64_t requested_frame) {
 	int max_width = info.width;
 	int max_height = info.height;
 
-	Clip *parent = static_cast<Clip *>(ParentClip());
 	if (parent) {
 		if (parent->ParentTimeline()) {
 			// Set max width/height based on parent clip's timeline (if attached to a timeline)
@@ -1451,9 +1539,12 @@ void FFmpegReader::ProcessVideoPacket(int64_t requested_frame) {
 		}
 	}
 
+	// Decode straight to the clip's final image size, when it doesn't change from frame to frame
+	// (so this is the only time the image is scaled)
+	bool is_final_size = parent && parent->FinalImageSize(info.width, info.height, width, height);
+
 	// Determine if image needs to be scaled (for performance reasons)
-	int original_height = height;
-	if (max_width != 0 && max_height != 0 && max_width < width && max_height < height) {
+	if (!is_final_size && max_width != 0 && max_height != 0 && max_width < width && max_height < height) {
 		// Override width and height (but maintain aspect ratio)
 		float ratio = float(width) / float(height);
 		int possible_width = round(max_height * ratio);
@@ -1470,6 +1561,113 @@ void FFmpegReader::ProcessVideoPacket(int64_t requested_frame) {
 		}
 	}
 
+
+	return is_final_size;
+}
+
+// Get the size to decode images at (for the parent clip, or the largest size any shared clip needs)
+bool FFmpegReader::DecodeSize(int& width, int& height) {
+	Clip *parent = static_cast<Clip *>(ParentClip());
+	if (parent || !info.has_video)
+		return ClipImageSize(parent, width, height);
+
+	std::vector<ClipBase*> clips;
+	{
+		const std::lock_guard<std::mutex> lock(shared_clips_mutex);
+		clips = shared_clips;
+	}
+
+	// Decode at the largest size of any clip (each clip scales its own images), or the full size
+	width = 0;
+	height = 0;
+	for (auto clip : clips) {
+		int clip_width = 0;
+		int clip_height = 0;
+		ClipImageSize(static_cast<Clip *>(clip), clip_width, clip_height);
+		if (int64_t(clip_width) * clip_height > int64_t(width) * height) {
+			width = clip_width;
+			height = clip_height;
+		}
+	}
+	if (clips.empty())
+		ClipImageSize(NULL, width, height);
+	return false;
+}
+
+// Set the clips decoding from this reader through a shared MediaSource
+void FFmpegReader::SharedClips(const std::vector<ClipBase*>& clips) {
+	const std::lock_guard<std::mutex> lock(shared_clips_mutex);
+	shared_clips = clips;
+}
+
+// Get a frame from the final cache (removing it, if its image is smaller than the images decoded now)
+std::shared_ptr<Frame> FFmpegReader::GetCachedFrame(int64_t requested_frame) {
+	std::shared_ptr<Frame> frame = final_cache.GetFrame(requested_frame);
+	if (!frame || !info.has_video || !frame->has_image_data)
+		return frame;
+
+	// Frames decoded for a smaller clip (which shared this reader) would be scaled up (blurry)
+	int width = 0;
+	int height = 0;
+	DecodeSize(width, height);
+	std::shared_ptr<QImage> image = frame->GetImage();
+	if (image->width() < width && image->height() < height) {
+		final_cache.Remove(requested_frame);
+		return std::shared_ptr<Frame>();
+	}
+	return frame;
+}
+
+// Process a video packet
+void FFmpegReader::ProcessVideoPacket(int64_t requested_frame) {
+	// Get the AVFrame from the current packet
+	// This sets the video_pts to the correct timestamp
+	int frame_finished = GetAVFrame();
+
+	// Check if the AVFrame is finished and set it
+	if (!frame_finished) {
+		// No AVFrame decoded yet, bail out
+		if (pFrame) {
+			RemoveAVFrame(pFrame);
+		}
+		return;
+	}
+
+	// Calculate current frame #
+	int64_t current_frame = ConvertVideoPTStoFrame(video_pts);
+
+	// Track 1st video packet after a successful seek
+	if (!seek_video_frame_found && is_seeking)
+		seek_video_frame_found = current_frame;
+
+	// Create or get the existing frame object. Requested frame needs to be created
+	// in working_cache at least once. Seek can clear the working_cache, so we must
+	// add the requested frame back to the working_cache here. If it already exists,
+	// it will be moved to the top of the working_cache.
+	working_cache.Add(CreateFrame(requested_frame));
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::ProcessVideoPacket (Before)", "requested_frame", requested_frame, "current_frame", current_frame);
+
+	// Init some things local (for OpenMP)
+	PixelFormat pix_fmt = AV_GET_CODEC_PIXEL_FORMAT(pStream, pCodecCtx);
+	int height = info.height;
+	int width = info.width;
+	int64_t video_length = info.video_length;
+
+	// Create variables for a RGB Frame (since most videos are not in RGB, we must convert it)
+	AVFrame *pFrameRGB = nullptr;
+	uint8_t *buffer = nullptr;
+
+	// Allocate an AVFrame structure
+	pFrameRGB = AV_ALLOCATE_FRAME();
+	if (pFrameRGB == nullptr)
+		throw OutOfMemory("Failed to allocate frame buffer", path);
+
+	// Determine the size of this image (based on the clips decoding from this reader)
+	int original_height = height;
+	bool is_final_size = DecodeSize(width, height);
+
 	// Determine required buffer size and allocate buffer
 	const int bytes_per_pixel = 4;
 	int buffer_size = (width * height * bytes_per_pixel) + 128;
@@ -1479,7 +1677,7 @@ void FFmpegReader::ProcessVideoPacket(int64_t requested_frame) {
 	AV_COPY_PICTURE_DATA(pFrameRGB, buffer, PIX_FMT_RGBA, width, height);
 
 	int scale_mode = SWS_FAST_BILINEAR;
-	if (openshot::Settings::Instance()->HIGH_QUALITY_SCALING) {
+	if (openshot::Settings::Instance()->HIGH_QUALITY_SCALING || is_final_size) {
 		scale_mode = SWS_BICUBIC;
 	}
 	SwsContext *img_convert_ctx = sws_getContext(info.width, info.height, AV_GET_CODEC_PIXEL_FORMAT(pStream, pCodecCtx), width,
@@ -1641,101 +1839,68 @@ void FFmpegReader::ProcessAudioPacket(int64_t requested_frame) {
 		}
 	}
 
-	// Allocate audio buffer
-	int16_t *audio_buf = new int16_t[AVCODEC_MAX_AUDIO_FRAME_SIZE + MY_INPUT_BUFFER_PADDING_SIZE];
-
 	ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::ProcessAudioPacket (ReSample)",
 										  "packet_samples", packet_samples,
 										  "info.channels", info.channels,
 										  "info.sample_rate", info.sample_rate,
 										  "aCodecCtx->sample_fmt", AV_GET_SAMPLE_FORMAT(aStream, aCodecCtx),
-										  "AV_SAMPLE_FMT_S16", AV_SAMPLE_FMT_S16);
-
-	// Create output frame
-	AVFrame *audio_converted = AV_ALLOCATE_FRAME();
-	AV_RESET_FRAME(audio_converted);
-	audio_converted->nb_samples = audio_frame->nb_samples;
-	av_samples_alloc(audio_converted->data, audio_converted->linesize, info.channels, audio_frame->nb_samples, AV_SAMPLE_FMT_S16, 0);
-
-	SWRCONTEXT *avr = NULL;
-	int nb_samples = 0;
-
-	// setup resample context
-	avr = SWR_ALLOC();
-	av_opt_set_int(avr, "in_channel_layout", AV_GET_CODEC_ATTRIBUTES(aStream, aCodecCtx)->channel_layout, 0);
-	av_opt_set_int(avr, "out_channel_layout", AV_GET_CODEC_ATTRIBUTES(aStream, aCodecCtx)->channel_layout, 0);
-	av_opt_set_int(avr, "in_sample_fmt", AV_GET_SAMPLE_FORMAT(aStream, aCodecCtx), 0);
-	av_opt_set_int(avr, "out_sample_fmt", AV_SAMPLE_FMT_S16, 0);
-	av_opt_set_int(avr, "in_sample_rate", info.sample_rate, 0);
-	av_opt_set_int(avr, "out_sample_rate", info.sample_rate, 0);
-	av_opt_set_int(avr, "in_channels", info.channels, 0);
-	av_opt_set_int(avr, "out_channels", info.channels, 0);
-	SWR_INIT(avr);
-
-	// Convert audio samples
-	nb_samples = SWR_CONVERT(avr,	// audio resample context
-							 audio_converted->data,		  // output data pointers
-							 audio_converted->linesize[0],   // output plane size, in bytes. (0 if unknown)
-							 audio_converted->nb_samples,	// maximum number of samples that the output buffer can hold
-							 audio_frame->data,			  // input data pointers
-							 audio_frame->linesize[0],	   // input plane size, in bytes (0 if unknown)
-							 audio_frame->nb_samples);	   // number of input samples to convert
-
-	// Copy audio samples over original samples
-	memcpy(audio_buf,
-		audio_converted->data[0],
-		static_cast<size_t>(audio_converted->nb_samples)
-		* av_get_bytes_per_sample(AV_SAMPLE_FMT_S16)
-		* info.channels);
-
-	// Deallocate resample buffer
-	SWR_CLOSE(avr);
-	SWR_FREE(&avr);
-	avr = NULL;
-
-	// Free AVFrames
-	av_free(audio_converted->data[0]);
-	AV_FREE_FRAME(&audio_converted);
+										  "AV_SAMPLE_FMT_FLTP", AV_SAMPLE_FMT_FLTP);
+
+	// Get the decoded samples as planar floats (one buffer per channel)
+	int channel_buffer_size = packet_samples / info.channels;
+	std::vector<const float *> channel_buffers(info.channels);
+	AVSampleFormat in_sample_fmt = (AVSampleFormat) AV_GET_SAMPLE_FORMAT(aStream, aCodecCtx);
+	if (in_sample_fmt == AV_SAMPLE_FMT_FLTP && AV_GET_CODEC_ATTRIBUTES(aStream, aCodecCtx)->channels == info.channels) {
+		// The decoder already outputs planar floats: use its planes as they are
+		for (int channel = 0; channel < info.channels; channel++)
+			channel_buffers[channel] = (const float *) audio_frame->extended_data[channel];
+	} else {
+		// Convert to planar floats with the stream's resampler (created again only if the input format changes)
+		int64_t in_channel_layout = AV_GET_CODEC_ATTRIBUTES(aStream, aCodecCtx)->channel_layout;
+		if (!avr || avr_sample_fmt != in_sample_fmt || avr_channel_layout != in_channel_layout) {
+			if (avr) {
+				SWR_CLOSE(avr);
+				SWR_FREE(&avr);
+			}
+			avr = SWR_ALLOC();
+			av_opt_set_int(avr, "in_channel_layout", in_channel_layout, 0);
+			av_opt_set_int(avr, "out_channel_layout", in_channel_layout, 0);
+			av_opt_set_int(avr, "in_sample_fmt", in_sample_fmt, 0);
+			av_opt_set_int(avr, "out_sample_fmt", AV_SAMPLE_FMT_FLTP, 0);
+			av_opt_set_int(avr, "in_sample_rate", info.sample_rate, 0);
+			av_opt_set_int(avr, "out_sample_rate", info.sample_rate, 0);
+			av_opt_set_int(avr, "in_channels", info.channels, 0);
+			av_opt_set_int(avr, "out_channels", info.channels, 0);
+			SWR_INIT(avr);
+			avr_sample_fmt = in_sample_fmt;
+			avr_channel_layout = in_channel_layout;
+		}
+
+		// Convert straight into the channel buffers
+		audio_planes.resize(static_cast<size_t>(channel_buffer_size) * info.channels);
+		std::vector<uint8_t *> planes(info.channels);
+		for (int channel = 0; channel < info.channels; channel++) {
+			planes[channel] = (uint8_t *) (audio_planes.data() + channel * channel_buffer_size);
+			channel_buffers[channel] = audio_planes.data() + channel * channel_buffer_size;
+		}
+		SWR_CONVERT(avr,						// audio resample context
+					planes.data(),				// output data pointers
+					0,							// output plane size, in bytes. (0 if unknown)
+					channel_buffer_size,		// maximum number of samples that the output buffer can hold
+					audio_frame->extended_data,	// input data pointers
+					audio_frame->linesize[0],	// input plane size, in bytes (0 if unknown)
+					audio_frame->nb_samples);	// number of input samples to convert
+	}
 
 	int64_t starting_frame_number = -1;
 	bool partial_frame = true;
 	for (int channel_filter = 0; channel_filter < info.channels; channel_filter++) {
-		// Array of floats (to hold samples for each channel)
 		starting_frame_number = location.frame;
-		int channel_buffer_size = packet_samples / info.channels;
-		float *channel_buffer = new float[channel_buffer_size];
-
-		// Init buffer array
-		for (int z = 0; z < channel_buffer_size; z++)
-			channel_buffer[z] = 0.0f;
-
-		// Loop through all samples and add them to our Frame based on channel.
-		// Toggle through each channel number, since channel data is stored like (left right left right)
-		int channel = 0;
-		int position = 0;
-		for (int sample = 0; sample < packet_samples; sample++) {
-			// Only add samples for current channel
-			if (channel_filter == channel) {
-				// Add sample (convert from (-32768 to 32768)  to (-1.0 to 1.0))
-				channel_buffer[position] = audio_buf[sample] * (1.0f / (1 << 15));
-
-				// Increment audio position
-				position++;
-			}
-
-			// increment channel (if needed)
-			if ((channel + 1) < info.channels)
-				// move to next channel
-				channel++;
-			else
-				// reset channel
-				channel = 0;
-		}
 
 		// Loop through samples, and add them to the correct frames
 		int start = location.sample_start;
 		int remaining_samples = channel_buffer_size;
-		float *iterate_channel_buffer = channel_buffer;	// pointer to channel buffer
+		const float *iterate_channel_buffer = channel_buffers[channel_filter];	// pointer to channel buffer
 		while (remaining_samples > 0) {
 			// Get Samples per frame (for this frame number)
 			int samples_per_frame = Frame::GetSamplesPerFrame(starting_frame_number,
@@ -1784,17 +1949,8 @@ void FFmpegReader::ProcessAudioPacket(int64_t requested_frame) {
 			// Reset starting sample #
 			start = 0;
 		}
-
-		// clear channel buffer
-		delete[] channel_buffer;
-		channel_buffer = NULL;
-		iterate_channel_buffer = NULL;
 	}
 
-	// Clean up some arrays
-	delete[] audio_buf;
-	audio_buf = NULL;
-
 	// Free audio frame
 	AV_FREE_FRAME(&audio_frame);
 
@@ -1850,6 +2006,10 @@ void FFmpegReader::Seek(int64_t requested_frame) {
 	// Increment seek count
 	seek_count++;
 
+	// Jump straight to the keyframe before the requested frame (if the keyframes are indexed)
+	if (enable_seek && SeekKeyframe(requested_frame))
+		return;
+
 	// If seeking near frame 1, we need to close and re-open the file (this is more reliable than seeking)
 	int buffer_amount = std::max(max_concurrent_frames, 8);
 	if (requested_frame - buffer_amount < 20) {
@@ -1952,6 +2112,176 @@ void FFmpegReader::Seek(int64_t requested_frame) {
 	}
 }
 
+// Seek straight to the last keyframe before a specific Frame, using the keyframe index
+bool FFmpegReader::SeekKeyframe(int64_t requested_frame) {
+	if (keyframe_index.empty() || !info.has_video || HasAlbumArt())
+		return false;
+
+	// Find the keyframe. Requests before the 2nd keyframe start at the beginning of the stream
+	// (which replaces closing and re-opening the file).
+	auto keyframe = FindKeyframe(requested_frame);
+	bool from_start = (keyframe == keyframe_index.begin());
+
+	// Formats with timestamp discontinuities (i.e. MPEG-TS) are more reliable to seek by byte offset
+	int result = -1;
+	if ((pFormatCtx->iformat->flags & AVFMT_TS_DISCONT) && !(pFormatCtx->iformat->flags & AVFMT_NO_BYTE_SEEK) && keyframe->pos >= 0)
+		result = av_seek_frame(pFormatCtx, videoStream, keyframe->pos, AVSEEK_FLAG_BYTE);
+	if (result < 0)
+		result = av_seek_frame(pFormatCtx, videoStream, keyframe->pts, AVSEEK_FLAG_BACKWARD);
+	if (result < 0)
+		return false;
+
+	ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::SeekKeyframe",
+										  "requested_frame", requested_frame,
+										  "keyframe_pts", keyframe->pts,
+										  "keyframe_pos", keyframe->pos,
+										  "keyframe_number", KeyframeToFrame(keyframe->pts),
+										  "from_start", from_start);
+
+	// Flush audio & video buffers
+	if (info.has_audio)
+		avcodec_flush_buffers(aCodecCtx);
+	if (info.has_video)
+		avcodec_flush_buffers(pCodecCtx);
+
+	// Reset previous audio location to zero
+	previous_packet_location.frame = -1;
+	previous_packet_location.sample_start = 0;
+
+	// init seek flags (the keyframe is before the requested frame, so no other seek is needed,
+	// unless the audio packets start after it)
+	is_video_seek = true;
+	is_seeking = !from_start;
+	if (seek_count == 1) {
+		// Don't redefine this on multiple seek attempts for a specific frame
+		seeking_pts = keyframe->pts;
+		seeking_frame = from_start ? 1 : requested_frame;
+	}
+	seek_audio_frame_found = 0; // used to detect which frames to throw away after a seek
+	seek_video_frame_found = 0; // used to detect which frames to throw away after a seek
+
+	return true;
+}
+
+// Find the last indexed keyframe before a specific Frame (or the first keyframe, if none are before it)
+std::vector<FFmpegReader::KeyframeIndexEntry>::const_iterator FFmpegReader::FindKeyframe(int64_t requested_frame) {
+	auto keyframe = std::partition_point(keyframe_index.cbegin(), keyframe_index.cend(),
+		[this, requested_frame](const KeyframeIndexEntry &entry) { return KeyframeToFrame(entry.pts) < requested_frame; });
+	if (keyframe != keyframe_index.cbegin())
+		--keyframe;
+	return keyframe;
+}
+
+// Convert the PTS of a keyframe into a Frame Number
+int64_t FFmpegReader::KeyframeToFrame(int64_t pts) {
+	double video_seconds = (double(pts) * info.video_timebase.ToDouble()) + pts_offset_seconds;
+	return round(video_seconds * info.fps.ToDouble()) + 1;
+}
+
+// Path of the keyframe index file of a media file (or an empty string, if indexes aren't saved)
+static QString keyframe_index_path(const std::string &path) {
+	QString folder = QString::fromStdString(Settings::Instance()->PATH_KEYFRAME_INDEX);
+	if (folder.isEmpty())
+		return QString();
+
+	QString source = QFileInfo(QString::fromStdString(path)).absoluteFilePath();
+	QByteArray hash = QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Md5).toHex();
+	return QDir(folder).filePath(QString::fromLatin1(hash) + ".keyframes");
+}
+
+// Keyframe index files start with these values
+static const quint32 KEYFRAME_INDEX_MAGIC = 0x4f534b49; // "OSKI"
+static const quint32 KEYFRAME_INDEX_VERSION = 1;
+
+// Build the keyframe index of the video stream (or load it from its index file)
+void FFmpegReader::LoadKeyframeIndex() {
+	// The index is kept when closing the reader, so this only happens on the first Open()
+	if (keyframe_index_loaded || !Settings::Instance()->ENABLE_KEYFRAME_INDEX || videoStream < 0 || HasAlbumArt())
+		return;
+	keyframe_index_loaded = true;
+
+	// Index files are only valid for the same version of the media file
+	QFileInfo source(QString::fromStdString(path));
+	qint64 source_size = source.size();
+	qint64 source_modified = source.lastModified().toMSecsSinceEpoch();
+	QString index_path = keyframe_index_path(path);
+
+	// Load the index file (if any)
+	if (!index_path.isEmpty()) {
+		QFile index_file(index_path);
+		if (index_file.open(QIODevice::ReadOnly)) {
+			QDataStream in(&index_file);
+			quint32 magic = 0, version = 0, count = 0;
+			qint64 size = 0, modified = 0;
+			qint32 stream = -1;
+			in >> magic >> version >> size >> modified >> stream >> count;
+			if (in.status() == QDataStream::Ok && magic == KEYFRAME_INDEX_MAGIC && version == KEYFRAME_INDEX_VERSION
+				&& size == source_size && modified == source_modified && stream == videoStream
+				&& count <= index_file.size() / (2 * sizeof(qint64))) {
+				keyframe_index.resize(count);
+				for (KeyframeIndexEntry &entry : keyframe_index) {
+					qint64 pts = 0, pos = 0;
+					in >> pts >> pos;
+					entry.pts = pts;
+					entry.pos = pos;
+				}
+				if (in.status() == QDataStream::Ok) {
+					ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::LoadKeyframeIndex (loaded)",
+														  "keyframes", keyframe_index.size());
+					return;
+				}
+			}
+			keyframe_index.clear();
+		}
+	}
+
+	// Scan the video packets, with a separate format context (so the position of this reader doesn't change).
+	// Packets are only demuxed, not decoded.
+	AVFormatContext *index_ctx = NULL;
+	if (avformat_open_input(&index_ctx, path.c_str(), NULL, NULL) != 0)
+		return;
+	if (avformat_find_stream_info(index_ctx, NULL) >= 0 && videoStream < (int) index_ctx->nb_streams) {
+		for (unsigned int i = 0; i < index_ctx->nb_streams; i++) {
+			if ((int) i != videoStream)
+				index_ctx->streams[i]->discard = AVDISCARD_ALL;
+		}
+
+		AVPacket *index_packet = new AVPacket();
+		while (av_read_frame(index_ctx, index_packet) >= 0) {
+			if (index_packet->stream_index == videoStream && (index_packet->flags & AV_PKT_FLAG_KEY)) {
+				int64_t pts = index_packet->pts;
+				if (pts == AV_NOPTS_VALUE)
+					pts = index_packet->dts;
+				if (pts != AV_NOPTS_VALUE)
+					keyframe_index.push_back({pts, index_packet->pos});
+			}
+			AV_FREE_PACKET(index_packet);
+		}
+		delete index_packet;
+	}
+	avformat_close_input(&index_ctx);
+
+	std::sort(keyframe_index.begin(), keyframe_index.end(),
+		[](const KeyframeIndexEntry &a, const KeyframeIndexEntry &b) { return a.pts < b.pts; });
+
+	ZmqLogger::Instance()->AppendDebugMethod("FFmpegReader::LoadKeyframeIndex (scanned)",
+										  "keyframes", keyframe_index.size());
+
+	// Save the index file
+	if (!index_path.isEmpty() && !keyframe_index.empty()) {
+		QDir().mkpath(QFileInfo(index_path).absolutePath());
+		QSaveFile index_file(index_path);
+		if (index_file.open(QIODevice::WriteOnly)) {
+			QDataStream out(&index_file);
+			out << KEYFRAME_INDEX_MAGIC << KEYFRAME_INDEX_VERSION << source_size << source_modified
+				<< qint32(videoStream) << quint32(keyframe_index.size());
+			for (const KeyframeIndexEntry &entry : keyframe_index)
+				out << qint64(entry.pts) << qint64(entry.pos);
+			index_file.commit();
+		}
+	}
+}
+
 // Get the PTS for the current video packet
 int64_t FFmpegReader::GetPacketPTS() {
 	if (packet) {
@@ -2441,7 +2771,7 @@ void FFmpegReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void FFmpegReader::SetJsonValue(const Json::Value root) {
+void FFmpegReader::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
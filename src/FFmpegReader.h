@@ -21,11 +21,16 @@
 // Include FFmpeg headers and macros
 #include "FFmpegUtilities.h"
 
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
 #include <ctime>
 #include <iostream>
+#include <mutex>
 #include <stdio.h>
 #include <memory>
+#include <thread>
+#include <vector>
 #include "AudioLocation.h"
 #include "CacheMemory.h"
 #include "Clip.h"
@@ -120,6 +125,32 @@ namespace openshot {
 		CacheMemory working_cache;
 		AudioLocation previous_packet_location;
 
+		SWRCONTEXT *avr; ///< Audio resampler (to planar float), kept while the decoded sample format doesn't change
+		AVSampleFormat avr_sample_fmt;
+		int64_t avr_channel_layout;
+		std::vector<float> audio_planes; ///< Planar float samples of the last converted audio frame
+
+		/// A keyframe of the video stream
+		struct KeyframeIndexEntry {
+			int64_t pts; ///< Timestamp of the keyframe (in the video stream's timebase)
+			int64_t pos; ///< Byte offset of the keyframe's packet (or -1 if unknown)
+		};
+		std::vector<KeyframeIndexEntry> keyframe_index; ///< Keyframes of the video stream, sorted by timestamp
+		bool keyframe_index_loaded;
+
+		// Read-ahead (decoding the next frames on a separate thread, see Settings::READ_AHEAD_FRAMES)
+		std::thread read_ahead_thread;
+		std::mutex read_ahead_mutex;
+		std::condition_variable read_ahead_condition;
+		std::atomic<bool> read_ahead_running;
+		std::atomic<int64_t> read_ahead_position; ///< Last frame requested by GetFrame() (from other threads)
+		std::atomic<int> read_ahead_direction; ///< 1 when frames are requested forwards, -1 backwards
+		int64_t read_ahead_stalled; ///< Position at which decoding ahead failed (so it isn't retried)
+		int read_ahead_frames;
+
+		std::vector<openshot::ClipBase*> shared_clips; ///< Clips decoding from this reader through a shared MediaSource
+		std::mutex shared_clips_mutex;
+
 		// DEBUG VARIABLES (FOR AUDIO ISSUES)
 		int prev_samples;
 		int64_t prev_pts;
@@ -173,6 +204,16 @@ namespace openshot {
 		/// Convert Video PTS into Frame Number
 		int64_t ConvertVideoPTStoFrame(int64_t pts);
 
+		/// Get the size to decode images at for a clip (returns true if it's the clip's final image size)
+		bool ClipImageSize(openshot::Clip* clip, int& width, int& height);
+
+		/// Get the size to decode images at (for the parent clip, or the largest size any shared clip needs).
+		/// Returns true if it's the parent clip's final image size.
+		bool DecodeSize(int& width, int& height);
+
+		/// Get a frame from the final cache (removing it, if its image is smaller than the images decoded now)
+		std::shared_ptr<openshot::Frame> GetCachedFrame(int64_t requested_frame);
+
 		/// Create a new Frame (or return an existing one) and add it to the working queue.
 		std::shared_ptr<openshot::Frame> CreateFrame(int64_t requested_frame);
 
@@ -191,6 +232,9 @@ namespace openshot {
 		/// Check if there's an album art
 		bool HasAlbumArt();
 
+		/// Build the keyframe index of the video stream (or load it from its index file), if enabled in openshot::Settings
+		void LoadKeyframeIndex();
+
 		/// Remove partial frames due to seek
 		bool IsPartialFrame(int64_t requested_frame);
 
@@ -200,6 +244,12 @@ namespace openshot {
 		/// Process an audio packet
 		void ProcessAudioPacket(int64_t requested_frame);
 
+		/// Get the next frame the read-ahead thread should decode (or 0 if all of them are cached)
+		int64_t NextReadAheadFrame();
+
+		/// Decode frames ahead of the requested frames (this is the read-ahead thread's loop)
+		void ReadAhead();
+
 		/// Read the stream until we find the requested Frame
 		std::shared_ptr<openshot::Frame> ReadStream(int64_t requested_frame);
 
@@ -212,6 +262,22 @@ namespace openshot {
 		/// Seek to a specific Frame.  This is not always frame accurate, it's more of an estimation on many codecs.
 		void Seek(int64_t requested_frame);
 
+		/// Seek straight to the last keyframe before a specific Frame, using the keyframe index.
+		/// Returns false if there is no index, or the seek failed.
+		bool SeekKeyframe(int64_t requested_frame);
+
+		/// Find the last indexed keyframe before a specific Frame (or the first keyframe, if none are before it)
+		std::vector<KeyframeIndexEntry>::const_iterator FindKeyframe(int64_t requested_frame);
+
+		/// Convert the PTS of a keyframe into a Frame Number (with no side effects, unlike ConvertVideoPTStoFrame)
+		int64_t KeyframeToFrame(int64_t pts);
+
+		/// Start the read-ahead thread (if enabled in openshot::Settings)
+		void StartReadAhead();
+
+		/// Stop the read-ahead thread (if running)
+		void StopReadAhead();
+
 		/// Update PTS Offset (presentation time stamp). This shifts timestamps for all streams, so the first timestamp
 		/// is always zero. If one stream starts first, it will always be zero, and the other streams shifted
 		/// to maintain the correct relative time distance.
@@ -264,13 +330,20 @@ namespace openshot {
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Open File - which is called by the constructor automatically
 		void Open() override;
 
 		/// Return true if frame can be read with GetFrame()
 		bool GetIsDurationKnown();
+
+		/// @brief Set the clips decoding from this reader through a shared MediaSource.
+		///
+		/// Images are decoded at the largest size any of these clips needs (each clip scales its own
+		/// images), instead of the size of a parent clip. Cached frames decoded for smaller clips are
+		/// decoded again when a larger clip needs them.
+		void SharedClips(const std::vector<openshot::ClipBase*>& clips);
 	};
 
 }
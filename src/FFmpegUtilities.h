@@ -49,6 +49,7 @@ extern "C" {
     #include <libavresample/avresample.h>
 #endif
 
+    #include <libavutil/audio_fifo.h>
     #include <libavutil/mathematics.h>
     #include <libavutil/pixfmt.h>
     #include <libavutil/pixdesc.h>
@@ -78,6 +79,13 @@ extern "C" {
 #ifndef AV_ERROR_MAX_STRING_SIZE
     #define AV_ERROR_MAX_STRING_SIZE 64
 #endif
+#ifndef AV_CODEC_CAP_SMALL_LAST_FRAME
+    // Renamed in newer versions of FFmpeg
+    #define AV_CODEC_CAP_SMALL_LAST_FRAME CODEC_CAP_SMALL_LAST_FRAME
+#endif
+#ifndef AV_CODEC_CAP_VARIABLE_FRAME_SIZE
+    #define AV_CODEC_CAP_VARIABLE_FRAME_SIZE CODEC_CAP_VARIABLE_FRAME_SIZE
+#endif
 #ifndef AUDIO_PACKET_ENCODING_SIZE
     // 48khz * S16 (2 bytes) * max channels (8)
     #define AUDIO_PACKET_ENCODING_SIZE 768000
@@ -73,11 +73,12 @@ static int set_hwframe_ctx(AVCodecContext *ctx, AVBufferRef *hw_device_ctx, int6
 #endif // USE_HW_ACCEL
 
 FFmpegWriter::FFmpegWriter(const std::string& path) :
-		path(path), oc(NULL), audio_st(NULL), video_st(NULL), samples(NULL),
-		audio_outbuf(NULL), audio_outbuf_size(0), audio_input_frame_size(0), audio_input_position(0),
+		path(path), oc(NULL), audio_st(NULL), video_st(NULL),
+		audio_outbuf(NULL), audio_outbuf_size(0), audio_input_frame_size(0), audio_fifo(NULL),
 		initial_audio_input_frame_size(0), img_convert_ctx(NULL), cache_size(1), num_of_rescalers(1),
 		rescaler_position(0), video_codec_ctx(NULL), audio_codec_ctx(NULL), is_writing(false), video_timestamp(0), audio_timestamp(0),
-		original_sample_rate(0), original_channels(0), avr(NULL), avr_planar(NULL), is_open(false), prepare_streams(false),
+		original_sample_rate(0), original_channels(0), avr(NULL), avr_sample_rate(0), avr_channels(0),
+		avr_channel_layout(0), is_open(false), prepare_streams(false),
 		write_header(false), write_trailer(false), audio_encoder_buffer_size(0), audio_encoder_buffer(NULL) {
 
 	// Disable audio & video (so they can be independently enabled)
@@ -1007,25 +1008,19 @@ void FFmpegWriter::close_video(AVFormatContext *oc, AVStream *st)
 void FFmpegWriter::close_audio(AVFormatContext *oc, AVStream *st)
 {
 	// Clear buffers
-	delete[] samples;
 	delete[] audio_outbuf;
 	delete[] audio_encoder_buffer;
-	samples = NULL;
 	audio_outbuf = NULL;
 	audio_encoder_buffer = NULL;
-
-	// Deallocate resample buffer
-	if (avr) {
-		SWR_CLOSE(avr);
-		SWR_FREE(&avr);
-		avr = NULL;
+	if (audio_fifo) {
+		av_audio_fifo_free(audio_fifo);
+		audio_fifo = NULL;
 	}
+	audio_converted.clear();
+	audio_converted_planes.clear();
 
-	if (avr_planar) {
-		SWR_CLOSE(avr_planar);
-		SWR_FREE(&avr_planar);
-		avr_planar = NULL;
-	}
+	// Deallocate resample context
+	close_resampler();
 
 	// Free any previous memory allocations
 	if (audio_codec_ctx != nullptr) {
@@ -1429,8 +1424,10 @@ void FFmpegWriter::open_audio(AVFormatContext *oc, AVStream *st) {
 	// Set the initial frame size (since it might change during resampling)
 	initial_audio_input_frame_size = audio_input_frame_size;
 
-	// Allocate array for samples
-	samples = new int16_t[AVCODEC_MAX_AUDIO_FRAME_SIZE];
+	// Allocate FIFO for samples (which grows as needed)
+	audio_fifo = av_audio_fifo_alloc(audio_codec_ctx->sample_fmt, info.channels, audio_input_frame_size);
+	if (!audio_fifo)
+		throw OutOfMemory("Could not allocate audio FIFO", path);
 
 	// Set audio output buffer (used to store the encoded audio)
 	audio_outbuf_size = AVCODEC_MAX_AUDIO_FRAME_SIZE;
@@ -1597,24 +1594,67 @@ void FFmpegWriter::open_video(AVFormatContext *oc, AVStream *st) {
 
 }
 
+// Free the audio resampler
+void FFmpegWriter::close_resampler() {
+	if (avr) {
+		SWR_CLOSE(avr);
+		SWR_FREE(&avr);
+		avr = NULL;
+	}
+	avr_sample_rate = 0;
+	avr_channels = 0;
+	avr_channel_layout = 0;
+}
+
+// Resample float planar audio to the codec's sample format, and add it to the audio FIFO
+void FFmpegWriter::resample_audio(uint8_t **planes, int sample_count) {
+	AVSampleFormat output_sample_fmt = audio_codec_ctx->sample_fmt;
+
+	// Room for the converted samples (plus the resampler's delay). Anything that doesn't fit
+	// stays buffered in the resampler, until the next call.
+	int output_count = av_rescale_rnd(sample_count, info.sample_rate, avr_sample_rate, AV_ROUND_UP) + 256;
+	int buffer_size = av_samples_get_buffer_size(NULL, info.channels, output_count, output_sample_fmt, 1);
+	if (buffer_size < 0)
+		return;
+	if (audio_converted.size() < (size_t) buffer_size)
+		audio_converted.resize(buffer_size);
+	audio_converted_planes.resize(info.channels);
+	av_samples_fill_arrays(audio_converted_planes.data(), NULL, audio_converted.data(), info.channels,
+		output_count, output_sample_fmt, 1);
+
+	while (true) {
+		int nb_samples = SWR_CONVERT(
+			avr,							// audio resample context
+			audio_converted_planes.data(),	// output data pointers
+			0,								// output plane size, in bytes. (0 if unknown)
+			output_count,					// maximum number of samples that the output buffer can hold
+			planes,							// input data pointers
+			0,								// input plane size, in bytes (0 if unknown)
+			sample_count					// number of input samples to convert
+		);
+		if (nb_samples <= 0)
+			break;
+		av_audio_fifo_write(audio_fifo, (void **) audio_converted_planes.data(), nb_samples);
+
+		// When draining, keep going until the resampler is empty
+		if (planes || nb_samples < output_count)
+			break;
+	}
+}
+
 // write all queued frames' audio to the video file
 void FFmpegWriter::write_audio_packets(bool is_final) {
-	// Init audio buffers / variables
-	int total_frame_samples = 0;
-	int frame_position = 0;
+	// Init audio variables
 	int channels_in_frame = 0;
 	int sample_rate_in_frame = 0;
 	int samples_in_frame = 0;
+	int total_frame_samples = 0;
 	ChannelLayout channel_layout_in_frame = LAYOUT_MONO; // default channel layout
+	std::vector<uint8_t *> frame_planes;
 
-	// Create a new array (to hold all S16 audio samples, for the current queued frames
-	unsigned int all_queued_samples_size = sizeof(int16_t) * (queued_audio_frames.size() * AVCODEC_MAX_AUDIO_FRAME_SIZE);
-	int16_t *all_queued_samples = (int16_t *) av_malloc(all_queued_samples_size);
-	int16_t *all_resampled_samples = NULL;
-	int16_t *final_samples_planar = NULL;
-	int16_t *final_samples = NULL;
-
-	// Loop through each queued audio frame
+	// Loop through each queued audio frame, and add its samples to the FIFO. Frames keep
+	// their audio as float planar channels, so these are passed straight to the FIFO (when
+	// the codec uses the same format), or to the resampler (no interleaving or 16 bit samples).
 	while (!queued_audio_frames.empty()) {
 		// Get front frame (from the queue)
 		std::shared_ptr<Frame> frame = queued_audio_frames.front();
@@ -1625,46 +1665,65 @@ void FFmpegWriter::write_audio_packets(bool is_final) {
 		channels_in_frame = frame->GetAudioChannelsCount();
 		channel_layout_in_frame = frame->ChannelsLayout();
 
-		// Get audio sample array
-		float *frame_samples_float = NULL;
-		// Get samples interleaved together (c1 c2 c1 c2 c1 c2)
-		frame_samples_float = frame->GetInterleavedAudioSamples(&samples_in_frame);
-
-		// Calculate total samples
-		total_frame_samples = samples_in_frame * channels_in_frame;
-
-		// Translate audio sample values back to 16 bit integers with saturation
-		const int16_t max16 = 32767;
-		const int16_t min16 = -32768;
-		for (int s = 0; s < total_frame_samples; s++, frame_position++) {
-			float valF = frame_samples_float[s] * (1 << 15);
-			int16_t conv;
-			if (valF > max16) {
-				conv = max16;
-			} else if (valF < min16) {
-				conv = min16;
+		if (samples_in_frame > 0 && channels_in_frame > 0) {
+			frame_planes.resize(channels_in_frame);
+			for (int channel = 0; channel < channels_in_frame; channel++)
+				frame_planes[channel] = (uint8_t *) frame->GetAudioSamples(channel);
+
+			if (audio_codec_ctx->sample_fmt == AV_SAMPLE_FMT_FLTP && sample_rate_in_frame == info.sample_rate
+				&& channels_in_frame == info.channels && channel_layout_in_frame == info.channel_layout) {
+				// Same format as the codec: flush the resampler (if it was used before), and copy
+				// the channels into the FIFO
+				if (avr) {
+					resample_audio(NULL, 0);
+					close_resampler();
+				}
+				av_audio_fifo_write(audio_fifo, (void **) frame_planes.data(), samples_in_frame);
+
 			} else {
-				conv = int(valF + 32768.5) - 32768; // +0.5 is for rounding
+				// (Re)create the resampler, when the audio format of the frames changes
+				if (avr && (avr_sample_rate != sample_rate_in_frame || avr_channels != channels_in_frame
+					|| avr_channel_layout != channel_layout_in_frame)) {
+					resample_audio(NULL, 0);
+					close_resampler();
+				}
+				if (!avr) {
+					ZmqLogger::Instance()->AppendDebugMethod(
+						"FFmpegWriter::write_audio_packets (init resampler)",
+						"in_sample_fmt", AV_SAMPLE_FMT_FLTP,
+						"out_sample_fmt", audio_codec_ctx->sample_fmt,
+						"in_sample_rate", sample_rate_in_frame,
+						"out_sample_rate", info.sample_rate,
+						"in_channels", channels_in_frame,
+						"out_channels", info.channels);
+
+					avr = SWR_ALLOC();
+					av_opt_set_int(avr, "in_channel_layout", channel_layout_in_frame, 0);
+					av_opt_set_int(avr, "out_channel_layout", info.channel_layout, 0);
+					av_opt_set_int(avr, "in_sample_fmt", AV_SAMPLE_FMT_FLTP, 0);
+					av_opt_set_int(avr, "out_sample_fmt", audio_codec_ctx->sample_fmt, 0);
+					av_opt_set_int(avr, "in_sample_rate", sample_rate_in_frame, 0);
+					av_opt_set_int(avr, "out_sample_rate", info.sample_rate, 0);
+					av_opt_set_int(avr, "in_channels", channels_in_frame, 0);
+					av_opt_set_int(avr, "out_channels", info.channels, 0);
+					SWR_INIT(avr);
+					avr_sample_rate = sample_rate_in_frame;
+					avr_channels = channels_in_frame;
+					avr_channel_layout = channel_layout_in_frame;
+				}
+				resample_audio(frame_planes.data(), samples_in_frame);
 			}
-
-			// Copy into buffer
-			all_queued_samples[frame_position] = conv;
+			total_frame_samples += samples_in_frame;
 		}
 
-		// Deallocate float array
-		delete[] frame_samples_float;
-
 		// Remove front item
 		queued_audio_frames.pop_front();
 
 	} // end while
 
-
-	// Update total samples (since we've combined all queued frames)
-	total_frame_samples = frame_position;
-	int remaining_frame_samples = total_frame_samples;
-	int samples_position = 0;
-
+	// Flush the samples still buffered in the resampler
+	if (is_final && avr)
+		resample_audio(NULL, 0);
 
 	ZmqLogger::Instance()->AppendDebugMethod(
 		"FFmpegWriter::write_audio_packets",
@@ -1672,267 +1731,34 @@ void FFmpegWriter::write_audio_packets(bool is_final) {
 		"total_frame_samples", total_frame_samples,
 		"channel_layout_in_frame", channel_layout_in_frame,
 		"channels_in_frame", channels_in_frame,
-		"samples_in_frame", samples_in_frame,
+		"fifo_samples", av_audio_fifo_size(audio_fifo),
 		"LAYOUT_MONO", LAYOUT_MONO);
 
-	// Keep track of the original sample format
-	AVSampleFormat output_sample_fmt = audio_codec_ctx->sample_fmt;
+	// Encode each full packet of samples (and the remaining samples, for the final packet)
+	while (av_audio_fifo_size(audio_fifo) >= audio_input_frame_size
+		   || (is_final && av_audio_fifo_size(audio_fifo) > 0)) {
+		int packet_samples = FFMIN(audio_input_frame_size, av_audio_fifo_size(audio_fifo));
 
-	AVFrame *audio_frame = NULL;
-	if (!is_final) {
-		// Create input frame (and allocate arrays)
-		audio_frame = AV_ALLOCATE_FRAME();
-		AV_RESET_FRAME(audio_frame);
-		audio_frame->nb_samples = total_frame_samples / channels_in_frame;
+		// Codecs with a fixed frame size (such as mp2 and ac3) reject a short final frame,
+		// so it's padded with silence instead
+		int frame_samples = packet_samples;
+		if (packet_samples < audio_input_frame_size && audio_codec_ctx->frame_size > 1 && audio_codec_ctx->codec
+			&& !(audio_codec_ctx->codec->capabilities & (AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_VARIABLE_FRAME_SIZE)))
+			frame_samples = audio_codec_ctx->frame_size;
 
-		// Fill input frame with sample data
-		int error_code = avcodec_fill_audio_frame(audio_frame, channels_in_frame, AV_SAMPLE_FMT_S16, (uint8_t *) all_queued_samples, all_queued_samples_size, 0);
-		if (error_code < 0) {
-			ZmqLogger::Instance()->AppendDebugMethod(
-				"FFmpegWriter::write_audio_packets ERROR ["
-					+ av_err2string(error_code) + "]",
-				"error_code", error_code);
-		}
-
-		// Do not convert audio to planar format (yet). We need to keep everything interleaved at this point.
-		switch (audio_codec_ctx->sample_fmt) {
-			case AV_SAMPLE_FMT_FLTP: {
-				output_sample_fmt = AV_SAMPLE_FMT_FLT;
-				break;
-			}
-			case AV_SAMPLE_FMT_S32P: {
-				output_sample_fmt = AV_SAMPLE_FMT_S32;
-				break;
-			}
-			case AV_SAMPLE_FMT_S16P: {
-				output_sample_fmt = AV_SAMPLE_FMT_S16;
-				break;
-			}
-			case AV_SAMPLE_FMT_U8P: {
-				output_sample_fmt = AV_SAMPLE_FMT_U8;
-				break;
-			}
-			default: {
-				// This is only here to silence unused-enum warnings
-				break;
-			}
-		}
-
-		// Update total samples & input frame size (due to bigger or smaller data types)
-		total_frame_samples *= (float(info.sample_rate) / sample_rate_in_frame); // adjust for different byte sizes
-		total_frame_samples *= (float(info.channels) / channels_in_frame); // adjust for different # of channels
-
-		// Create output frame (and allocate arrays)
-		AVFrame *audio_converted = AV_ALLOCATE_FRAME();
-		AV_RESET_FRAME(audio_converted);
-		audio_converted->nb_samples = total_frame_samples / channels_in_frame;
-		av_samples_alloc(audio_converted->data, audio_converted->linesize, info.channels, audio_converted->nb_samples, output_sample_fmt, 0);
-
-		ZmqLogger::Instance()->AppendDebugMethod(
-			"FFmpegWriter::write_audio_packets (1st resampling)",
-			"in_sample_fmt", AV_SAMPLE_FMT_S16,
-			"out_sample_fmt", output_sample_fmt,
-			"in_sample_rate", sample_rate_in_frame,
-			"out_sample_rate", info.sample_rate,
-			"in_channels", channels_in_frame,
-			"out_channels", info.channels);
-
-		// setup resample context
-		if (!avr) {
-			avr = SWR_ALLOC();
-			av_opt_set_int(avr, "in_channel_layout", channel_layout_in_frame, 0);
-			av_opt_set_int(avr, "out_channel_layout", info.channel_layout, 0);
-			av_opt_set_int(avr, "in_sample_fmt", AV_SAMPLE_FMT_S16, 0);
-			av_opt_set_int(avr, "out_sample_fmt", output_sample_fmt, 0); // planar not allowed here
-			av_opt_set_int(avr, "in_sample_rate", sample_rate_in_frame, 0);
-			av_opt_set_int(avr, "out_sample_rate", info.sample_rate, 0);
-			av_opt_set_int(avr, "in_channels", channels_in_frame, 0);
-			av_opt_set_int(avr, "out_channels", info.channels, 0);
-			SWR_INIT(avr);
-		}
-		// Convert audio samples
-		int nb_samples = SWR_CONVERT(
-			avr,	// audio resample context
-			audio_converted->data,		   // output data pointers
-			audio_converted->linesize[0],	// output plane size, in bytes. (0 if unknown)
-			audio_converted->nb_samples,	 // maximum number of samples that the output buffer can hold
-			audio_frame->data,			   // input data pointers
-			audio_frame->linesize[0],		// input plane size, in bytes (0 if unknown)
-			audio_frame->nb_samples		// number of input samples to convert
-		);
-
-		// Set remaining samples
-		remaining_frame_samples = total_frame_samples;
-
-		// Create a new array (to hold all resampled S16 audio samples)
-		all_resampled_samples = (int16_t *) av_malloc(
-			sizeof(int16_t) * nb_samples * info.channels
-			* (av_get_bytes_per_sample(output_sample_fmt) /
-			   av_get_bytes_per_sample(AV_SAMPLE_FMT_S16) )
-		);
-
-		// Copy audio samples over original samples
-		memcpy(all_resampled_samples, audio_converted->data[0],
-			   static_cast<size_t>(nb_samples)
-				   * info.channels
-				   * av_get_bytes_per_sample(output_sample_fmt));
-
-		// Remove converted audio
-		av_freep(&(audio_frame->data[0]));
-		AV_FREE_FRAME(&audio_frame);
-		av_freep(&audio_converted->data[0]);
-		AV_FREE_FRAME(&audio_converted);
-		all_queued_samples = NULL; // this array cleared with above call
-
-		ZmqLogger::Instance()->AppendDebugMethod(
-			"FFmpegWriter::write_audio_packets (Successfully completed 1st resampling)",
-			"nb_samples", nb_samples,
-			"remaining_frame_samples", remaining_frame_samples);
-	}
-
-	// Loop until no more samples
-	while (remaining_frame_samples > 0 || is_final) {
-		// Get remaining samples needed for this packet
-		int remaining_packet_samples = (audio_input_frame_size * info.channels) - audio_input_position;
-
-		// Determine how many samples we need
-		int diff = 0;
-		if (remaining_frame_samples >= remaining_packet_samples) {
-			diff = remaining_packet_samples;
-		} else {
-			diff = remaining_frame_samples;
-		}
-
-		// Copy frame samples into the packet samples array
-		if (!is_final)
-			//TODO: Make this more sane
-			memcpy(
-				samples + (audio_input_position
-					* (av_get_bytes_per_sample(output_sample_fmt) /
-					   av_get_bytes_per_sample(AV_SAMPLE_FMT_S16) )
-				),
-				all_resampled_samples + samples_position,
-				static_cast<size_t>(diff)
-					* av_get_bytes_per_sample(output_sample_fmt)
-			);
-
-		// Increment counters
-		audio_input_position += diff;
-		samples_position += diff * (av_get_bytes_per_sample(output_sample_fmt) / av_get_bytes_per_sample(AV_SAMPLE_FMT_S16));
-		remaining_frame_samples -= diff;
-
-		// Do we have enough samples to proceed?
-		if (audio_input_position < (audio_input_frame_size * info.channels) && !is_final)
-			// Not enough samples to encode... so wait until the next frame
-			break;
-
-		// Convert to planar (if needed by audio codec)
+		// Create output frame (in the codec's sample format), and fill it from the FIFO
 		AVFrame *frame_final = AV_ALLOCATE_FRAME();
 		AV_RESET_FRAME(frame_final);
-		if (av_sample_fmt_is_planar(audio_codec_ctx->sample_fmt)) {
-			ZmqLogger::Instance()->AppendDebugMethod(
-				"FFmpegWriter::write_audio_packets (2nd resampling for Planar formats)",
-				"in_sample_fmt", output_sample_fmt,
-				"out_sample_fmt", audio_codec_ctx->sample_fmt,
-				"in_sample_rate", info.sample_rate,
-				"out_sample_rate", info.sample_rate,
-				"in_channels", info.channels,
-				"out_channels", info.channels
-			);
-
-			// setup resample context
-			if (!avr_planar) {
-				avr_planar = SWR_ALLOC();
-				av_opt_set_int(avr_planar, "in_channel_layout", info.channel_layout, 0);
-				av_opt_set_int(avr_planar, "out_channel_layout", info.channel_layout, 0);
-				av_opt_set_int(avr_planar, "in_sample_fmt", output_sample_fmt, 0);
-				av_opt_set_int(avr_planar, "out_sample_fmt", audio_codec_ctx->sample_fmt, 0); // planar not allowed here
-				av_opt_set_int(avr_planar, "in_sample_rate", info.sample_rate, 0);
-				av_opt_set_int(avr_planar, "out_sample_rate", info.sample_rate, 0);
-				av_opt_set_int(avr_planar, "in_channels", info.channels, 0);
-				av_opt_set_int(avr_planar, "out_channels", info.channels, 0);
-				SWR_INIT(avr_planar);
-			}
-
-			// Create input frame (and allocate arrays)
-			audio_frame = AV_ALLOCATE_FRAME();
-			AV_RESET_FRAME(audio_frame);
-			audio_frame->nb_samples = audio_input_position / info.channels;
-
-			// Create a new array
-			final_samples_planar = (int16_t *) av_malloc(
-				sizeof(int16_t) * audio_frame->nb_samples * info.channels
-				* (av_get_bytes_per_sample(output_sample_fmt) /
-				   av_get_bytes_per_sample(AV_SAMPLE_FMT_S16) )
-			);
-
-			// Copy audio into buffer for frame
-			memcpy(final_samples_planar, samples,
-				   static_cast<size_t>(audio_frame->nb_samples)
-					   * info.channels
-					   * av_get_bytes_per_sample(output_sample_fmt));
-
-			// Fill input frame with sample data
-			avcodec_fill_audio_frame(audio_frame, info.channels, output_sample_fmt,
-				(uint8_t *) final_samples_planar, audio_encoder_buffer_size, 0);
-
-			// Create output frame (and allocate arrays)
-			frame_final->nb_samples = audio_input_frame_size;
-			frame_final->channels = info.channels;
-			frame_final->format = audio_codec_ctx->sample_fmt;
-			frame_final->channel_layout = info.channel_layout;
-			av_samples_alloc(frame_final->data, frame_final->linesize, info.channels,
-				frame_final->nb_samples, audio_codec_ctx->sample_fmt, 0);
-
-			// Convert audio samples
-			int nb_samples = SWR_CONVERT(
-				avr_planar,				  // audio resample context
-				frame_final->data,		   // output data pointers
-				frame_final->linesize[0],	// output plane size, in bytes. (0 if unknown)
-				frame_final->nb_samples,	 // maximum number of samples that the output buffer can hold
-				audio_frame->data,		   // input data pointers
-				audio_frame->linesize[0],	// input plane size, in bytes (0 if unknown)
-				audio_frame->nb_samples	  // number of input samples to convert
-			);
-
-			// Copy audio samples over original samples
-			const auto copy_length = static_cast<size_t>(nb_samples)
-				* av_get_bytes_per_sample(audio_codec_ctx->sample_fmt)
-				* info.channels;
-
-			if (nb_samples > 0)
-				memcpy(samples, frame_final->data[0], copy_length);
-
-			// deallocate AVFrame
-			av_freep(&(audio_frame->data[0]));
-			AV_FREE_FRAME(&audio_frame);
-			all_queued_samples = NULL; // this array cleared with above call
-
-			ZmqLogger::Instance()->AppendDebugMethod(
-				"FFmpegWriter::write_audio_packets (Successfully completed 2nd resampling for Planar formats)",
-				"nb_samples", nb_samples);
-
-		} else {
-			// Create a new array
-			const auto buf_size = static_cast<size_t>(audio_input_position)
-				* (av_get_bytes_per_sample(audio_codec_ctx->sample_fmt) /
-				   av_get_bytes_per_sample(AV_SAMPLE_FMT_S16)
-				);
-			final_samples = reinterpret_cast<int16_t*>(
-					av_malloc(sizeof(int16_t) * buf_size));
-
-			// Copy audio into buffer for frame
-			memcpy(final_samples, samples,
-				audio_input_position * av_get_bytes_per_sample(audio_codec_ctx->sample_fmt));
-
-			// Init the nb_samples property
-			frame_final->nb_samples = audio_input_frame_size;
-
-			// Fill the final_frame AVFrame with audio (non planar)
-			avcodec_fill_audio_frame(frame_final, audio_codec_ctx->channels,
-				audio_codec_ctx->sample_fmt, (uint8_t *) final_samples,
-				audio_encoder_buffer_size, 0);
-		}
+		frame_final->nb_samples = frame_samples;
+		frame_final->channels = info.channels;
+		frame_final->format = audio_codec_ctx->sample_fmt;
+		frame_final->channel_layout = info.channel_layout;
+		av_samples_alloc(frame_final->data, frame_final->linesize, info.channels,
+			frame_final->nb_samples, audio_codec_ctx->sample_fmt, 0);
+		av_audio_fifo_read(audio_fifo, (void **) frame_final->data, packet_samples);
+		if (frame_samples > packet_samples)
+			av_samples_set_silence(frame_final->data, packet_samples, frame_samples - packet_samples,
+				info.channels, audio_codec_ctx->sample_fmt);
 
 		// Set the AVFrame's PTS
 		frame_final->pts = audio_timestamp;
@@ -2011,7 +1837,7 @@ void FFmpegWriter::write_audio_packets(bool is_final) {
 		}
 
 		// Increment PTS (no pkt.duration, so calculate with maths)
-		audio_timestamp += FFMIN(audio_input_frame_size, audio_input_position);
+		audio_timestamp += frame_samples;
 
 		// deallocate AVFrame
 		av_freep(&(frame_final->data[0]));
@@ -2019,20 +1845,6 @@ void FFmpegWriter::write_audio_packets(bool is_final) {
 
 		// deallocate memory for packet
 		AV_FREE_PACKET(pkt);
-
-		// Reset position
-		audio_input_position = 0;
-		is_final = false;
-	}
-
-	// Delete arrays (if needed)
-	if (all_resampled_samples) {
-		av_freep(&all_resampled_samples);
-		all_resampled_samples = NULL;
-	}
-	if (all_queued_samples) {
-		av_freep(&all_queued_samples);
-		all_queued_samples = NULL;
 	}
 }
 
@@ -19,6 +19,8 @@
 #include "ReaderBase.h"
 #include "WriterBase.h"
 
+#include <vector>
+
 // Include FFmpeg headers and macros
 #include "FFmpegUtilities.h"
 
@@ -131,7 +133,6 @@ namespace openshot {
 		AVCodecContext *video_codec_ctx;
 		AVCodecContext *audio_codec_ctx;
 		SwsContext *img_convert_ctx;
-		int16_t *samples;
 		uint8_t *audio_outbuf;
 		uint8_t *audio_encoder_buffer;
 
@@ -142,10 +143,14 @@ namespace openshot {
 		int audio_outbuf_size;
 		int audio_input_frame_size;
 		int initial_audio_input_frame_size;
-		int audio_input_position;
 		int audio_encoder_buffer_size;
+		AVAudioFifo *audio_fifo; // Samples waiting to be encoded (in the codec's sample format)
 		SWRCONTEXT *avr;
-		SWRCONTEXT *avr_planar;
+		int avr_sample_rate;
+		int avr_channels;
+		int64_t avr_channel_layout;
+		std::vector<uint8_t> audio_converted;
+		std::vector<uint8_t *> audio_converted_planes;
 
 		/* Resample options */
 		int original_sample_rate;
@@ -201,6 +206,13 @@ namespace openshot {
 		/// open video codec
 		void open_video(AVFormatContext *oc, AVStream *st);
 
+		/// Resample float planar audio to the codec's sample format, and add it to the audio FIFO
+		/// (NULL planes drain the samples still buffered in the resampler)
+		void resample_audio(uint8_t **planes, int sample_count);
+
+		/// Free the audio resampler
+		void close_resampler();
+
 		/// process video frame
 		void process_video_packet(std::shared_ptr<openshot::Frame> frame);
 
@@ -762,7 +762,7 @@ void FrameMapper::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void FrameMapper::SetJsonValue(const Json::Value root) {
+void FrameMapper::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
@@ -275,7 +275,7 @@ namespace openshot
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Open the internal reader
 		void Open() override;
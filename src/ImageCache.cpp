@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @brief Source file for ImageCache class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "ImageCache.h"
+
+#include "Settings.h"
+#include "ZmqLogger.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+
+using namespace openshot;
+
+// Size of an image (in bytes)
+static int64_t image_bytes(const QImage& image)
+{
+	#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		// byteCount() is deprecated from Qt 5.10
+		return image.sizeInBytes();
+	#else
+		return image.byteCount();
+	#endif
+}
+
+// Get the instance of the cache
+ImageCache* ImageCache::Instance()
+{
+	static ImageCache instance;
+	return &instance;
+}
+
+// Get the key of an image
+std::string ImageCache::Key(const std::string& decoder, const std::string& path, QSize size)
+{
+	// The file's size and modification time are part of the key, so a changed file is decoded again
+	QFileInfo file(QString::fromStdString(path));
+	std::string key = decoder + "|" + file.absoluteFilePath().toStdString() + "|" +
+		std::to_string(file.size()) + "|" + std::to_string(file.lastModified().toMSecsSinceEpoch());
+	if (size.isValid())
+		key += "|" + std::to_string(size.width()) + "x" + std::to_string(size.height());
+	return key;
+}
+
+// Move an image to the front of the recent images
+void ImageCache::touch(const std::string& key, std::shared_ptr<QImage> image)
+{
+	for (auto itr = recent.begin(); itr != recent.end(); ++itr) {
+		if (itr->first == key) {
+			if (itr == recent.begin())
+				return;
+			recent.splice(recent.begin(), recent, itr);
+			return;
+		}
+	}
+	recent.emplace_front(key, image);
+	recent_bytes += image_bytes(*image);
+
+	// Release the least recently used images over the budget (readers still using them keep them)
+	int64_t max_bytes = Settings::Instance()->IMAGE_CACHE_MAX_BYTES;
+	while (!recent.empty() && recent_bytes > max_bytes) {
+		recent_bytes -= image_bytes(*recent.back().second);
+		recent.pop_back();
+	}
+}
+
+// Get an image from the cache
+std::shared_ptr<QImage> ImageCache::Get(const std::string& key)
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	auto itr = images.find(key);
+	if (itr == images.end())
+		return std::shared_ptr<QImage>();
+
+	std::shared_ptr<QImage> image = itr->second.lock();
+	if (!image) {
+		images.erase(itr);
+		return image;
+	}
+	touch(key, image);
+	return image;
+}
+
+// Add an image to the cache
+std::shared_ptr<QImage> ImageCache::Add(const std::string& key, std::shared_ptr<QImage> image)
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	// Forget images which were released
+	for (auto itr = images.begin(); itr != images.end();) {
+		if (itr->second.expired())
+			itr = images.erase(itr);
+		else
+			++itr;
+	}
+
+	// Share the existing image (if another reader decoded it at the same time)
+	auto itr = images.find(key);
+	if (itr != images.end())
+		image = itr->second.lock();
+	else
+		images[key] = image;
+	touch(key, image);
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("ImageCache::Add", "images", images.size(), "recent_bytes", recent_bytes);
+
+	return image;
+}
+
+// Release every image which isn't in use
+void ImageCache::Clear()
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	recent.clear();
+	recent_bytes = 0;
+	for (auto itr = images.begin(); itr != images.end();) {
+		if (itr->second.expired())
+			itr = images.erase(itr);
+		else
+			++itr;
+	}
+}
+
+// Number of images in the cache
+int64_t ImageCache::Count()
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	int64_t count = 0;
+	for (const auto& item : images) {
+		if (!item.second.expired())
+			count++;
+	}
+	return count;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file
+ * @brief Header file for ImageCache class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef OPENSHOT_IMAGE_CACHE_H
+#define OPENSHOT_IMAGE_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <QImage>
+#include <QSize>
+
+namespace openshot
+{
+	/**
+	 * @brief The decoded (and scaled) still images of every image reader, so each image file is only decoded once.
+	 *
+	 * Images are keyed on the decoder, the path, size and modification time of the file, and the size
+	 * the image was scaled to. Every reader of the same image (such as a logo used by many clips) shares
+	 * one QImage, which must not be changed (frames copy their images before drawing on them).
+	 *
+	 * Images are released when no reader uses them, except for the most recently used images, which are
+	 * kept (up to Settings::IMAGE_CACHE_MAX_BYTES) so they don't need to be decoded again when a clip is
+	 * opened again.
+	 */
+	class ImageCache {
+	private:
+		std::mutex mutex;
+		std::map<std::string, std::weak_ptr<QImage>> images; ///< Every image in use
+		std::list<std::pair<std::string, std::shared_ptr<QImage>>> recent; ///< Most recently used images (first), kept when unused
+		int64_t recent_bytes; ///< Size of the recent images
+
+		ImageCache() : recent_bytes(0) {};
+
+		/// Move an image to the front of the recent images (and release the oldest images over the budget)
+		void touch(const std::string& key, std::shared_ptr<QImage> image);
+
+	public:
+		/// Get the instance of the cache
+		static ImageCache* Instance();
+
+		/// @brief Get the key of an image
+		/// @param decoder The name of the reader which decodes the file
+		/// @param path The path of the image file
+		/// @param size The size the image is scaled to (or an empty size, for the original image)
+		static std::string Key(const std::string& decoder, const std::string& path, QSize size = QSize());
+
+		/// Get an image (or a null pointer, if it isn't cached)
+		std::shared_ptr<QImage> Get(const std::string& key);
+
+		/// Add an image, and return the shared image of its key (which is an existing image, if another reader added it first)
+		std::shared_ptr<QImage> Add(const std::string& key, std::shared_ptr<QImage> image);
+
+		/// Release every image which isn't in use
+		void Clear();
+
+		/// Number of images in the cache (in use or recently used)
+		int64_t Count();
+	};
+
+}
+
+#endif
@@ -18,8 +18,12 @@
 
 #include "ImageReader.h"
 #include "Exceptions.h"
+#include "ImageCache.h"
 #include "Frame.h"
 
+#include <QFileInfo>
+#include <QImage>
+
 using namespace openshot;
 
 ImageReader::ImageReader(const std::string& path, bool inspect_reader) : path(path), is_open(false)
@@ -37,29 +41,41 @@ void ImageReader::Open()
 	// Open reader if not already open
 	if (!is_open)
 	{
-		// Attempt to open file
-		try
-		{
-			// load image
-			image = std::make_shared<Magick::Image>(path);
-
-			// Give image a transparent background color
-			image->backgroundColor(Magick::Color("none"));
-			MAGICK_IMAGE_ALPHA(image, true);
-		}
-		catch (const Magick::Exception& e) {
-			// raise exception
-			throw InvalidFile("File could not be opened.", path);
+		// Share the decoded image of other readers of the same file (if any)
+		std::string key = ImageCache::Key("ImageReader", path);
+		image = ImageCache::Instance()->Get(key);
+		if (!image) {
+			// Attempt to open file
+			try
+			{
+				// load image
+				auto magick_image = std::make_shared<Magick::Image>(path);
+
+				// Give image a transparent background color
+				magick_image->backgroundColor(Magick::Color("none"));
+				MAGICK_IMAGE_ALPHA(magick_image, true);
+
+				// Convert it once (instead of for every frame, and in the format of frames, so frames
+				// sharing it never convert it), keeping the name of its format
+				auto decoded_image = std::make_shared<QImage>(openshot::Magick2QImage(magick_image)->convertToFormat(
+					QImage::Format_RGBA8888_Premultiplied));
+				decoded_image->setText("format", QString::fromStdString(magick_image->format()));
+				image = ImageCache::Instance()->Add(key, decoded_image);
+			}
+			catch (const Magick::Exception& e) {
+				// raise exception
+				throw InvalidFile("File could not be opened.", path);
+			}
 		}
 
 		// Update image properties
 		info.has_audio = false;
 		info.has_video = true;
 		info.has_single_image = true;
-		info.file_size = image->fileSize();
-		info.vcodec = image->format();
-		info.width = image->size().width();
-		info.height = image->size().height();
+		info.file_size = QFileInfo(QString::fromStdString(path)).size();
+		info.vcodec = image->text("format").toStdString();
+		info.width = image->width();
+		info.height = image->height();
 		info.pixel_ratio = openshot::Fraction(1, 1);
 		info.duration = 60 * 60 * 1;  // 1 hour duration
 		info.fps = openshot::Fraction(30, 1);
@@ -102,12 +118,11 @@ std::shared_ptr<Frame> ImageReader::GetFrame(int64_t requested_frame)
 	// Create or get frame object
 	auto image_frame = std::make_shared<Frame>(
 		requested_frame,
-		image->size().width(), image->size().height(),
+		image->width(), image->height(),
 		"#000000", 0, 2);
 
-	// Add Image data to frame
-	auto qimage = openshot::Magick2QImage(image);
-	image_frame->AddImage(qimage);
+	// Add Image data to frame (every frame shares the same image)
+	image_frame->AddImage(image);
 	return image_frame;
 }
 
@@ -147,7 +162,7 @@ void ImageReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void ImageReader::SetJsonValue(const Json::Value root) {
+void ImageReader::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
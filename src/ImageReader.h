@@ -23,9 +23,7 @@
 #include "Json.h"
 
 // Forward decls
-namespace Magick {
-    class Image;
-}
+class QImage;
 namespace openshot {
 	class CacheBase;
 	class Frame;
@@ -56,7 +54,7 @@ namespace openshot
 	{
 	private:
 		std::string path;
-		std::shared_ptr<Magick::Image> image;
+		std::shared_ptr<QImage> image; ///< Decoded image (shared with other readers of the file by the ImageCache)
 		bool is_open;
 
 	public:
@@ -93,7 +91,7 @@ namespace openshot
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Open File - which is called by the constructor automatically
 		void Open() override;
@@ -11,19 +11,21 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
 #include "Json.h"
+
+#include <memory>
 #include "Exceptions.h"
 
-const Json::Value openshot::stringToJson(const std::string value) {
+const Json::Value openshot::stringToJson(const std::string& value) {
 
-	// Parse JSON string into JSON objects
+	// Parse JSON string into JSON objects (comments are never used, so they aren't kept)
 	Json::Value root;
 	Json::CharReaderBuilder rbuilder;
-	Json::CharReader* reader(rbuilder.newCharReader());
+	rbuilder["collectComments"] = false;
+	std::unique_ptr<Json::CharReader> reader(rbuilder.newCharReader());
 
 	std::string errors;
 	bool success = reader->parse( value.c_str(), value.c_str() + value.size(),
 	                              &root, &errors );
-	delete reader;
 
 	if (!success)
 		// Raise exception
@@ -18,7 +18,7 @@
 
 
 namespace openshot {
-    const Json::Value stringToJson(const std::string value);
+    const Json::Value stringToJson(const std::string& value);
 }
 
 #endif
@@ -369,14 +369,17 @@ void Keyframe::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Keyframe::SetJsonValue(const Json::Value root) {
+void Keyframe::SetJsonValue(const Json::Value& root) {
 	// Clear existing points
 	Points.clear();
 	Points.shrink_to_fit();
 
-	if (!root["Points"].isNull())
+	if (!root["Points"].isNull()) {
+		// Points are usually saved in order (so each one is appended)
+		Points.reserve(root["Points"].size());
+
 		// loop through points
-		for (const auto existing_point : root["Points"]) {
+		for (const auto& existing_point : root["Points"]) {
 			// Create Point
 			Point p;
 
@@ -386,6 +389,7 @@ void Keyframe::SetJsonValue(const Json::Value root) {
 			// Add Point to Keyframe
 			AddPoint(p);
 		}
+	}
 }
 
 // Get the change in Y value (from the previous Y value)
@@ -125,7 +125,7 @@ namespace openshot {
 		std::string Json() const; ///< Generate JSON string of this object
 		Json::Value JsonValue() const; ///< Generate Json::Value for this object
 		void SetJson(const std::string value); ///< Load JSON string into this object
-		void SetJsonValue(const Json::Value root); ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root); ///< Load Json::Value into this object
 
 		/// Remove a point by matching a coordinate
 		void RemovePoint(Point p);
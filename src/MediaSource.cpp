@@ -0,0 +1,273 @@
+/**
+ * @file
+ * @brief Source file for MediaSource, MediaSourceReader and MediaSourceRegistry classes
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "MediaSource.h"
+
+#include "Exceptions.h"
+#include "FFmpegReader.h"
+#include "Frame.h"
+#include "Settings.h"
+#include "ZmqLogger.h"
+
+#include <QFileInfo>
+
+#include <vector>
+
+using namespace openshot;
+
+// Create a source from a reader
+MediaSource::MediaSource(ReaderBase* new_reader, bool shared) : reader(new_reader), shared(shared)
+{
+}
+
+// Decode images for the clips of the readers which opened this source
+void MediaSource::update_clips()
+{
+	// A shared reader never has a parent clip (which would change while other clips are decoding):
+	// it decodes at the largest size any of its clips needs instead
+	ClipBase* parent = NULL;
+	std::vector<ClipBase*> clips;
+	if (!shared && open_readers.size() == 1)
+		parent = (*open_readers.begin())->ParentClip();
+	else if (shared) {
+		for (auto source_reader : open_readers) {
+			if (source_reader->ParentClip())
+				clips.push_back(source_reader->ParentClip());
+		}
+	}
+
+	if (reader->ParentClip() != parent)
+		reader->ParentClip(parent);
+	FFmpegReader* ffmpeg_reader = dynamic_cast<FFmpegReader*>(reader.get());
+	if (ffmpeg_reader)
+		ffmpeg_reader->SharedClips(clips);
+}
+
+// Open the shared reader (if it isn't already open)
+void MediaSource::Open(MediaSourceReader* source_reader)
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	open_readers.insert(source_reader);
+	update_clips();
+
+	try {
+		if (!reader->IsOpen())
+			reader->Open();
+	} catch (...) {
+		open_readers.erase(source_reader);
+		throw;
+	}
+}
+
+// Close the shared reader (if no other clip reader has it open)
+void MediaSource::Close(MediaSourceReader* source_reader)
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	open_readers.erase(source_reader);
+	if (open_readers.empty())
+		reader->Close();
+	else
+		update_clips();
+}
+
+// Create a reader of a shared source
+MediaSourceReader::MediaSourceReader(std::shared_ptr<MediaSource> source) : source(source), is_open(false)
+{
+	// Init reader info struct
+	info = source->Reader()->info;
+}
+
+MediaSourceReader::~MediaSourceReader()
+{
+	Close();
+}
+
+// Open the reader (opening the shared reader, if it isn't already open)
+void MediaSourceReader::Open()
+{
+	if (!is_open) {
+		source->Open(this);
+		info = source->Reader()->info;
+		is_open = true;
+	}
+}
+
+// Close the reader (the shared reader stays open while other clips use it)
+void MediaSourceReader::Close()
+{
+	if (is_open) {
+		is_open = false;
+		source->Close(this);
+	}
+}
+
+// Get the cache of the shared reader
+CacheBase* MediaSourceReader::GetCache()
+{
+	return source->Reader()->GetCache();
+}
+
+// Get a frame from the shared reader
+std::shared_ptr<Frame> MediaSourceReader::GetFrame(int64_t number)
+{
+	// Check for open reader (or throw exception)
+	if (!is_open)
+		throw ReaderClosed("The MediaSourceReader is closed.  Call Open() before calling this method.");
+
+	return source->Reader()->GetFrame(number);
+}
+
+// Return the type name of the shared reader
+std::string MediaSourceReader::Name()
+{
+	return source->Reader()->Name();
+}
+
+// Generate JSON string of this object
+std::string MediaSourceReader::Json() const {
+
+	// Return formatted string
+	return JsonValue().toStyledString();
+}
+
+// Generate Json::Value for this object
+Json::Value MediaSourceReader::JsonValue() const {
+
+	// Save the settings of the shared reader
+	return source->Reader()->JsonValue();
+}
+
+// Load JSON string into this object
+void MediaSourceReader::SetJson(const std::string value) {
+
+	// Parse JSON string into JSON objects
+	try
+	{
+		const Json::Value root = openshot::stringToJson(value);
+		// Set all values that match
+		SetJsonValue(root);
+	}
+	catch (const std::exception& e)
+	{
+		// Error parsing JSON (or missing keys)
+		throw InvalidJSON("JSON is invalid (missing keys or invalid data types)");
+	}
+}
+
+// Load Json::Value into this object
+void MediaSourceReader::SetJsonValue(const Json::Value& root) {
+
+	// Other clips may share the current source: switch to the source of these settings instead
+	bool was_open = is_open;
+	Close();
+	source = MediaSourceRegistry::Instance()->Acquire(root, source->Shared());
+	info = source->Reader()->info;
+
+	// Re-Open (if needed)
+	if (was_open)
+		Open();
+}
+
+// Get the instance of the registry
+MediaSourceRegistry* MediaSourceRegistry::Instance()
+{
+	static MediaSourceRegistry instance;
+	return &instance;
+}
+
+// Find the source of a key (or create it)
+template <typename CreateReader>
+std::shared_ptr<MediaSource> MediaSourceRegistry::acquire(const std::string& key, bool share, CreateReader create_reader)
+{
+	// Every clip gets its own decoder (if sharing is disabled)
+	if (!share || !Settings::Instance()->SHARE_MEDIA_SOURCES) {
+		std::unique_ptr<ReaderBase> reader(create_reader());
+		return std::make_shared<MediaSource>(reader.release(), false);
+	}
+
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	// Forget sources which were released
+	for (auto itr = sources.begin(); itr != sources.end();) {
+		if (itr->second.expired())
+			itr = sources.erase(itr);
+		else
+			++itr;
+	}
+
+	// Share the existing source (if any)
+	auto itr = sources.find(key);
+	if (itr != sources.end()) {
+		std::shared_ptr<MediaSource> source = itr->second.lock();
+		if (source)
+			return source;
+	}
+
+	std::unique_ptr<ReaderBase> reader(create_reader());
+	std::shared_ptr<MediaSource> source = std::make_shared<MediaSource>(reader.release(), true);
+	sources[key] = source;
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("MediaSourceRegistry::acquire (New source)", "sources", sources.size());
+
+	return source;
+}
+
+// Key of the source of a file (the same for any spelling of its path)
+std::string MediaSourceRegistry::key(const std::string& path)
+{
+	QFileInfo file(QString::fromStdString(path));
+	QString canonical_path = file.canonicalFilePath();
+	if (canonical_path.isEmpty())
+		canonical_path = file.absoluteFilePath();
+	return canonical_path.toStdString();
+}
+
+// Get the source of a video or audio file (with the default FFmpegReader settings)
+std::shared_ptr<MediaSource> MediaSourceRegistry::Acquire(const std::string& path, bool share)
+{
+	return acquire(key(path), share, [&path]() {
+		return new FFmpegReader(path);
+	});
+}
+
+// Get the source of a video or audio file, from FFmpegReader JSON
+std::shared_ptr<MediaSource> MediaSourceRegistry::Acquire(const Json::Value& root, bool share)
+{
+	// The file is opened again (replacing the saved properties), so clips created from a path
+	// and from JSON share the source of the same file
+	return acquire(key(root["path"].asString()), share, [&root]() {
+		FFmpegReader* reader = new FFmpegReader(root["path"].asString(), false);
+		try {
+			reader->SetJsonValue(root);
+		} catch (...) {
+			delete reader;
+			throw;
+		}
+		return reader;
+	});
+}
+
+// Number of sources in use
+size_t MediaSourceRegistry::Count()
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+
+	size_t count = 0;
+	for (const auto& item : sources) {
+		if (!item.second.expired())
+			count++;
+	}
+	return count;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file
+ * @brief Header file for MediaSource, MediaSourceReader and MediaSourceRegistry classes
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef OPENSHOT_MEDIA_SOURCE_H
+#define OPENSHOT_MEDIA_SOURCE_H
+
+#include "ReaderBase.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace openshot
+{
+	class CacheBase;
+	class Frame;
+	class MediaSourceReader;
+
+	/**
+	 * @brief A media file decoded once, for every clip that references it.
+	 *
+	 * A MediaSource owns the FFmpegReader (demuxer, decoders and decoded frame cache) of a media
+	 * file, which is shared by the MediaSourceReader of each clip. The reader is opened when the
+	 * first clip opens it, and closed when the last clip closes it.
+	 */
+	class MediaSource {
+	private:
+		std::unique_ptr<openshot::ReaderBase> reader;
+		std::set<openshot::MediaSourceReader*> open_readers; ///< Clip readers which opened this source
+		std::mutex mutex;
+		bool shared; ///< Can several clips use this source
+
+		/// Decode images for the clip of the source's reader, if the source isn't shared (shared sources
+		/// decode at the largest size any of their open clips needs, see FFmpegReader::SharedClips)
+		void update_clips();
+
+	public:
+		/// Create a source from a reader (which is deleted with the source)
+		/// @param new_reader The reader of the media file
+		/// @param shared Can several clips use this source (or only one clip)
+		MediaSource(openshot::ReaderBase* new_reader, bool shared=true);
+
+		/// Open the shared reader (if it isn't already open)
+		void Open(openshot::MediaSourceReader* source_reader);
+
+		/// Close the shared reader (if no other clip reader has it open)
+		void Close(openshot::MediaSourceReader* source_reader);
+
+		/// Get the shared reader
+		openshot::ReaderBase* Reader() { return reader.get(); }
+
+		/// Can several clips use this source
+		bool Shared() const { return shared; }
+	};
+
+	/**
+	 * @brief The reader of one clip, reading frames from a shared MediaSource.
+	 *
+	 * Each clip gets its own MediaSourceReader (so it can be opened, closed, and wrapped with a
+	 * FrameMapper like any other reader), but every MediaSourceReader of the same file reads from
+	 * one FFmpegReader, and one decoded frame cache.
+	 * Its JSON is the JSON of the shared reader, so projects are saved the same way.
+	 */
+	class MediaSourceReader : public ReaderBase {
+	private:
+		std::shared_ptr<openshot::MediaSource> source;
+		bool is_open;
+
+	public:
+		/// Create a reader of a shared source
+		MediaSourceReader(std::shared_ptr<openshot::MediaSource> source);
+
+		virtual ~MediaSourceReader();
+
+		/// Close the reader (the shared reader stays open while other clips use it)
+		void Close() override;
+
+		/// Get the cache of the shared reader
+		openshot::CacheBase* GetCache() override;
+
+		/// Get a frame from the shared reader
+		std::shared_ptr<openshot::Frame> GetFrame(int64_t number) override;
+
+		/// Determine if reader is open or closed
+		bool IsOpen() override { return is_open; };
+
+		/// Return the type name of the shared reader
+		std::string Name() override;
+
+		// Get and Set JSON methods
+		std::string Json() const override; ///< Generate JSON string of this object
+		void SetJson(const std::string value) override; ///< Load JSON string into this object
+		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object (switching to the source of these settings)
+
+		/// Open the reader (opening the shared reader, if it isn't already open)
+		void Open() override;
+	};
+
+	/**
+	 * @brief The media files opened by clips, so clips cut from the same file share its decoder.
+	 *
+	 * Sources are keyed on the path of the file (whether clips were created from a path or from the
+	 * JSON of a reader, which only holds properties read from the file again), and are released
+	 * when the last clip reader using them is deleted. Set Settings::SHARE_MEDIA_SOURCES to false to
+	 * give every clip its own decoder.
+	 */
+	class MediaSourceRegistry {
+	private:
+		std::map<std::string, std::weak_ptr<openshot::MediaSource>> sources;
+		std::mutex mutex;
+
+		MediaSourceRegistry() {};
+
+		/// Key of the source of a file (the same for any spelling of its path)
+		static std::string key(const std::string& path);
+
+		/// Find the source of a key (or create it)
+		template <typename CreateReader>
+		std::shared_ptr<openshot::MediaSource> acquire(const std::string& key, bool share, CreateReader create_reader);
+
+	public:
+		/// Get the instance of the registry
+		static MediaSourceRegistry* Instance();
+
+		/// @brief Get the source of a video or audio file (with the default FFmpegReader settings)
+		/// @param path The path of the file
+		/// @param share Share the source with other clips (if Settings::SHARE_MEDIA_SOURCES is also set), or create a private source
+		std::shared_ptr<openshot::MediaSource> Acquire(const std::string& path, bool share=true);
+
+		/// @brief Get the source of a video or audio file, from FFmpegReader JSON
+		/// @param root The JSON of the reader
+		/// @param share Share the source with other clips (if Settings::SHARE_MEDIA_SOURCES is also set), or create a private source
+		std::shared_ptr<openshot::MediaSource> Acquire(const Json::Value& root, bool share=true);
+
+		/// Number of sources in use
+		size_t Count();
+	};
+
+}
+
+#endif
@@ -127,18 +127,23 @@
 #include "Fraction.h"
 #include "Frame.h"
 #include "FrameMapper.h"
+#include "ImageCache.h"
 #ifdef USE_IMAGEMAGICK
 	#include "ImageReader.h"
 	#include "ImageWriter.h"
 	#include "TextReader.h"
 #endif
 #include "KeyFrame.h"
+#include "MediaSource.h"
+#include "ParallelExporter.h"
 #include "PlayerBase.h"
 #include "Point.h"
 #include "Profiles.h"
+#include "ProjectSnapshot.h"
 #include "QtHtmlReader.h"
 #include "QtImageReader.h"
 #include "QtTextReader.h"
+#include "RenderCache.h"
 #include "TimelineBase.h"
 #include "Timeline.h"
 #include "Settings.h"
@@ -0,0 +1,378 @@
+/**
+ * @file
+ * @brief Source file for ParallelExporter class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "ParallelExporter.h"
+
+#include "Exceptions.h"
+#include "Timeline.h"
+#include "ZmqLogger.h"
+
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+using namespace openshot;
+
+ParallelExporter::ParallelExporter(Timeline* timeline, std::string path) :
+	timeline(timeline), path(path), threads(std::max(1u, std::thread::hardware_concurrency())),
+	has_video(false), fps(timeline->info.fps), width(timeline->info.width), height(timeline->info.height),
+	interlaced(false), top_field_first(false), video_bit_rate(0), has_audio(false), sample_rate(timeline->info.sample_rate),
+	channels(timeline->info.channels), channel_layout(timeline->info.channel_layout), audio_bit_rate(0)
+{
+}
+
+// Set video export options
+void ParallelExporter::SetVideoOptions(bool new_has_video, std::string codec, Fraction new_fps, int new_width, int new_height, Fraction new_pixel_ratio, bool new_interlaced, bool new_top_field_first, int bit_rate)
+{
+	has_video = new_has_video;
+	video_codec = codec;
+	fps = new_fps;
+	width = new_width;
+	height = new_height;
+	pixel_ratio = new_pixel_ratio;
+	interlaced = new_interlaced;
+	top_field_first = new_top_field_first;
+	video_bit_rate = bit_rate;
+}
+
+// Set audio export options
+void ParallelExporter::SetAudioOptions(bool new_has_audio, std::string codec, int new_sample_rate, int new_channels, ChannelLayout new_channel_layout, int bit_rate)
+{
+	has_audio = new_has_audio;
+	audio_codec = codec;
+	sample_rate = new_sample_rate;
+	channels = new_channels;
+	channel_layout = new_channel_layout;
+	audio_bit_rate = bit_rate;
+}
+
+// Set a codec option of every writer
+void ParallelExporter::SetOption(StreamType stream, std::string name, std::string value)
+{
+	options.push_back(std::make_pair(stream, std::make_pair(name, value)));
+}
+
+// Number of frames between keyframes
+int ParallelExporter::gop_size()
+{
+	int gop = 12;
+	for (const auto& option : options) {
+		if (option.first == VIDEO_STREAM && option.second.first == "g") {
+			std::stringstream convert(option.second.second);
+			convert >> gop;
+		}
+	}
+	return std::max(gop, 1);
+}
+
+// Create a copy of the timeline (with its own readers)
+Timeline* ParallelExporter::copy_timeline(int max_width, int max_height)
+{
+	Timeline* copy = new Timeline(timeline->info.width, timeline->info.height, timeline->info.fps,
+								  timeline->info.sample_rate, timeline->info.channels, timeline->info.channel_layout);
+
+	// Each copy decodes its files with its own readers (so copies don't seek each other's decoders,
+	// including clips which are only loaded when they're first needed)
+	copy->ShareMediaSources(false);
+	try {
+		copy->SetJson(timeline->Json());
+	} catch (...) {
+		delete copy;
+		throw;
+	}
+
+	copy->SetMaxSize(max_width, max_height);
+	copy->Open();
+	return copy;
+}
+
+// Apply the settings of this exporter to a writer, and open it
+void ParallelExporter::open_writer(FFmpegWriter& writer, bool with_video, bool with_audio)
+{
+	if (with_video)
+		writer.SetVideoOptions(true, video_codec, fps, width, height, pixel_ratio, interlaced, top_field_first, video_bit_rate);
+	if (with_audio)
+		writer.SetAudioOptions(true, audio_codec, sample_rate, channels, channel_layout, audio_bit_rate);
+	writer.PrepareStreams();
+
+	for (const auto& option : options) {
+		if ((option.first == VIDEO_STREAM && with_video) || (option.first == AUDIO_STREAM && with_audio))
+			writer.SetOption(option.first, option.second.first, option.second.second);
+	}
+	writer.Open();
+}
+
+// Export a range of frames of the timeline
+void ParallelExporter::Export(int64_t start, int64_t end)
+{
+	if (start < 1 || end < start)
+		throw InvalidOptions("The range of frames to export is invalid.", path);
+	if (!has_video && !has_audio)
+		throw InvalidOptions("No video or audio options were set.", path);
+
+	// Split the video into whole GOPs (about 2 segments per thread, so threads finishing early take more)
+	int64_t length = end - start + 1;
+	int gop = gop_size();
+	int64_t segment_length = (length + threads * 2 - 1) / (threads * 2);
+	segment_length = std::max<int64_t>((segment_length + gop - 1) / gop * gop, gop);
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod(
+		"ParallelExporter::Export",
+		"start", start,
+		"end", end,
+		"threads", threads,
+		"segment_length", segment_length);
+
+#if IS_FFMPEG_3_2
+	bool export_segments = has_video && threads > 1 && length > segment_length;
+#else
+	bool export_segments = false;
+#endif
+
+	if (!export_segments) {
+		// Export in one piece
+		std::unique_ptr<Timeline> copy(copy_timeline(width, height));
+		FFmpegWriter writer(path);
+		open_writer(writer, has_video, has_audio);
+		writer.WriteFrame(copy.get(), start, end);
+		writer.WriteTrailer();
+		writer.Close();
+		copy->Close();
+		return;
+	}
+
+	// Segments and audio are encoded to temporary files (with the format of the output file)
+	QTemporaryDir folder;
+	if (!folder.isValid())
+		throw InvalidFile("Could not create a temporary folder for the segments.", path);
+	QString suffix = QFileInfo(QString::fromStdString(path)).suffix();
+	std::vector<Segment> segments;
+	for (int64_t segment_start = start; segment_start <= end; segment_start += segment_length) {
+		QString segment_path = folder.filePath(QString("segment_%1.%2").arg(segments.size()).arg(suffix));
+		segments.push_back({segment_start, std::min(segment_start + segment_length - 1, end), segment_path.toStdString()});
+	}
+	std::string audio_path = has_audio ? folder.filePath(QString("audio.%1").arg(suffix)).toStdString() : "";
+
+	// Copies of the timeline
+	int video_threads = std::min<int>(threads, segments.size());
+	std::vector<std::unique_ptr<Timeline>> copies;
+	for (int i = 0; i < video_threads; i++)
+		copies.emplace_back(copy_timeline(width, height));
+	if (has_audio)
+		copies.emplace_back(copy_timeline(16, 16)); // audio only: frames are rendered at a tiny size
+
+	std::atomic<size_t> next_segment(0);
+	std::vector<std::exception_ptr> errors(copies.size());
+	std::vector<std::thread> workers;
+
+	// Render and encode the video segments
+	for (int i = 0; i < video_threads; i++) {
+		workers.emplace_back([this, i, &segments, &copies, &next_segment, &errors]() {
+			try {
+				for (size_t s = next_segment++; s < segments.size(); s = next_segment++) {
+					FFmpegWriter writer(segments[s].path);
+					open_writer(writer, true, false);
+					writer.WriteFrame(copies[i].get(), segments[s].start, segments[s].end);
+					writer.WriteTrailer();
+					writer.Close();
+				}
+			} catch (...) {
+				errors[i] = std::current_exception();
+				next_segment = segments.size();
+			}
+		});
+	}
+
+	// Render and encode the audio (in one piece, so it's continuous)
+	if (has_audio) {
+		workers.emplace_back([this, start, end, &audio_path, &copies, &errors]() {
+			try {
+				FFmpegWriter writer(audio_path);
+				open_writer(writer, false, true);
+				writer.WriteFrame(copies.back().get(), start, end);
+				writer.WriteTrailer();
+				writer.Close();
+			} catch (...) {
+				errors.back() = std::current_exception();
+			}
+		});
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+	for (auto& copy : copies)
+		copy->Close();
+	for (auto& error : errors) {
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	// Copy the encoded segments and audio into the output file
+	concatenate(segments, start, audio_path);
+}
+
+#if IS_FFMPEG_3_2
+// Open a file, and find a stream in it
+static int open_input(const std::string& path, AVMediaType type, AVFormatContext** input)
+{
+	if (avformat_open_input(input, path.c_str(), NULL, NULL) != 0)
+		throw InvalidFile("Could not open a segment.", path);
+	int index = -1;
+	if (avformat_find_stream_info(*input, NULL) >= 0)
+		index = av_find_best_stream(*input, type, -1, -1, NULL, 0);
+	if (index < 0) {
+		avformat_close_input(input);
+		throw NoStreamsFound("No stream was found in a segment.", path);
+	}
+	return index;
+}
+
+// Read the next packet of a stream (returns false at the end of the file)
+static bool read_packet(AVFormatContext* input, int index, AVPacket* packet)
+{
+	while (av_read_frame(input, packet) >= 0) {
+		if (packet->stream_index == index)
+			return true;
+		AV_FREE_PACKET(packet);
+	}
+	return false;
+}
+
+// Time of a packet (to interleave packets in order)
+static int64_t packet_time(AVPacket* packet)
+{
+	return packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+}
+#endif
+
+// Copy the packets of the segments and the audio into the output file
+void ParallelExporter::concatenate(const std::vector<Segment>& segments, int64_t start, const std::string& audio_path)
+{
+#if IS_FFMPEG_3_2
+	AVFormatContext* output = NULL;
+	AVFormatContext* video_input = NULL;
+	AVFormatContext* audio_input = NULL;
+	AVPacket* video_packet = av_packet_alloc();
+	AVPacket* audio_packet = av_packet_alloc();
+
+	try {
+		AV_OUTPUT_CONTEXT(&output, path.c_str());
+		if (!output)
+			throw InvalidFormat("Could not deduce output format from file extension.", path);
+
+		// Streams of the output file (with the codec parameters of the first segment and the audio)
+		size_t segment = 0;
+		int video_index = open_input(segments[segment].path, AVMEDIA_TYPE_VIDEO, &video_input);
+		AVStream* video_st = avformat_new_stream(output, NULL);
+		avcodec_parameters_copy(video_st->codecpar, video_input->streams[video_index]->codecpar);
+		video_st->codecpar->codec_tag = 0;
+		video_st->time_base = video_input->streams[video_index]->time_base;
+		video_st->avg_frame_rate = av_make_q(fps.num, fps.den);
+
+		int audio_index = -1;
+		AVStream* audio_st = NULL;
+		if (!audio_path.empty()) {
+			audio_index = open_input(audio_path, AVMEDIA_TYPE_AUDIO, &audio_input);
+			audio_st = avformat_new_stream(output, NULL);
+			avcodec_parameters_copy(audio_st->codecpar, audio_input->streams[audio_index]->codecpar);
+			audio_st->codecpar->codec_tag = 0;
+			audio_st->time_base = audio_input->streams[audio_index]->time_base;
+		}
+
+		if (!(output->oformat->flags & AVFMT_NOFILE) && avio_open(&output->pb, path.c_str(), AVIO_FLAG_WRITE) < 0)
+			throw InvalidFile("Could not open or write file.", path);
+		if (avformat_write_header(output, NULL) < 0)
+			throw InvalidFile("Could not write header to file.", path);
+
+		// Timestamps of each segment start at 0: offset them by the position of the segment
+		int64_t video_offset = 0;
+		bool has_video_packet = read_packet(video_input, video_index, video_packet);
+		bool has_audio_packet = audio_input && read_packet(audio_input, audio_index, audio_packet);
+
+		// Write the packets of both streams in order of their timestamps
+		while (has_video_packet || has_audio_packet) {
+			bool write_video = has_video_packet;
+			if (has_video_packet && has_audio_packet)
+				write_video = av_compare_ts(packet_time(video_packet) + video_offset, video_input->streams[video_index]->time_base,
+											packet_time(audio_packet), audio_input->streams[audio_index]->time_base) <= 0;
+
+			if (write_video) {
+				if (video_packet->pts != AV_NOPTS_VALUE)
+					video_packet->pts += video_offset;
+				if (video_packet->dts != AV_NOPTS_VALUE)
+					video_packet->dts += video_offset;
+				av_packet_rescale_ts(video_packet, video_input->streams[video_index]->time_base, video_st->time_base);
+				video_packet->stream_index = video_st->index;
+				video_packet->pos = -1;
+				int error_code = av_interleaved_write_frame(output, video_packet);
+				if (error_code < 0) {
+					ZmqLogger::Instance()->AppendDebugMethod("ParallelExporter::concatenate ERROR [" + av_err2string(error_code) + "]", "segment", segment);
+					throw InvalidFile("Could not write a video packet to the file.", path);
+				}
+
+				// Continue with the next segment (at the end of this one)
+				has_video_packet = read_packet(video_input, video_index, video_packet);
+				while (!has_video_packet && ++segment < segments.size()) {
+					avformat_close_input(&video_input);
+					video_index = open_input(segments[segment].path, AVMEDIA_TYPE_VIDEO, &video_input);
+					video_offset = av_rescale_q(segments[segment].start - start, av_make_q(fps.den, fps.num),
+												video_input->streams[video_index]->time_base);
+					has_video_packet = read_packet(video_input, video_index, video_packet);
+				}
+			} else {
+				av_packet_rescale_ts(audio_packet, audio_input->streams[audio_index]->time_base, audio_st->time_base);
+				audio_packet->stream_index = audio_st->index;
+				audio_packet->pos = -1;
+				int error_code = av_interleaved_write_frame(output, audio_packet);
+				if (error_code < 0) {
+					ZmqLogger::Instance()->AppendDebugMethod("ParallelExporter::concatenate ERROR [" + av_err2string(error_code) + "]");
+					throw InvalidFile("Could not write an audio packet to the file.", path);
+				}
+
+				has_audio_packet = read_packet(audio_input, audio_index, audio_packet);
+			}
+		}
+
+		av_write_trailer(output);
+	} catch (...) {
+		av_packet_free(&video_packet);
+		av_packet_free(&audio_packet);
+		if (video_input)
+			avformat_close_input(&video_input);
+		if (audio_input)
+			avformat_close_input(&audio_input);
+		if (output && output->pb)
+			avio_closep(&output->pb);
+		avformat_free_context(output);
+		throw;
+	}
+
+	av_packet_free(&video_packet);
+	av_packet_free(&audio_packet);
+	avformat_close_input(&video_input);
+	if (audio_input)
+		avformat_close_input(&audio_input);
+	if (!(output->oformat->flags & AVFMT_NOFILE))
+		avio_closep(&output->pb);
+	avformat_free_context(output);
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("ParallelExporter::concatenate", "segments", segments.size());
+#endif
+}
@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @brief Header file for ParallelExporter class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef OPENSHOT_PARALLEL_EXPORTER_H
+#define OPENSHOT_PARALLEL_EXPORTER_H
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ChannelLayouts.h"
+#include "FFmpegWriter.h"
+#include "Fraction.h"
+
+namespace openshot
+{
+	class Timeline;
+
+	/**
+	 * @brief Export a timeline with several threads, each rendering and encoding a segment of the video.
+	 *
+	 * The timeline is split into segments (a whole number of GOPs long, so keyframes are placed like
+	 * in a single encode). Each thread renders segments on its own copy of the timeline (with its own
+	 * decoders), and encodes them with its own FFmpegWriter. The audio is encoded in one piece (on one
+	 * more thread), so it stays continuous across segments. The encoded segments and audio are then
+	 * copied (without encoding them again) into the output file.
+	 *
+	 * Options are set like the options of an FFmpegWriter. Every segment must be encoded with the same
+	 * settings, so codecs with options which change per encode (such as 2-pass encoding) should be
+	 * exported with an FFmpegWriter instead.
+	 *
+	 * @code
+	 * openshot::ParallelExporter e(&t, "/home/jonathan/NewVideo.mp4");
+	 * e.SetAudioOptions(true, "aac", 44100, 2, openshot::ChannelLayout::LAYOUT_STEREO, 128000);
+	 * e.SetVideoOptions(true, "libx264", openshot::Fraction(30,1), 1920, 1080, openshot::Fraction(1,1), false, false, 8000000);
+	 * e.SetOption(openshot::VIDEO_STREAM, "crf", "23");
+	 * e.Export(1, t.GetMaxFrame());
+	 * @endcode
+	 */
+	class ParallelExporter {
+	private:
+		openshot::Timeline* timeline;
+		std::string path;
+		int threads;
+
+		// Writer settings (applied to every writer)
+		bool has_video;
+		std::string video_codec;
+		openshot::Fraction fps;
+		int width;
+		int height;
+		openshot::Fraction pixel_ratio;
+		bool interlaced;
+		bool top_field_first;
+		int video_bit_rate;
+		bool has_audio;
+		std::string audio_codec;
+		int sample_rate;
+		int channels;
+		openshot::ChannelLayout channel_layout;
+		int audio_bit_rate;
+		std::vector<std::pair<openshot::StreamType, std::pair<std::string, std::string>>> options;
+
+		/// A range of frames, encoded to its own file
+		struct Segment {
+			int64_t start;
+			int64_t end;
+			std::string path;
+		};
+
+		/// Number of frames between keyframes (the "g" option, or the default of FFmpegWriter)
+		int gop_size();
+
+		/// Create a copy of the timeline (with its own readers), rendering frames at a size
+		openshot::Timeline* copy_timeline(int max_width, int max_height);
+
+		/// Apply the settings of this exporter to a writer (with or without audio and video), and open it
+		void open_writer(openshot::FFmpegWriter& writer, bool with_video, bool with_audio);
+
+		/// Copy the packets of the segments and the audio into the output file
+		void concatenate(const std::vector<Segment>& segments, int64_t start, const std::string& audio_path);
+
+	public:
+		/// @brief Constructor for ParallelExporter
+		/// @param timeline The timeline to export (it isn't changed, or used while exporting)
+		/// @param path The path of the video file to create
+		ParallelExporter(openshot::Timeline* timeline, std::string path);
+
+		/// Set the number of threads which render and encode segments (defaults to the number of cores)
+		void SetThreads(int new_threads) { threads = std::max(new_threads, 1); };
+
+		/// Set video export options (see FFmpegWriter::SetVideoOptions)
+		void SetVideoOptions(bool has_video, std::string codec, openshot::Fraction fps, int width, int height, openshot::Fraction pixel_ratio, bool interlaced, bool top_field_first, int bit_rate);
+
+		/// Set audio export options (see FFmpegWriter::SetAudioOptions)
+		void SetAudioOptions(bool has_audio, std::string codec, int sample_rate, int channels, openshot::ChannelLayout channel_layout, int bit_rate);
+
+		/// Set a codec option of every writer (see FFmpegWriter::SetOption)
+		void SetOption(openshot::StreamType stream, std::string name, std::string value);
+
+		/// Export a range of frames of the timeline
+		/// @param start The first frame to export
+		/// @param end The last frame to export
+		void Export(int64_t start, int64_t end);
+	};
+
+}
+
+#endif
@@ -101,7 +101,7 @@ void Point::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Point::SetJsonValue(const Json::Value root) {
+void Point::SetJsonValue(const Json::Value& root) {
 
 	if (!root["co"].isNull())
 		co.SetJsonValue(root["co"]); // update coordinate
@@ -245,7 +245,7 @@ void Profile::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Profile::SetJsonValue(const Json::Value root) {
+void Profile::SetJsonValue(const Json::Value& root) {
 
 	if (!root["height"].isNull())
 		info.height = root["height"].asInt();
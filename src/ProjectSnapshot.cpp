@@ -0,0 +1,396 @@
+/**
+ * @file
+ * @brief Source file for ProjectSnapshot class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "ProjectSnapshot.h"
+
+#include "Exceptions.h"
+#include "Point.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace openshot;
+
+// Snapshot files start with these values
+static const quint32 SNAPSHOT_MAGIC = 0x4f535053; // "OSPS"
+static const quint32 SNAPSHOT_VERSION = 1;
+
+// Objects nested deeper than this are invalid (so a damaged file can't overflow the stack)
+static const int SNAPSHOT_MAX_DEPTH = 256;
+
+// Type of each value
+enum SnapshotTag : quint8 {
+	TAG_NULL,
+	TAG_FALSE,
+	TAG_TRUE,
+	TAG_INT,
+	TAG_UINT,
+	TAG_DOUBLE,
+	TAG_STRING,
+	TAG_ARRAY,
+	TAG_OBJECT,
+	TAG_POINTS	///< An array of keyframe points (saved as fixed-size records)
+};
+
+// A keyframe point (as saved in a TAG_POINTS array)
+struct SnapshotPoint {
+	double co_x, co_y;
+	double handle_left_x, handle_left_y;
+	double handle_right_x, handle_right_y;
+	qint32 interpolation;
+	qint32 handle_type;
+};
+
+namespace {
+
+	// Writes values into a snapshot
+	class SnapshotWriter {
+	public:
+		std::string body;
+		std::vector<std::string> keys;
+		std::map<std::string, quint32> key_indexes;
+
+		template <typename T>
+		void write(T value) {
+			value = qToLittleEndian(value);
+			body.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void write_double(double value) {
+			quint64 bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			write(bits);
+		}
+
+		void write_string(const char* begin, const char* end) {
+			write(quint32(end - begin));
+			body.append(begin, end - begin);
+		}
+
+		void write_key(const std::string& key) {
+			auto itr = key_indexes.find(key);
+			if (itr == key_indexes.end()) {
+				itr = key_indexes.emplace(key, quint32(keys.size())).first;
+				keys.push_back(key);
+			}
+			write(itr->second);
+		}
+
+		// Is a value a coordinate (as saved by Coordinate::JsonValue)
+		static bool is_coordinate(const Json::Value& value) {
+			return value.isObject() && value.size() == 2 &&
+				value["X"].type() == Json::realValue && value["Y"].type() == Json::realValue;
+		}
+
+		// Is a value a keyframe point (as saved by Point::JsonValue)
+		static bool is_point(const Json::Value& value) {
+			if (!value.isObject() || value["interpolation"].type() != Json::intValue || !is_coordinate(value["co"]))
+				return false;
+			if (value["interpolation"].asInt() != BEZIER)
+				return value.size() == 2;
+			return value.size() == 5 && value["handle_type"].type() == Json::intValue &&
+				is_coordinate(value["handle_left"]) && is_coordinate(value["handle_right"]);
+		}
+
+		void write_points(const Json::Value& value) {
+			write(quint8(TAG_POINTS));
+			write(quint32(value.size()));
+			for (const auto& point : value) {
+				SnapshotPoint p = {};
+				p.co_x = point["co"]["X"].asDouble();
+				p.co_y = point["co"]["Y"].asDouble();
+				p.interpolation = point["interpolation"].asInt();
+				if (p.interpolation == BEZIER) {
+					p.handle_left_x = point["handle_left"]["X"].asDouble();
+					p.handle_left_y = point["handle_left"]["Y"].asDouble();
+					p.handle_right_x = point["handle_right"]["X"].asDouble();
+					p.handle_right_y = point["handle_right"]["Y"].asDouble();
+					p.handle_type = point["handle_type"].asInt();
+				}
+				write_double(p.co_x);
+				write_double(p.co_y);
+				write_double(p.handle_left_x);
+				write_double(p.handle_left_y);
+				write_double(p.handle_right_x);
+				write_double(p.handle_right_y);
+				write(p.interpolation);
+				write(p.handle_type);
+			}
+		}
+
+		void write_value(const Json::Value& value) {
+			switch (value.type()) {
+				case Json::nullValue:
+					write(quint8(TAG_NULL));
+					break;
+				case Json::booleanValue:
+					write(quint8(value.asBool() ? TAG_TRUE : TAG_FALSE));
+					break;
+				case Json::intValue:
+					write(quint8(TAG_INT));
+					write(qint64(value.asLargestInt()));
+					break;
+				case Json::uintValue:
+					write(quint8(TAG_UINT));
+					write(quint64(value.asLargestUInt()));
+					break;
+				case Json::realValue:
+					write(quint8(TAG_DOUBLE));
+					write_double(value.asDouble());
+					break;
+				case Json::stringValue: {
+					const char* begin = nullptr;
+					const char* end = nullptr;
+					value.getString(&begin, &end);
+					write(quint8(TAG_STRING));
+					write_string(begin, end);
+					break;
+				}
+				case Json::arrayValue: {
+					// Keyframe points (the bulk of most projects) are saved as one contiguous array
+					bool points = value.size() > 0;
+					for (const auto& item : value) {
+						if (!is_point(item)) {
+							points = false;
+							break;
+						}
+					}
+					if (points) {
+						write_points(value);
+						break;
+					}
+					write(quint8(TAG_ARRAY));
+					write(quint32(value.size()));
+					for (const auto& item : value)
+						write_value(item);
+					break;
+				}
+				case Json::objectValue:
+					write(quint8(TAG_OBJECT));
+					write(quint32(value.size()));
+					for (auto itr = value.begin(); itr != value.end(); ++itr) {
+						write_key(itr.name());
+						write_value(*itr);
+					}
+					break;
+			}
+		}
+	};
+
+	// Reads values from a snapshot
+	class SnapshotReader {
+	public:
+		const char* position;
+		const char* end;
+		std::vector<std::string> keys;
+
+		SnapshotReader(const char* data, size_t size) : position(data), end(data + size) {};
+
+		void require(size_t bytes) {
+			if (size_t(end - position) < bytes)
+				throw InvalidFormat("The snapshot is truncated.");
+		}
+
+		template <typename T>
+		T read() {
+			require(sizeof(T));
+			T value;
+			std::memcpy(&value, position, sizeof(T));
+			position += sizeof(T);
+			return qFromLittleEndian(value);
+		}
+
+		double read_double() {
+			quint64 bits = read<quint64>();
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		std::string read_string() {
+			quint32 length = read<quint32>();
+			require(length);
+			std::string value(position, length);
+			position += length;
+			return value;
+		}
+
+		// Read a count of items (each at least min_bytes long)
+		quint32 read_count(size_t min_bytes) {
+			quint32 count = read<quint32>();
+			require(size_t(count) * min_bytes);
+			return count;
+		}
+
+		static void read_coordinate(Json::Value& value, double x, double y) {
+			value["X"] = x;
+			value["Y"] = y;
+		}
+
+		void read_points(Json::Value& value) {
+			quint32 count = read_count(6 * sizeof(double) + 2 * sizeof(qint32));
+			value = Json::Value(Json::arrayValue);
+			value.resize(count);
+			for (quint32 index = 0; index < count; index++) {
+				SnapshotPoint p;
+				p.co_x = read_double();
+				p.co_y = read_double();
+				p.handle_left_x = read_double();
+				p.handle_left_y = read_double();
+				p.handle_right_x = read_double();
+				p.handle_right_y = read_double();
+				p.interpolation = read<qint32>();
+				p.handle_type = read<qint32>();
+
+				Json::Value& point = value[index];
+				read_coordinate(point["co"], p.co_x, p.co_y);
+				if (p.interpolation == BEZIER) {
+					read_coordinate(point["handle_left"], p.handle_left_x, p.handle_left_y);
+					read_coordinate(point["handle_right"], p.handle_right_x, p.handle_right_y);
+					point["handle_type"] = p.handle_type;
+				}
+				point["interpolation"] = p.interpolation;
+			}
+		}
+
+		void read_value(Json::Value& value, int depth) {
+			if (depth > SNAPSHOT_MAX_DEPTH)
+				throw InvalidFormat("The snapshot is nested too deeply.");
+
+			quint8 tag = read<quint8>();
+			switch (tag) {
+				case TAG_NULL:
+					value = Json::Value();
+					break;
+				case TAG_FALSE:
+				case TAG_TRUE:
+					value = (tag == TAG_TRUE);
+					break;
+				case TAG_INT:
+					value = Json::Value(Json::LargestInt(read<qint64>()));
+					break;
+				case TAG_UINT:
+					value = Json::Value(Json::LargestUInt(read<quint64>()));
+					break;
+				case TAG_DOUBLE:
+					value = read_double();
+					break;
+				case TAG_STRING:
+					value = read_string();
+					break;
+				case TAG_ARRAY: {
+					quint32 count = read_count(1);
+					value = Json::Value(Json::arrayValue);
+					value.resize(count);
+					for (quint32 index = 0; index < count; index++)
+						read_value(value[index], depth + 1);
+					break;
+				}
+				case TAG_OBJECT: {
+					quint32 count = read_count(sizeof(quint32) + 1);
+					value = Json::Value(Json::objectValue);
+					for (quint32 index = 0; index < count; index++) {
+						quint32 key = read<quint32>();
+						if (key >= keys.size())
+							throw InvalidFormat("The snapshot has an invalid key.");
+						read_value(value[keys[key]], depth + 1);
+					}
+					break;
+				}
+				case TAG_POINTS:
+					read_points(value);
+					break;
+				default:
+					throw InvalidFormat("The snapshot has an invalid value.");
+			}
+		}
+	};
+
+}
+
+// Encode JSON as a snapshot
+std::string ProjectSnapshot::Encode(const Json::Value& root)
+{
+	// Values are written first (collecting the keys), and written after the header and keys
+	SnapshotWriter values;
+	values.write_value(root);
+
+	SnapshotWriter snapshot;
+	snapshot.write(SNAPSHOT_MAGIC);
+	snapshot.write(SNAPSHOT_VERSION);
+	snapshot.write(quint32(values.keys.size()));
+	for (const auto& key : values.keys)
+		snapshot.write_string(key.data(), key.data() + key.size());
+	snapshot.body.append(values.body);
+
+	return snapshot.body;
+}
+
+// Decode a snapshot into JSON
+Json::Value ProjectSnapshot::Decode(const char* data, size_t size)
+{
+	SnapshotReader snapshot(data, size);
+	if (snapshot.read<quint32>() != SNAPSHOT_MAGIC)
+		throw InvalidFormat("The data is not a project snapshot.");
+	if (snapshot.read<quint32>() != SNAPSHOT_VERSION)
+		throw InvalidFormat("The project snapshot is from an unsupported version.");
+
+	quint32 key_count = snapshot.read_count(sizeof(quint32));
+	snapshot.keys.reserve(key_count);
+	for (quint32 index = 0; index < key_count; index++)
+		snapshot.keys.push_back(snapshot.read_string());
+
+	Json::Value root;
+	snapshot.read_value(root, 0);
+	return root;
+}
+
+// Save JSON to a snapshot file
+void ProjectSnapshot::Save(const Json::Value& root, const std::string& path)
+{
+	std::string data = Encode(root);
+
+	QSaveFile snapshot_file(QString::fromStdString(path));
+	if (!snapshot_file.open(QIODevice::WriteOnly) ||
+		snapshot_file.write(data.data(), data.size()) != qint64(data.size()) ||
+		!snapshot_file.commit())
+		throw InvalidFile("The project snapshot could not be saved.", path);
+}
+
+// Load the JSON of a snapshot file
+Json::Value ProjectSnapshot::Load(const std::string& path)
+{
+	QFile snapshot_file(QString::fromStdString(path));
+	if (!snapshot_file.open(QIODevice::ReadOnly))
+		throw InvalidFile("The project snapshot could not be opened.", path);
+
+	try {
+		// Decode the file in place (reading it instead, if it can't be mapped)
+		qint64 size = snapshot_file.size();
+		uchar* mapped = size > 0 ? snapshot_file.map(0, size) : nullptr;
+		if (mapped) {
+			Json::Value root = Decode(reinterpret_cast<const char*>(mapped), size);
+			snapshot_file.unmap(mapped);
+			return root;
+		}
+		QByteArray data = snapshot_file.readAll();
+		return Decode(data.constData(), data.size());
+	}
+	catch (const InvalidFormat& e) {
+		throw InvalidFormat(e.what(), path);
+	}
+}
@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief Header file for ProjectSnapshot class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef OPENSHOT_PROJECT_SNAPSHOT_H
+#define OPENSHOT_PROJECT_SNAPSHOT_H
+
+#include <cstddef>
+#include <string>
+
+#include "Json.h"
+
+namespace openshot
+{
+	/**
+	 * @brief A compact binary copy of a project's JSON, which is much faster to save and load than JSON text.
+	 *
+	 * A snapshot holds the same values as the JSON of a project (so it's loaded with SetJsonValue()), in a
+	 * versioned binary layout: every object key is saved once (in a table at the start of the file), numbers
+	 * are saved as raw little-endian values, and the points of keyframes are saved as one contiguous array
+	 * of fixed-size records. Files are memory mapped while they are loaded.
+	 *
+	 * Snapshots are meant for autosaves and caches of a project; the JSON project file is still the
+	 * format to share projects with (snapshots of a newer version aren't loaded by older versions).
+	 *
+	 * @code
+	 * openshot::ProjectSnapshot::Save(t.JsonValue(), "/home/jonathan/project.osps");
+	 * t.SetJsonValue(openshot::ProjectSnapshot::Load("/home/jonathan/project.osps"));
+	 * @endcode
+	 */
+	class ProjectSnapshot {
+	public:
+		/// Encode JSON as a snapshot
+		static std::string Encode(const Json::Value& root);
+
+		/// Decode a snapshot into JSON (throws InvalidFormat if the data isn't a valid snapshot)
+		static Json::Value Decode(const char* data, size_t size);
+
+		/// Save JSON to a snapshot file (replacing the file only once it's completely written)
+		static void Save(const Json::Value& root, const std::string& path);
+
+		/// Load the JSON of a snapshot file
+		static Json::Value Load(const std::string& path);
+	};
+
+}
+
+#endif
@@ -0,0 +1,259 @@
+/**
+ * @file
+ * @brief Source file for ProtobufFrameWriter and ProtobufFrameReader classes
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "ProtobufFrameFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QtEndian>
+
+using namespace openshot;
+
+// File layout (integers are little-endian):
+//   "OSFRAMES", version (u32), header size (u32), header message
+//   frame records (one serialized frame message each)
+//   frame count (u64), and per frame: frame id (i64), record offset (u64), record size (u32)
+//   index offset (u64), "OSFRAMES"
+static const char FILE_MAGIC[8] = {'O', 'S', 'F', 'R', 'A', 'M', 'E', 'S'};
+static const uint32_t FILE_VERSION = 1;
+static const size_t INDEX_ENTRY_SIZE = 8 + 8 + 4;
+// Frame records are buffered and written in chunks of (at least) this size
+static const size_t CHUNK_SIZE = 1 << 20;
+
+template <typename T>
+static void appendValue(std::string& out, T value) {
+	value = qToLittleEndian(value);
+	out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T readValue(const char* data) {
+	T value;
+	std::memcpy(&value, data, sizeof(T));
+	return qFromLittleEndian(value);
+}
+
+// Create the file, and write the header message
+ProtobufFrameWriter::ProtobufFrameWriter(const std::string& path, const google::protobuf::MessageLite& header)
+	: output(path, std::ios::out | std::ios::trunc | std::ios::binary), offset(0), failed(false)
+{
+	std::string header_data;
+	if (!header.SerializeToString(&header_data))
+		failed = true;
+
+	chunk.append(FILE_MAGIC, sizeof(FILE_MAGIC));
+	appendValue<uint32_t>(chunk, FILE_VERSION);
+	appendValue<uint32_t>(chunk, header_data.size());
+	chunk.append(header_data);
+	flush();
+}
+
+ProtobufFrameWriter::~ProtobufFrameWriter()
+{
+	if (output.is_open())
+		Close();
+}
+
+// Write the buffered records to the file
+void ProtobufFrameWriter::flush()
+{
+	output.write(chunk.data(), chunk.size());
+	offset += chunk.size();
+	chunk.clear();
+	if (!output.good())
+		failed = true;
+}
+
+// Append the data of a frame
+bool ProtobufFrameWriter::AddFrame(int64_t frame_id, const google::protobuf::MessageLite& frame)
+{
+	size_t record_offset = offset + chunk.size();
+	if (failed || !frame.AppendToString(&chunk)) {
+		failed = true;
+		return false;
+	}
+	index.push_back({frame_id, record_offset, (uint32_t)(offset + chunk.size() - record_offset)});
+
+	if (chunk.size() >= CHUNK_SIZE)
+		flush();
+	return !failed;
+}
+
+// Write the frame index and close the file
+bool ProtobufFrameWriter::Close()
+{
+	if (!output.is_open())
+		return !failed;
+
+	// Sort the index by frame number, keeping the last record of frames added more than once
+	std::stable_sort(index.begin(), index.end(),
+		[](const IndexEntry& a, const IndexEntry& b) { return a.frame_id < b.frame_id; });
+	std::vector<IndexEntry> unique_index;
+	unique_index.reserve(index.size());
+	for (const IndexEntry& entry : index) {
+		if (!unique_index.empty() && unique_index.back().frame_id == entry.frame_id)
+			unique_index.back() = entry;
+		else
+			unique_index.push_back(entry);
+	}
+
+	flush();
+	uint64_t index_offset = offset;
+	appendValue<uint64_t>(chunk, unique_index.size());
+	for (const IndexEntry& entry : unique_index) {
+		appendValue<int64_t>(chunk, entry.frame_id);
+		appendValue<uint64_t>(chunk, entry.offset);
+		appendValue<uint32_t>(chunk, entry.size);
+		if (chunk.size() >= CHUNK_SIZE)
+			flush();
+	}
+	appendValue<uint64_t>(chunk, index_offset);
+	chunk.append(FILE_MAGIC, sizeof(FILE_MAGIC));
+	flush();
+
+	output.close();
+	index.clear();
+	return !failed;
+}
+
+ProtobufFrameReader::ProtobufFrameReader()
+	: data(nullptr), size(0), headerOffset(0), headerSize(0)
+{
+}
+
+ProtobufFrameReader::~ProtobufFrameReader()
+{
+	Close();
+}
+
+// Open a file written by ProtobufFrameWriter
+bool ProtobufFrameReader::Open(const std::string& path)
+{
+	Close();
+
+	file.setFileName(QString::fromStdString(path));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	// Files which don't start with the magic string are single protobuf messages
+	size = file.size();
+	char magic[sizeof(FILE_MAGIC)];
+	if (size < sizeof(FILE_MAGIC) || file.read(magic, sizeof(magic)) != sizeof(magic)
+		|| std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0) {
+		Close();
+		return false;
+	}
+
+	// Frame-indexed files which are truncated or damaged can't be read (nor parsed as one message)
+	const uint64_t min_size = sizeof(FILE_MAGIC) + 4 + 4 + 8 + 8 + sizeof(FILE_MAGIC);
+	if (size < min_size) {
+		Close();
+		throw InvalidFile("The frame data file is truncated.", path);
+	}
+
+	const uchar* mapped = file.map(0, size);
+	if (mapped) {
+		data = reinterpret_cast<const char*>(mapped);
+	} else {
+		// Some file systems can't be mapped: read the file instead
+		file.seek(0);
+		buffer = file.readAll();
+		if ((uint64_t)buffer.size() != size) {
+			Close();
+			throw InvalidFile("The frame data file could not be read.", path);
+		}
+		data = buffer.constData();
+	}
+
+	// Offsets are checked without adding them up (so damaged values can't overflow)
+	const uint64_t index_end = size - sizeof(FILE_MAGIC) - 8;
+	uint64_t index_offset = readValue<uint64_t>(data + index_end);
+	headerSize = readValue<uint32_t>(data + sizeof(FILE_MAGIC) + 4);
+	headerOffset = sizeof(FILE_MAGIC) + 4 + 4;
+	if (std::memcmp(data + size - sizeof(FILE_MAGIC), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+		|| readValue<uint32_t>(data + sizeof(FILE_MAGIC)) != FILE_VERSION
+		|| index_offset > index_end - 8
+		|| index_offset < headerOffset
+		|| headerSize > index_offset - headerOffset) {
+		Close();
+		throw InvalidFile("The frame data file is truncated or damaged.", path);
+	}
+
+	// Load the index (frame records stay in the mapped file until they're read)
+	uint64_t count = readValue<uint64_t>(data + index_offset);
+	if (count != (index_end - index_offset - 8) / INDEX_ENTRY_SIZE) {
+		Close();
+		throw InvalidFile("The frame data file has a damaged index.", path);
+	}
+	index.resize(count);
+	const char* entry = data + index_offset + 8;
+	for (IndexEntry& e : index) {
+		e.frame_id = readValue<int64_t>(entry);
+		e.offset = readValue<uint64_t>(entry + 8);
+		e.size = readValue<uint32_t>(entry + 16);
+		entry += INDEX_ENTRY_SIZE;
+		if (e.offset < headerOffset + headerSize || e.offset > index_offset || e.size > index_offset - e.offset) {
+			Close();
+			throw InvalidFile("The frame data file has a damaged index.", path);
+		}
+	}
+	return true;
+}
+
+// Unmap and close the file
+void ProtobufFrameReader::Close()
+{
+	if (file.isOpen()) {
+		if (data && buffer.isEmpty())
+			file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+		file.close();
+	}
+	buffer.clear();
+	data = nullptr;
+	size = 0;
+	index.clear();
+}
+
+// Check if the file has data for a frame
+bool ProtobufFrameReader::Contains(int64_t frame_id) const
+{
+	auto it = std::lower_bound(index.begin(), index.end(), frame_id,
+		[](const IndexEntry& e, int64_t id) { return e.frame_id < id; });
+	return it != index.end() && it->frame_id == frame_id;
+}
+
+// Parse the header message
+bool ProtobufFrameReader::ReadHeader(google::protobuf::MessageLite& header) const
+{
+	if (!data)
+		return false;
+	return header.ParseFromArray(data + headerOffset, headerSize);
+}
+
+// Parse the data of a frame
+bool ProtobufFrameReader::ReadFrame(int64_t frame_id, google::protobuf::MessageLite& frame) const
+{
+	auto it = std::lower_bound(index.begin(), index.end(), frame_id,
+		[](const IndexEntry& e, int64_t id) { return e.frame_id < id; });
+	if (it == index.end() || it->frame_id != frame_id)
+		return false;
+	return frame.ParseFromArray(data + it->offset, it->size);
+}
+
+// Parse the data of the i-th frame
+bool ProtobufFrameReader::ReadFrameAt(size_t i, google::protobuf::MessageLite& frame) const
+{
+	if (i >= index.size())
+		return false;
+	return frame.ParseFromArray(data + index[i].offset, index[i].size);
+}
@@ -0,0 +1,165 @@
+/**
+ * @file
+ * @brief Header file for ProtobufFrameWriter and ProtobufFrameReader classes
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef OPENSHOT_PROTOBUF_FRAME_FILE_H
+#define OPENSHOT_PROTOBUF_FRAME_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <QByteArray>
+#include <QFile>
+
+#include <google/protobuf/message_lite.h>
+
+#include "Exceptions.h"
+
+namespace openshot
+{
+	/**
+	 * @brief Write per-frame protobuf data (tracker, stabilizer or object detection data) to disk,
+	 * one frame at a time.
+	 *
+	 * The file starts with a header message (everything but the frames), followed by one record
+	 * per frame, written out in chunks as frames are added, and ends with an index of the frame
+	 * records' offsets, so ProtobufFrameReader can access any single frame without parsing the
+	 * whole file.
+	 */
+	class ProtobufFrameWriter {
+	private:
+		struct IndexEntry {
+			int64_t frame_id;
+			uint64_t offset;
+			uint32_t size;
+		};
+
+		std::ofstream output;
+		std::string chunk;
+		std::vector<IndexEntry> index;
+		uint64_t offset;
+		bool failed;
+
+		void flush();
+
+	public:
+		/// Create the file, and write the header message (which shouldn't contain the frames)
+		ProtobufFrameWriter(const std::string& path, const google::protobuf::MessageLite& header);
+		~ProtobufFrameWriter();
+
+		/// Append the data of a frame (if a frame is added twice, the last one is kept)
+		bool AddFrame(int64_t frame_id, const google::protobuf::MessageLite& frame);
+
+		/// Write the frame index and close the file. Returns false if anything failed to be written.
+		bool Close();
+	};
+
+	/**
+	 * @brief Memory-map a file written by ProtobufFrameWriter, and parse frames on request.
+	 *
+	 * Only the frame index is loaded when opening: frame records are parsed straight from the
+	 * mapped file when they're read. Reading is thread-safe.
+	 */
+	class ProtobufFrameReader {
+	private:
+		struct IndexEntry {
+			int64_t frame_id;
+			uint64_t offset;
+			uint32_t size;
+		};
+
+		QFile file;
+		QByteArray buffer; // Used when the file can't be mapped
+		const char* data;
+		uint64_t size;
+		uint64_t headerOffset;
+		uint32_t headerSize;
+		std::vector<IndexEntry> index;
+
+	public:
+		ProtobufFrameReader();
+		~ProtobufFrameReader();
+
+		/// Open a file written by ProtobufFrameWriter. Returns false if the file is missing, or isn't
+		/// a frame-indexed file (i.e. a single protobuf message, as written by older versions), and
+		/// throws InvalidFile if it's a frame-indexed file which is truncated or damaged.
+		bool Open(const std::string& path);
+
+		/// Unmap and close the file
+		void Close();
+
+		/// Check if a file is open
+		bool IsOpen() const { return data != nullptr; }
+
+		/// Number of frames in the file
+		size_t Count() const { return index.size(); }
+
+		/// Frame number of the i-th frame (frames are sorted by frame number)
+		int64_t FrameId(size_t i) const { return index[i].frame_id; }
+
+		/// Check if the file has data for a frame
+		bool Contains(int64_t frame_id) const;
+
+		/// Parse the header message
+		bool ReadHeader(google::protobuf::MessageLite& header) const;
+
+		/// Parse the data of a frame. Returns false if the frame isn't in the file.
+		bool ReadFrame(int64_t frame_id, google::protobuf::MessageLite& frame) const;
+
+		/// Parse the data of the i-th frame
+		bool ReadFrameAt(size_t i, google::protobuf::MessageLite& frame) const;
+	};
+
+	/// Read the header and every frame (in frame number order) of a protobuf data file, passing each
+	/// frame message to @a callback. Both frame-indexed files and single protobuf messages (as written
+	/// by older versions) are supported. The frames are removed from @a message afterwards.
+	/// Returns false if the file can't be parsed (including frame-indexed files which are truncated or damaged).
+	template <typename Message, typename Callback>
+	bool ReadProtobufFrames(const std::string& path, Message& message, Callback callback)
+	{
+		using FrameMessage = typename std::decay<decltype(message.frame(0))>::type;
+
+		ProtobufFrameReader reader;
+		bool indexed = false;
+		try {
+			indexed = reader.Open(path);
+		} catch (const InvalidFile& e) {
+			return false;
+		}
+		if (indexed) {
+			if (!reader.ReadHeader(message))
+				return false;
+
+			FrameMessage frame;
+			for (size_t i = 0; i < reader.Count(); i++) {
+				if (!reader.ReadFrameAt(i, frame))
+					return false;
+				callback(frame);
+			}
+			return true;
+		}
+
+		// Not frame-indexed: parse the whole message
+		std::fstream input(path, std::ios::in | std::ios::binary);
+		if (!message.ParseFromIstream(&input))
+			return false;
+
+		for (const FrameMessage& frame : message.frame())
+			callback(frame);
+		message.clear_frame();
+		return true;
+	}
+}
+
+#endif
@@ -13,6 +13,7 @@
 
 #include "PlayerPrivate.h"
 #include "Exceptions.h"
+#include "Timeline.h"
 
 #include <queue>
 #include <thread>    // for std::this_thread::sleep_for
@@ -24,7 +25,8 @@ namespace openshot
     // Constructor
     PlayerPrivate::PlayerPrivate(openshot::RendererBase *rb)
     : renderer(rb), Thread("player"), video_position(1), audio_position(0),
-      speed(1), reader(NULL), last_video_position(1), max_sleep_ms(125000), playback_frames(0), is_dirty(true)
+      speed(1), reader(NULL), last_video_position(1), max_sleep_ms(125000), playback_frames(0), is_dirty(true),
+      is_scrub_frame(false)
     {
         videoCache = new openshot::VideoCacheThread();
         audioPlayback = new openshot::AudioPlaybackThread(videoCache);
@@ -81,6 +83,11 @@ namespace openshot
                 // Sleep for a fraction of frame duration
                 std::this_thread::sleep_for(frame_duration / 4);
 
+                // Refine a frame rendered while scrubbing, once the playhead rests on it
+                if (is_scrub_frame && speed == 0 && video_position == last_video_position) {
+                    refineFrame();
+                }
+
                 // Reset current playback start time
                 start_time = std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::now());
                 playback_frames = 0;
@@ -153,6 +160,14 @@ namespace openshot
             // Update cache on which frame was retrieved
             videoCache->Seek(video_position);
 
+            // While scrubbing a paused timeline, quickly render uncached frames at a reduced
+            // resolution (refined once the playhead rests)
+            Timeline *timeline = dynamic_cast<Timeline *>(reader);
+            is_scrub_frame = speed == 0 && timeline && !timeline->GetCache()->Contains(video_position);
+            if (is_scrub_frame) {
+                return timeline->GetScrubFrame(video_position);
+            }
+
             // return frame from reader
             return reader->GetFrame(video_position);
         }
@@ -165,6 +180,25 @@ namespace openshot
     return std::shared_ptr<openshot::Frame>();
     }
 
+    // Render the current frame again at full resolution
+    void PlayerPrivate::refineFrame()
+    {
+        is_scrub_frame = false;
+        try {
+            frame = reader->GetFrame(video_position);
+        } catch (const ReaderClosed & e) {
+            return;
+        } catch (const OutOfBoundsFrame & e) {
+            return;
+        }
+
+        // Display the refined frame (unless the playhead moved in the meantime)
+        if (frame && video_position == last_video_position) {
+            videoPlayback->frame = frame;
+            videoPlayback->render.signal();
+        }
+    }
+
     // Seek to a new position
     void PlayerPrivate::Seek(int64_t new_position)
     {
@@ -43,6 +43,7 @@ namespace openshot
 	int64_t last_video_position; /// The last frame actually displayed
 	int max_sleep_ms; /// The max milliseconds to sleep (when syncing audio and video)
 	bool is_dirty; /// Detect if a frame needs to be refreshed (calls to Seek() set this to true)
+	bool is_scrub_frame; /// The current frame has a reduced resolution (rendered while scrubbing)
 
 	/// Constructor
 	PlayerPrivate(openshot::RendererBase *rb);
@@ -64,6 +65,9 @@ namespace openshot
 	/// Get the next frame (based on speed and direction)
 	std::shared_ptr<openshot::Frame> getFrame();
 
+	/// Render the current frame again at full resolution (once the playhead rests after scrubbing)
+	void refineFrame();
+
 	/// The parent class of PlayerPrivate
 	friend class QtPlayer;
     };
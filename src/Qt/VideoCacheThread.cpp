@@ -20,7 +20,8 @@
 #include "Timeline.h"
 
 #include <algorithm>
-#include <thread>    // for std::this_thread::sleep_for
+#include <cmath>
+#include <thread>
 #include <chrono>    // for std::chrono::microseconds
 
 namespace openshot
@@ -28,7 +29,7 @@ namespace openshot
 	// Constructor
 	VideoCacheThread::VideoCacheThread()
 	: Thread("video-cache"), speed(0), last_speed(1), is_playing(false),
-	reader(NULL), current_display_frame(1), cached_frame_count(0),
+	reader(NULL), requested_display_frame(1), current_display_frame(1), cached_frame_count(0),
 	min_frames_ahead(4), max_frames_ahead(8), should_pause_cache(false),
 	timeline_max_frame(0), should_break(false)
     {
@@ -37,12 +38,22 @@ namespace openshot
     // Destructor
 	VideoCacheThread::~VideoCacheThread()
     {
+        stopWorkers();
     }
 
 	// Seek the reader to a particular frame number
 	void VideoCacheThread::Seek(int64_t new_position)
 	{
+        // Drop the scheduled frames when jumping backwards, or past the cached range
+        int64_t distance = (new_position - requested_display_frame) * (last_speed < 0 ? -1 : 1);
+        if (distance < 0 || distance > max_frames_ahead) {
+            cancelRequests();
+        }
+
         requested_display_frame = new_position;
+
+        // Wake up the cache thread (to schedule frames from the new position)
+        notify();
 	}
 
     // Seek the reader to a particular frame number and optionally start the pre-roll
@@ -71,6 +82,9 @@ namespace openshot
         // Clear cache if previous frame outside the cached range, which means we are
         // requesting a non-contigous frame compared to our current cache range
         if (new_position >= 1 && new_position <= timeline_max_frame && !reader->GetCache()->Contains(previous_frame)) {
+            // Drop the frames scheduled around the old position
+            cancelRequests();
+
             // Clear cache
             t->ClearAllCache();
 
@@ -99,11 +113,100 @@ namespace openshot
 
     // Set Speed (The speed and direction to playback a reader (1=normal, 2=fast, 3=faster, -1=rewind, etc...)
     void VideoCacheThread::setSpeed(int new_speed) {
+        if (new_speed != speed) {
+            // The scheduled frames are in the wrong order (or direction) for the new speed
+            cancelRequests();
+        }
         if (new_speed != 0) {
             // Track last non-zero speed
             last_speed = new_speed;
         }
         speed = new_speed;
+        notify();
+    }
+
+    // Start the worker threads
+    void VideoCacheThread::startWorkers()
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex);
+        if (!workers.empty())
+            return;
+
+        workers_stopping = false;
+        int thread_count = std::max(Settings::Instance()->VIDEO_CACHE_THREADS, 1);
+        for (int i = 0; i < thread_count; i++)
+            workers.emplace_back(&VideoCacheThread::runWorker, this);
+    }
+
+    // Stop the worker threads (after their current frame)
+    void VideoCacheThread::stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(requests_mutex);
+            workers_stopping = true;
+            requests.clear();
+        }
+        requests_condition.notify_all();
+
+        for (auto& worker : workers)
+            worker.join();
+        workers.clear();
+    }
+
+    // Drop the requests that no worker has started yet
+    void VideoCacheThread::cancelRequests()
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex);
+        requests.clear();
+    }
+
+    // Worker thread (requests the next scheduled frame, until stopped)
+    void VideoCacheThread::runWorker()
+    {
+        using micro_sec = std::chrono::microseconds;
+        using double_micro_sec = std::chrono::duration<double, micro_sec::period>;
+
+        std::unique_lock<std::mutex> lock(requests_mutex);
+        while (true) {
+            requests_condition.wait(lock, [this] { return workers_stopping || !requests.empty(); });
+            if (workers_stopping)
+                break;
+
+            // Take the frame nearest to the playhead
+            int64_t cache_frame = requests.front();
+            requests.pop_front();
+            pending_frames.insert(cache_frame);
+            lock.unlock();
+
+            std::shared_ptr<Frame> frame;
+            double_micro_sec elapsed(0.0);
+            if (reader && reader->GetCache() && !reader->GetCache()->Contains(cache_frame)) {
+                const auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    // This frame is not already cached... so request it again (to force the creation & caching)
+                    // This will also re-order the missing frame to the front of the cache
+                    frame = reader->GetFrame(cache_frame);
+                }
+                catch (const OutOfBoundsFrame & e) {  }
+                elapsed = std::chrono::steady_clock::now() - start;
+            }
+
+            lock.lock();
+            pending_frames.erase(cache_frame);
+            if (frame) {
+                last_cached_frame = frame;
+
+                // Average render time (weighted towards the latest frames)
+                if (render_time == 0.0)
+                    render_time = elapsed.count();
+                else
+                    render_time = render_time * 0.8 + elapsed.count() * 0.2;
+            }
+
+            // Let the cache thread schedule more frames
+            notify();
+        }
     }
 
     // Get the size in bytes of a frame (rough estimate)
@@ -143,6 +246,9 @@ namespace openshot
         using micro_sec = std::chrono::microseconds;
         using double_micro_sec = std::chrono::duration<double, micro_sec::period>;
 
+        // Start the threads which request the scheduled frames
+        startWorkers();
+
         while (!threadShouldExit() && is_playing) {
             // Get settings
             Settings *s = Settings::Instance();
@@ -153,8 +259,9 @@ namespace openshot
 
             // Calculate on-screen time for a single frame
             const auto frame_duration = double_micro_sec(1000000.0 / reader->info.fps.ToDouble());
+            const int sleep_ms = std::max(int(frame_duration.count() / 2000.0), 1);
             int current_speed = speed;
-            
+
             // Increment and direction for cache loop
             int64_t increment = 1;
 
@@ -171,7 +278,10 @@ namespace openshot
             if (current_speed == 0 && should_pause_cache || !s->ENABLE_PLAYBACK_CACHING) {
                 // Sleep during pause (after caching additional frames when paused)
                 // OR sleep when playback caching is disabled
-                std::this_thread::sleep_for(frame_duration / 2);
+                if (!s->ENABLE_PLAYBACK_CACHING) {
+                    cancelRequests();
+                }
+                wait(sleep_ms);
                 continue;
 
             } else if (current_speed == 0) {
@@ -213,14 +323,29 @@ namespace openshot
             } else {
                 // normal playback
                 should_pause_cache = false;
+                if (current_speed < 0) {
+                    increment = -1;
+                }
+
+                // Cache further ahead when frames take longer to render than to play (so the
+                // workers have a head start on the slow parts of the timeline)
+                double render_ratio = 0.0;
+                {
+                    std::lock_guard<std::mutex> lock(requests_mutex);
+                    render_ratio = render_time * abs(current_speed) / (frame_duration.count() * workers.size());
+                }
+                if (render_ratio > 1.0) {
+                    max_frames_ahead = std::max(max_frames_ahead, int64_t(ceil(min_frames_ahead * render_ratio)));
+                    max_frames_ahead = std::min(max_frames_ahead, int64_t(s->VIDEO_CACHE_MAX_FRAMES));
+                }
             }
 
             // Always cache frames from the current display position to our maximum (based on the cache size).
             // Frames which are already cached are basically free. Only uncached frames have a big CPU cost.
             // By always looping through the expected frame range, we can fill-in missing frames caused by a
-            // fragmented cache object (i.e. the user clicking all over the timeline). The -1 is to always
+            // fragmented cache object (i.e. the user clicking all over the timeline). The -increment is to always
             // cache 1 frame previous to our current frame (to avoid our Seek method from clearing the cache).
-            int64_t starting_frame = std::min(current_display_frame, timeline_max_frame) - 1;
+            int64_t starting_frame = std::min(current_display_frame, timeline_max_frame) - increment;
             int64_t ending_frame = std::min(starting_frame + max_frames_ahead, timeline_max_frame);
 
             // Adjust ending frame for cache loop
@@ -240,31 +365,41 @@ namespace openshot
             // Reset cache break-loop flag
             should_break = false;
 
-            // Loop through range of frames (and cache them)
+            // Schedule the missing frames of the range, nearest to the playhead first. Frames
+            // scheduled earlier (but not started yet) are replaced by this list.
+            std::deque<int64_t> missing_frames;
+            int64_t contiguous_frames = 0;
             for (int64_t cache_frame = starting_frame; cache_frame != (ending_frame + increment); cache_frame += increment) {
-                cached_frame_count++;
                 if (reader && reader->GetCache() && !reader->GetCache()->Contains(cache_frame)) {
-                    try
-                    {
-                        // This frame is not already cached... so request it again (to force the creation & caching)
-                        // This will also re-order the missing frame to the front of the cache
-                        last_cached_frame = reader->GetFrame(cache_frame);
-                    }
-                    catch (const OutOfBoundsFrame & e) {  }
+                    missing_frames.push_back(cache_frame);
+                } else if (missing_frames.empty()) {
+                    contiguous_frames++;
                 }
-
-                // Check if thread has stopped OR should_break is triggered
-                if (!is_playing || should_break || !s->ENABLE_PLAYBACK_CACHING) {
-                    should_break = false;
-                    break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(requests_mutex);
+                requests.clear();
+                for (int64_t cache_frame : missing_frames) {
+                    if (pending_frames.count(cache_frame) == 0)
+                        requests.push_back(cache_frame);
                 }
+            }
+            requests_condition.notify_all();
 
+            // Track the frames cached in front of the playhead (for the pre-roll). A fully
+            // cached range (i.e. near the end of the timeline) is always ready.
+            if (missing_frames.empty()) {
+                contiguous_frames = std::max(contiguous_frames, min_frames_ahead + 1);
             }
+            cached_frame_count = std::max(cached_frame_count, contiguous_frames);
 
-			// Sleep for a fraction of frame duration
-			std::this_thread::sleep_for(frame_duration / 2);
+            // Sleep for a fraction of frame duration (or until a frame is cached, or the playhead moves)
+            wait(sleep_ms);
 		}
 
+        // Stop the worker threads (after their current frame)
+        stopWorkers();
+
 	return;
     }
 }
@@ -15,6 +15,13 @@
 
 #include "ReaderBase.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
 #include <AppConfig.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 
@@ -25,6 +32,11 @@ namespace openshot
 
     /**
      *  @brief The video cache class.
+     *
+     *  The cache thread schedules the frames to cache (nearest to the playhead first, in the
+     *  playback direction), and a pool of worker threads requests them from the reader. Pending
+     *  requests are dropped when seeking or changing speed, and the number of frames cached ahead
+     *  grows with the time it takes to render a frame.
      */
     class VideoCacheThread : Thread
     {
@@ -43,6 +55,26 @@ namespace openshot
 	bool should_pause_cache;
 	bool should_break;
 
+	std::vector<std::thread> workers; ///< Threads requesting frames from the reader
+	std::deque<int64_t> requests; ///< Frames waiting for a worker (nearest to the playhead first)
+	std::set<int64_t> pending_frames; ///< Frames being requested by a worker
+	std::mutex requests_mutex;
+	std::condition_variable requests_condition;
+	bool workers_stopping = false;
+	double render_time = 0.0; ///< Average time (in microseconds) to get an uncached frame
+
+	/// Start the worker threads
+	void startWorkers();
+
+	/// Stop the worker threads (after their current frame)
+	void stopWorkers();
+
+	/// Worker thread (requests the next scheduled frame, until stopped)
+	void runWorker();
+
+	/// Drop the requests that no worker has started yet
+	void cancelRequests();
+
 	/// Constructor
 	VideoCacheThread();
 	/// Destructor
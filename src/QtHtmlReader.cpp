@@ -216,7 +216,7 @@ void QtHtmlReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void QtHtmlReader::SetJsonValue(const Json::Value root) {
+void QtHtmlReader::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
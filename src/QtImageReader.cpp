@@ -15,6 +15,7 @@
 #include "Clip.h"
 #include "CacheMemory.h"
 #include "Exceptions.h"
+#include "ImageCache.h"
 #include "Timeline.h"
 
 #include <QString>
@@ -63,14 +64,23 @@ void QtImageReader::Open()
         }
 
         if (!loaded) {
-            // Attempt to open file using Qt's build in image processing capabilities
-            // AutoTransform enables exif data to be parsed and auto transform the image
-            // to the correct orientation
-            image = std::make_shared<QImage>();
-            QImageReader imgReader( path );
-            imgReader.setAutoTransform( true );
-            imgReader.setDecideFormatFromContent( true );
-            loaded = imgReader.read(image.get());
+            // Share the decoded image of other readers of the same file (if any)
+            std::string key = ImageCache::Key("QtImageReader", path.toStdString());
+            image = ImageCache::Instance()->Get(key);
+            loaded = (image != nullptr);
+
+            if (!loaded) {
+                // Attempt to open file using Qt's build in image processing capabilities
+                // AutoTransform enables exif data to be parsed and auto transform the image
+                // to the correct orientation
+                auto decoded_image = std::make_shared<QImage>();
+                QImageReader imgReader( path );
+                imgReader.setAutoTransform( true );
+                imgReader.setDecideFormatFromContent( true );
+                loaded = imgReader.read(decoded_image.get());
+                if (loaded)
+                    image = ImageCache::Instance()->Add(key, decoded_image);
+            }
         }
 
         if (!loaded) {
@@ -159,16 +169,29 @@ std::shared_ptr<Frame> QtImageReader::GetFrame(int64_t requested_frame)
 
     // Scale image smaller (or use a previous scaled image)
     if (!cached_image || max_size != current_max_size) {
-        // Check for SVG files and rasterize them to QImages
-        if (path.toLower().endsWith(".svg") || path.toLower().endsWith(".svgz")) {
+        // Check for SVG files and rasterize them to QImages (at this size, so they aren't shared)
+        bool is_svg = path.toLower().endsWith(".svg") || path.toLower().endsWith(".svgz");
+        if (is_svg) {
             load_svg_path(path);
         }
 
-        // We need to resize the original image to a smaller image (for performance reasons)
-        // Only do this once, to prevent tons of unneeded scaling operations
-        cached_image = std::make_shared<QImage>(image->scaled(
-                       current_max_size,
-                       Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        // Share the scaled image of other readers of the same file (if any)
+        std::string key = ImageCache::Key("QtImageReader", path.toStdString(), current_max_size);
+        cached_image.reset();
+        if (!is_svg)
+            cached_image = ImageCache::Instance()->Get(key);
+
+        if (!cached_image) {
+            // We need to resize the original image to a smaller image (for performance reasons)
+            // Only do this once, to prevent tons of unneeded scaling operations
+            // (in the format of frames, so frames sharing it never convert it)
+            cached_image = std::make_shared<QImage>(image->scaled(
+                           current_max_size,
+                           Qt::KeepAspectRatio, Qt::SmoothTransformation).convertToFormat(
+                           QImage::Format_RGBA8888_Premultiplied));
+            if (!is_svg)
+                cached_image = ImageCache::Instance()->Add(key, cached_image);
+        }
 
         // Set max size (to later determine if max_size is changed)
         max_size = current_max_size;
@@ -353,7 +376,7 @@ void QtImageReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void QtImageReader::SetJsonValue(const Json::Value root) {
+void QtImageReader::SetJsonValue(const Json::Value& root) {
 
     // Set parent data
     ReaderBase::SetJsonValue(root);
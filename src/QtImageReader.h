@@ -75,8 +75,8 @@ namespace openshot
 	{
 	private:
 		QString path;
-		std::shared_ptr<QImage> image;			///> Original image (full quality)
-		std::shared_ptr<QImage> cached_image;	///> Scaled for performance
+		std::shared_ptr<QImage> image;			///> Original image (full quality, shared by the ImageCache)
+		std::shared_ptr<QImage> cached_image;	///> Scaled for performance (shared by the ImageCache)
 		bool is_open;	///> Is Reader opened
 		QSize max_size;	///> Current max_size as calculated with Clip properties
 
@@ -129,7 +129,7 @@ namespace openshot
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Open File - which is called by the constructor automatically
 		void Open() override;
@@ -235,7 +235,7 @@ void QtTextReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void QtTextReader::SetJsonValue(const Json::Value root) {
+void QtTextReader::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
@@ -159,7 +159,7 @@ Json::Value ReaderBase::JsonValue() const {
 }
 
 // Load Json::Value into this object
-void ReaderBase::SetJsonValue(const Json::Value root) {
+void ReaderBase::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["has_video"].isNull())
@@ -0,0 +1,225 @@
+/**
+ * @file
+ * @brief Source file for RenderCache class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "RenderCache.h"
+
+#include "Frame.h"
+#include "Settings.h"
+#include "ZmqLogger.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <vector>
+
+using namespace openshot;
+
+// Frame files start with these values
+static const quint32 RENDER_CACHE_MAGIC = 0x4f535243; // "OSRC"
+static const quint32 RENDER_CACHE_VERSION = 2;
+
+// Get the instance of the cache
+RenderCache* RenderCache::Instance()
+{
+	static RenderCache instance;
+	return &instance;
+}
+
+// Is the cache enabled
+bool RenderCache::Enabled()
+{
+	return !Settings::Instance()->RENDER_CACHE_PATH.empty();
+}
+
+// Get the key of a state
+std::string RenderCache::Key(const Json::Value& state)
+{
+	QByteArray hash = QCryptographicHash::hash(QByteArray::fromStdString(state.toStyledString()), QCryptographicHash::Md5).toHex();
+	return hash.toStdString();
+}
+
+// Path of the file of a key
+std::string RenderCache::frame_path(const std::string& key)
+{
+	QString path = QString::fromStdString(Settings::Instance()->RENDER_CACHE_PATH);
+	if (path.isEmpty())
+		return "";
+	return QDir(path).filePath(QString::fromStdString(key) + ".frame").toStdString();
+}
+
+// Add a rendered frame to the cache
+void RenderCache::Add(const std::string& key, std::shared_ptr<Frame> frame)
+{
+	QString path = QString::fromStdString(frame_path(key));
+	if (path.isEmpty() || !frame)
+		return;
+
+	// Another timeline (or process) may have saved the same frame already
+	QFileInfo existing(path);
+	if (existing.exists())
+		return;
+
+	QDir().mkpath(existing.absolutePath());
+	QSaveFile frame_file(path);
+	if (!frame_file.open(QIODevice::WriteOnly))
+		return;
+
+	QDataStream out(&frame_file);
+	out << RENDER_CACHE_MAGIC << RENDER_CACHE_VERSION;
+
+	// Images and audio samples are saved raw (frames are only shared on one machine, and
+	// encoding images would slow down every frame which isn't cached)
+	std::shared_ptr<QImage> image = frame->GetImage();
+	out << qint32(image->format()) << qint32(image->width()) << qint32(image->height()) << qint32(image->bytesPerLine());
+	out.writeRawData(reinterpret_cast<const char*>(image->constBits()), image->bytesPerLine() * image->height());
+
+	int channels = frame->GetAudioChannelsCount();
+	int samples = frame->GetAudioSamplesCount();
+	out << qint32(frame->SampleRate()) << qint32(channels) << qint32(samples) << qint32(frame->ChannelsLayout());
+	for (int channel = 0; channel < channels; channel++)
+		out.writeRawData(reinterpret_cast<const char*>(frame->GetAudioSamples(channel)), samples * sizeof(float));
+
+	if (out.status() != QDataStream::Ok || !frame_file.commit())
+		return;
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("RenderCache::Add", "frame->number", frame->number);
+
+	// Delete the least recently used frames (if the cache is over budget)
+	const std::lock_guard<std::mutex> lock(mutex);
+	if (total_bytes >= 0)
+		total_bytes += QFileInfo(path).size();
+	clean_up(false);
+}
+
+// Get a frame from the cache
+std::shared_ptr<Frame> RenderCache::GetFrame(const std::string& key)
+{
+	QString path = QString::fromStdString(frame_path(key));
+	if (path.isEmpty())
+		return std::shared_ptr<Frame>();
+
+	QFile frame_file(path);
+	if (!frame_file.open(QIODevice::ReadOnly))
+		return std::shared_ptr<Frame>();
+
+	QDataStream in(&frame_file);
+	quint32 magic = 0, version = 0;
+	in >> magic >> version;
+	if (in.status() != QDataStream::Ok || magic != RENDER_CACHE_MAGIC || version != RENDER_CACHE_VERSION)
+		return std::shared_ptr<Frame>();
+
+	qint32 format = 0, width = 0, height = 0, bytes_per_line = 0;
+	in >> format >> width >> height >> bytes_per_line;
+	if (in.status() != QDataStream::Ok || format <= QImage::Format_Invalid || format >= QImage::NImageFormats ||
+		width <= 0 || height <= 0 || bytes_per_line <= 0 || (qint64) bytes_per_line * height > frame_file.bytesAvailable())
+		return std::shared_ptr<Frame>();
+
+	// Read the rows of the image (the saved row size may differ from the new image's)
+	QImage image(width, height, (QImage::Format) format);
+	if (image.isNull() || bytes_per_line < image.bytesPerLine())
+		return std::shared_ptr<Frame>();
+	std::vector<char> row(bytes_per_line);
+	for (int y = 0; y < height; y++) {
+		in.readRawData(row.data(), bytes_per_line);
+		std::copy(row.begin(), row.begin() + image.bytesPerLine(), reinterpret_cast<char*>(image.scanLine(y)));
+	}
+
+	qint32 sample_rate = 0, channels = 0, samples = 0, channel_layout = 0;
+	in >> sample_rate >> channels >> samples >> channel_layout;
+	if (in.status() != QDataStream::Ok || channels < 0 || samples < 0 ||
+		(qint64) channels * samples * sizeof(float) > frame_file.bytesAvailable())
+		return std::shared_ptr<Frame>();
+
+	// Create frame object
+	auto frame = std::make_shared<Frame>();
+	if (image.format() != QImage::Format_RGBA8888_Premultiplied)
+		image = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+	frame->AddImage(std::make_shared<QImage>(image));
+	if (channels > 0) {
+		frame->ResizeAudio(channels, samples, sample_rate, (ChannelLayout) channel_layout);
+		std::vector<float> channel_samples(samples);
+		for (int channel = 0; channel < channels; channel++) {
+			in.readRawData(reinterpret_cast<char*>(channel_samples.data()), samples * sizeof(float));
+			frame->AddAudio(true, channel, 0, channel_samples.data(), samples, 1.0);
+		}
+	}
+	if (in.status() != QDataStream::Ok)
+		return std::shared_ptr<Frame>();
+
+	// Mark the frame as recently used (so it's deleted last)
+	frame_file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+	return frame;
+}
+
+// Count the size of the folder again (if it changed), and delete the least recently used frames over the budget
+void RenderCache::clean_up(bool force)
+{
+	std::string path = Settings::Instance()->RENDER_CACHE_PATH;
+	int64_t max_bytes = Settings::Instance()->RENDER_CACHE_MAX_BYTES;
+	if (path != folder) {
+		folder = path;
+		total_bytes = -1;
+	}
+	if (!force && total_bytes >= 0 && (max_bytes <= 0 || total_bytes <= max_bytes))
+		return;
+
+	// Frames of the folder (most recently used first)
+	QDir dir(QString::fromStdString(folder));
+	QFileInfoList files = dir.entryInfoList(QStringList() << "*.frame", QDir::Files, QDir::Time);
+	total_bytes = 0;
+	for (const QFileInfo& file : files)
+		total_bytes += file.size();
+
+	// Delete the least recently used frames (leaving some room, so the folder isn't counted on every frame)
+	int removed = 0;
+	while (max_bytes > 0 && total_bytes > max_bytes * 0.9 && !files.isEmpty()) {
+		QFileInfo file = files.takeLast();
+		if (QFile::remove(file.absoluteFilePath())) {
+			total_bytes -= file.size();
+			removed++;
+		}
+	}
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("RenderCache::clean_up", "total_bytes", total_bytes, "removed", removed);
+}
+
+// Delete every frame in the cache
+void RenderCache::Clear()
+{
+	const std::lock_guard<std::mutex> lock(mutex);
+	QString path = QString::fromStdString(Settings::Instance()->RENDER_CACHE_PATH);
+	if (path.isEmpty())
+		return;
+
+	QDir dir(path);
+	for (const QString& name : dir.entryList(QStringList() << "*.frame", QDir::Files))
+		dir.remove(name);
+	clean_up(true);
+}
+
+// Number of frames in the cache
+int64_t RenderCache::Count()
+{
+	QString path = QString::fromStdString(Settings::Instance()->RENDER_CACHE_PATH);
+	if (path.isEmpty())
+		return 0;
+	return QDir(path).entryList(QStringList() << "*.frame", QDir::Files).size();
+}
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Header file for RenderCache class
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef OPENSHOT_RENDER_CACHE_H
+#define OPENSHOT_RENDER_CACHE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Json.h"
+
+namespace openshot
+{
+	class Frame;
+
+	/**
+	 * @brief A folder of rendered timeline frames, shared by every timeline (and process) on a machine.
+	 *
+	 * Frames are saved by a key: a hash of everything the frame was rendered from (the settings of the
+	 * timeline, and the properties of the clips and effects at that frame, including the size and
+	 * modification time of their files). A frame rendered again from the same state (after it's dropped
+	 * from the timeline's cache, or in a later session) is loaded instead of rendered.
+	 *
+	 * The cache is enabled by setting Settings::RENDER_CACHE_PATH, and the least recently used frames
+	 * are deleted once the folder is bigger than Settings::RENDER_CACHE_MAX_BYTES.
+	 */
+	class RenderCache {
+	private:
+		std::mutex mutex;
+		std::string folder; ///< Folder the total size was counted for
+		int64_t total_bytes; ///< Size of the frames in the folder (approximate, since other processes use it too)
+
+		RenderCache() : total_bytes(-1) {};
+
+		/// Path of the file of a key (or an empty string, if the cache is disabled)
+		std::string frame_path(const std::string& key);
+
+		/// Count the size of the folder again (if it changed), and delete the least recently used frames over the budget
+		void clean_up(bool force);
+
+	public:
+		/// Get the instance of the cache
+		static RenderCache* Instance();
+
+		/// Is the cache enabled (i.e. is Settings::RENDER_CACHE_PATH set)
+		bool Enabled();
+
+		/// Get the key of a state (a hash of its JSON)
+		static std::string Key(const Json::Value& state);
+
+		/// Add a rendered frame to the cache
+		void Add(const std::string& key, std::shared_ptr<openshot::Frame> frame);
+
+		/// Get a frame from the cache (or a null pointer, if it isn't cached)
+		std::shared_ptr<openshot::Frame> GetFrame(const std::string& key);
+
+		/// Delete every frame in the cache
+		void Clear();
+
+		/// Number of frames in the cache
+		int64_t Count();
+	};
+
+}
+
+#endif
@@ -38,6 +38,16 @@ Settings *Settings::Instance()
 		m_pInstance->VIDEO_CACHE_MAX_PREROLL_FRAMES = 48;
 		m_pInstance->VIDEO_CACHE_MAX_FRAMES = 30 * 10;
 		m_pInstance->ENABLE_PLAYBACK_CACHING = true;
+		m_pInstance->VIDEO_CACHE_THREADS = 2;
+		m_pInstance->SCRUB_PREVIEW_SCALE = 0.5;
+		m_pInstance->CLIP_PREWARM_SECONDS = 2.0;
+		m_pInstance->CLIP_CLOSE_DELAY = 3.0;
+		m_pInstance->MAX_OPEN_CLIPS = 32;
+		m_pInstance->SHARE_MEDIA_SOURCES = true;
+		m_pInstance->RENDER_CACHE_PATH = "";
+		m_pInstance->RENDER_CACHE_MAX_BYTES = 2LL * 1024 * 1024 * 1024;
+		m_pInstance->IMAGE_CACHE_MAX_BYTES = 512LL * 1024 * 1024;
+		m_pInstance->LAZY_LOAD_CLIPS = false;
 		m_pInstance->PLAYBACK_AUDIO_DEVICE_NAME = "";
 		m_pInstance->PLAYBACK_AUDIO_DEVICE_TYPE = "";
 		m_pInstance->DEBUG_TO_STDERR = false;
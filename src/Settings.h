@@ -13,6 +13,7 @@
 #ifndef OPENSHOT_SETTINGS_H
 #define OPENSHOT_SETTINGS_H
 
+#include <cstdint>
 #include <string>
 
 namespace openshot {
@@ -97,6 +98,59 @@ namespace openshot {
 		/// Enable/Disable the cache thread to pre-fetch and cache video frames before we need them
 		bool ENABLE_PLAYBACK_CACHING = true;
 
+		/// Number of threads the cache thread uses to request frames concurrently (frames nearest the
+		/// playhead are requested first)
+		int VIDEO_CACHE_THREADS = 2;
+
+		/// Scale of the preview size used to render uncached frames while scrubbing a paused player (the
+		/// frame is rendered again at the full preview size once the playhead rests). 1.0 disables it.
+		float SCRUB_PREVIEW_SCALE = 0.5;
+
+		/// Index the keyframes of video files when FFmpegReader opens them, so seeking jumps straight to the
+		/// keyframe before the requested frame (instead of re-opening the file, or seeking more than once)
+		bool ENABLE_KEYFRAME_INDEX = false;
+
+		/// Folder to save keyframe indexes in, so they are only built the first time a file is opened (an
+		/// empty path keeps indexes in memory only)
+		std::string PATH_KEYFRAME_INDEX = "";
+
+		/// Number of frames each FFmpegReader decodes ahead of the requested frames (in the direction they
+		/// are requested), on its own thread, so decoding overlaps with rendering (0 disables read-ahead)
+		int READ_AHEAD_FRAMES = 0;
+
+		/// Timelines open clips in the background when they start within this many seconds after the requested
+		/// frame, so playback doesn't stall at cuts (0 only opens clips when they're needed)
+		float CLIP_PREWARM_SECONDS = 2.0;
+
+		/// Timelines close clips (in the background) once they haven't been needed for this many seconds, so
+		/// random access doesn't keep re-opening the same files
+		float CLIP_CLOSE_DELAY = 3.0;
+
+		/// Max number of clips each timeline keeps open (the least recently needed clips are closed first, and
+		/// clips needed for the requested frame are always opened). 0 for no limit.
+		int MAX_OPEN_CLIPS = 32;
+
+		/// Share one decoder (and decoded frame cache) between the clips of the same video or audio file
+		/// (clips which show different parts of a file at the same time will seek back and forth)
+		bool SHARE_MEDIA_SOURCES = true;
+
+		/// Folder to save rendered timeline frames in, shared by every timeline and process, so frames which
+		/// are rendered again from the same clips, effects and files are loaded instead (an empty path disables it)
+		std::string RENDER_CACHE_PATH = "";
+
+		/// Max size (in bytes) of the render cache folder (the least recently used frames are deleted first).
+		/// 0 for no limit.
+		int64_t RENDER_CACHE_MAX_BYTES = 2LL * 1024 * 1024 * 1024;
+
+		/// Max size (in bytes) of the still images kept decoded after no reader uses them (images in use
+		/// are always shared by the readers of the same file). 0 to release images once they're unused.
+		int64_t IMAGE_CACHE_MAX_BYTES = 512LL * 1024 * 1024;
+
+		/// Timelines only load the timing of clips from project JSON, and load the rest of each clip (readers,
+		/// effects and keyframes) when a frame first needs it, so large projects open quickly. Clips() lists
+		/// clips which may not be loaded yet (use GetClip() to load one).
+		bool LAZY_LOAD_CLIPS = false;
+
 		/// The audio device name to use during playback
 		std::string PLAYBACK_AUDIO_DEVICE_NAME = "";
 
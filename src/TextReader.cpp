@@ -222,7 +222,7 @@ void TextReader::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void TextReader::SetJsonValue(const Json::Value root) {
+void TextReader::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	ReaderBase::SetJsonValue(root);
@@ -18,16 +18,23 @@
 #include "CrashHandler.h"
 #include "FrameMapper.h"
 #include "Exceptions.h"
+#include "OpenShotVersion.h"
+#include "ProjectSnapshot.h"
+#include "RenderCache.h"
 
 #include <QDir>
 #include <QFileInfo>
 
+#include <cmath>
+#include <limits>
+
 using namespace openshot;
 
 // Default Constructor for the timeline (which sets the canvas width and height)
 Timeline::Timeline(int width, int height, Fraction fps, int sample_rate, int channels, ChannelLayout channel_layout) :
-		is_open(false), auto_map_clips(true), managed_cache(true), path(""),
-		max_concurrent_frames(OPEN_MP_NUM_PROCESSORS), max_time(0.0)
+		is_open(false), auto_map_clips(true), share_media_sources(true), managed_cache(true), path(""),
+		max_concurrent_frames(OPEN_MP_NUM_PROCESSORS), max_time(0.0),
+		running_clip_job(NULL), clip_jobs_stopping(false)
 {
 	// Create CrashHandler and Attach (incase of errors)
 	CrashHandler::Instance();
@@ -77,8 +84,9 @@ Timeline::Timeline(const ReaderInfo info) : Timeline::Timeline(
 
 // Constructor for the timeline (which loads a JSON structure from a file path, and initializes a timeline)
 Timeline::Timeline(const std::string& projectPath, bool convert_absolute_paths) :
-		is_open(false), auto_map_clips(true), managed_cache(true), path(projectPath),
-		max_concurrent_frames(OPEN_MP_NUM_PROCESSORS), max_time(0.0) {
+		is_open(false), auto_map_clips(true), share_media_sources(true), managed_cache(true), path(projectPath),
+		max_concurrent_frames(OPEN_MP_NUM_PROCESSORS), max_time(0.0),
+		running_clip_job(NULL), clip_jobs_stopping(false) {
 
 	// Create CrashHandler and Attach (incase of errors)
 	CrashHandler::Instance();
@@ -179,6 +187,15 @@ Timeline::Timeline(const std::string& projectPath, bool convert_absolute_paths)
 		float clip_last_frame = clip->Position() + clip->Duration();
 		if (clip_last_frame > calculated_duration)
 			calculated_duration = clip_last_frame;
+		if (pending_clips.count(clip)) {
+			// Clips which aren't loaded yet have the info of their reader in their JSON
+			const Json::Value& reader_root = pending_clips[clip]["reader"];
+			if (reader_root["has_audio"].asBool())
+				info.has_audio = true;
+			if (reader_root["has_video"].asBool())
+				info.has_video = true;
+			continue;
+		}
 		if (clip->Reader() && clip->Reader()->info.has_audio)
 			info.has_audio = true;
 		if (clip->Reader() && clip->Reader()->info.has_video)
@@ -212,6 +229,9 @@ Timeline::~Timeline() {
 	// Remove all clips, effects, and frame mappers
 	Clear();
 
+	// Stop opening and closing clips in the background
+	stop_clip_jobs();
+
 	// Destroy previous cache (if managed by timeline)
 	if (managed_cache && final_cache) {
 		delete final_cache;
@@ -238,7 +258,12 @@ void Timeline::AddTrackedObject(std::shared_ptr<openshot::TrackedObjectBase> tra
 }
 
 // Return tracked object pointer by it's id
-std::shared_ptr<openshot::TrackedObjectBase> Timeline::GetTrackedObject(std::string id) const{
+std::shared_ptr<openshot::TrackedObjectBase> Timeline::GetTrackedObject(std::string id) {
+
+	// Load the clips with effects tracking this object (if they aren't loaded yet)
+	load_clips_with_effects([&id](const Json::Value& effect) {
+		return effect["objects"].isObject() && effect["objects"].isMember(id);
+	});
 
 	// Search for the tracked object on the map
 	auto iterator = tracked_objects.find(id);
@@ -255,7 +280,12 @@ std::shared_ptr<openshot::TrackedObjectBase> Timeline::GetTrackedObject(std::str
 }
 
 // Return the ID's of the tracked objects as a list of strings
-std::list<std::string> Timeline::GetTrackedObjectsIds() const{
+std::list<std::string> Timeline::GetTrackedObjectsIds() {
+
+	// Load the clips with effects tracking objects (if they aren't loaded yet)
+	load_clips_with_effects([](const Json::Value& effect) {
+		return effect["objects"].isObject();
+	});
 
 	// Create a list of strings
 	std::list<std::string> trackedObjects_ids;
@@ -271,18 +301,18 @@ std::list<std::string> Timeline::GetTrackedObjectsIds() const{
 
 #ifdef USE_OPENCV
 // Return the trackedObject's properties as a JSON string
-std::string Timeline::GetTrackedObjectValues(std::string id, int64_t frame_number) const {
+std::string Timeline::GetTrackedObjectValues(std::string id, int64_t frame_number) {
 
 	// Initialize the JSON object
 	Json::Value trackedObjectJson;
 
-	// Search for the tracked object on the map
-	auto iterator = tracked_objects.find(id);
+	// Search for the tracked object (loading its clip, if needed)
+	std::shared_ptr<TrackedObjectBase> trackedObjectBase = GetTrackedObject(id);
 
-	if (iterator != tracked_objects.end())
+	if (trackedObjectBase)
 	{
 		// Id found, Get the object pointer and cast it as a TrackedObjectBBox
-		std::shared_ptr<TrackedObjectBBox> trackedObject = std::static_pointer_cast<TrackedObjectBBox>(iterator->second);
+		std::shared_ptr<TrackedObjectBBox> trackedObject = std::static_pointer_cast<TrackedObjectBBox>(trackedObjectBase);
 
 		// Get the trackedObject values for it's first frame
 		if (trackedObject->ExactlyContains(frame_number)){
@@ -390,7 +420,11 @@ void Timeline::RemoveClip(Clip* clip)
 	// Get lock (prevent getting frames while this happens)
 	const std::lock_guard<std::recursive_mutex> guard(getFrameMutex);
 
+	// Close clip (if the timeline opened it)
+	close_clip(clip);
+
 	clips.remove(clip);
+	pending_clips.erase(clip);
 	
 	// Delete clip object (if timeline allocated it)
 	bool allocated = allocated_clips.count(clip);
@@ -410,6 +444,7 @@ openshot::Clip* Timeline::GetClip(const std::string& id)
 	// Find the matching clip (if any)
 	for (const auto& clip : clips) {
 		if (clip->Id() == id) {
+			load_clip(clip);
 			return clip;
 		}
 	}
@@ -432,6 +467,17 @@ openshot::EffectBase* Timeline::GetClipEffect(const std::string& id)
 {
 	// Search all clips for matching effect ID
 	for (const auto& clip : clips) {
+		// Load the clip first (if it isn't loaded yet, and has the effect)
+		auto pending = pending_clips.find(clip);
+		if (pending != pending_clips.end()) {
+			for (const auto& effect : pending->second["effects"]) {
+				if (effect["id"].asString() == id) {
+					load_clip(clip);
+					break;
+				}
+			}
+		}
+
 		const auto e = clip->GetEffect(id);
 		if (e != nullptr) {
 			return e;
@@ -441,7 +487,10 @@ openshot::EffectBase* Timeline::GetClipEffect(const std::string& id)
 }
 
 // Return the list of effects on all clips
-std::list<openshot::EffectBase*> Timeline::ClipEffects() const {
+std::list<openshot::EffectBase*> Timeline::ClipEffects() {
+
+	// Load the clips with effects (if they aren't loaded yet)
+	load_clips_with_effects([](const Json::Value&) { return true; });
 
 	// Initialize the list
 	std::list<EffectBase*> timelineEffectsList;
@@ -475,6 +524,10 @@ int64_t Timeline::GetMaxFrame() {
 // Apply a FrameMapper to a clip which matches the settings of this timeline
 void Timeline::apply_mapper_to_clip(Clip* clip)
 {
+	// Wait for the clip to be opened or closed in the background (if it is)
+	bool open_job = false;
+	bool cancelled = finish_clip_job(clip, open_job);
+
 	// Determine type of reader
 	ReaderBase* clip_reader = NULL;
 	if (clip->Reader()->Name() == "FrameMapper")
@@ -496,6 +549,10 @@ void Timeline::apply_mapper_to_clip(Clip* clip)
 
 	// Update clip reader
 	clip->Reader(clip_reader);
+
+	// Queue the cancelled job again
+	if (cancelled)
+		queue_clip_job(clip, open_job);
 }
 
 // Apply the timeline's framerate and samplerate to all clips
@@ -507,6 +564,10 @@ void Timeline::ApplyMapperToClips()
 	// Loop through all clips
 	for (auto clip : clips)
 	{
+		// Clips which aren't loaded yet are mapped when they're loaded
+		if (pending_clips.count(clip))
+			continue;
+
 		// Apply framemapper (or update existing framemapper)
 		apply_mapper_to_clip(clip);
 	}
@@ -608,12 +669,13 @@ std::shared_ptr<Frame> Timeline::GetOrCreateFrame(std::shared_ptr<Frame> backgro
 }
 
 // Process a new layer of video or audio
-void Timeline::add_layer(std::shared_ptr<Frame> new_frame, Clip* source_clip, int64_t clip_frame_number, bool is_top_clip, float max_volume)
+void Timeline::add_layer(std::shared_ptr<Frame> new_frame, Clip* source_clip, int64_t clip_frame_number, bool is_top_clip, float max_volume, bool is_scrubbing)
 {
 	// Create timeline options (with details about this current frame request)
 	TimelineInfoStruct* options = new TimelineInfoStruct();
 	options->is_top_clip = is_top_clip;
 	options->is_before_clip_keyframes = true;
+	options->is_scrubbing = is_scrubbing;
 
 	// Get the clip's frame, composited on top of the current timeline frame
 	std::shared_ptr<Frame> source_frame;
@@ -710,7 +772,7 @@ void Timeline::add_layer(std::shared_ptr<Frame> new_frame, Clip* source_clip, in
 }
 
 // Update the list of 'opened' clips
-void Timeline::update_open_clips(Clip *clip, bool does_clip_intersect)
+void Timeline::update_open_clips(Clip *clip, bool does_clip_intersect, bool is_upcoming)
 {
 	// Get lock (prevent getting frames while this happens)
 	const std::lock_guard<std::recursive_mutex> guard(getFrameMutex);
@@ -718,31 +780,48 @@ void Timeline::update_open_clips(Clip *clip, bool does_clip_intersect)
 	ZmqLogger::Instance()->AppendDebugMethod(
 		"Timeline::update_open_clips (before)",
 		"does_clip_intersect", does_clip_intersect,
-		"closing_clips.size()", closing_clips.size(),
+		"is_upcoming", is_upcoming,
 		"open_clips.size()", open_clips.size());
 
-	// is clip already in list?
-	bool clip_found = open_clips.count(clip);
+	// The clip is needed now (so it can't be opened or closed in the background)
+	bool open_job = false;
+	bool cancelled = does_clip_intersect && finish_clip_job(clip, open_job);
 
-	if (clip_found && !does_clip_intersect)
-	{
-		// Remove clip from 'opened' list, because it's closed now
-		open_clips.erase(clip);
+	// is clip already in list? (clips which failed to open in the background aren't)
+	forget_failed_clip_opens();
+	auto now = std::chrono::steady_clock::now();
+	auto clip_itr = open_clips.find(clip);
+	bool clip_found = clip_itr != open_clips.end();
 
-		// Close clip
-		clip->Close();
-	}
-	else if (!clip_found && does_clip_intersect)
+	if (does_clip_intersect)
 	{
-		// Add clip to 'opened' list, because it's missing
-		open_clips[clip] = clip;
+		open_clips[clip] = now;
 
-		try {
-			// Open the clip
-			clip->Open();
+		// Open the clip, unless it's already open (or its closing was cancelled)
+		if ((!clip_found && !(cancelled && !open_job)) || (cancelled && open_job)) {
+			try {
+				// Open the clip
+				clip->Open();
 
-		} catch (const InvalidFile & e) {
-			// ...
+			} catch (const InvalidFile & e) {
+				// ...
+			}
+		}
+	}
+	else if (is_upcoming)
+	{
+		// Open the clip in the background, before it's needed
+		if (!clip_found)
+			queue_clip_job(clip, true);
+		open_clips[clip] = now;
+	}
+	else if (clip_found)
+	{
+		// Close the clip in the background (once it hasn't been needed for a while)
+		float close_delay = Settings::Instance()->CLIP_CLOSE_DELAY;
+		if (now - clip_itr->second >= std::chrono::duration<float>(close_delay)) {
+			open_clips.erase(clip_itr);
+			queue_clip_job(clip, false);
 		}
 	}
 
@@ -751,10 +830,161 @@ void Timeline::update_open_clips(Clip *clip, bool does_clip_intersect)
 		"Timeline::update_open_clips (after)",
 		"does_clip_intersect", does_clip_intersect,
 		"clip_found", clip_found,
-		"closing_clips.size()", closing_clips.size(),
 		"open_clips.size()", open_clips.size());
 }
 
+// Close the least recently needed clips, while more clips are open than allowed
+void Timeline::limit_open_clips(const std::set<Clip*>& needed_clips)
+{
+	int max_open_clips = Settings::Instance()->MAX_OPEN_CLIPS;
+	if (max_open_clips <= 0)
+		return;
+
+	while (open_clips.size() > (size_t) max_open_clips) {
+		auto oldest = open_clips.end();
+		for (auto itr = open_clips.begin(); itr != open_clips.end(); ++itr) {
+			if (!needed_clips.count(itr->first) && (oldest == open_clips.end() || itr->second < oldest->second))
+				oldest = itr;
+		}
+		if (oldest == open_clips.end())
+			break;
+
+		Clip* clip = oldest->first;
+		open_clips.erase(oldest);
+		queue_clip_job(clip, false);
+	}
+}
+
+// Close a clip right away (and remove it from the list of 'opened' clips)
+void Timeline::close_clip(Clip *clip)
+{
+	// Get lock (prevent getting frames while this happens)
+	const std::lock_guard<std::recursive_mutex> guard(getFrameMutex);
+
+	bool open_job = false;
+	bool cancelled = finish_clip_job(clip, open_job);
+	forget_failed_clip_opens();
+	bool clip_found = open_clips.erase(clip) > 0;
+
+	// Close clip (if it's open, or still waiting to be closed)
+	if (clip_found || cancelled)
+		clip->Close();
+}
+
+// Open or close a clip in the background
+void Timeline::queue_clip_job(Clip *clip, bool open)
+{
+	{
+		const std::lock_guard<std::mutex> lock(clip_jobs_mutex);
+
+		// Replace the queued job of this clip (if any)
+		for (auto itr = clip_jobs.begin(); itr != clip_jobs.end(); ++itr) {
+			if (itr->clip == clip) {
+				clip_jobs.erase(itr);
+				break;
+			}
+		}
+		clip_jobs.push_back({clip, open});
+
+		// Start thread (if needed)
+		if (!clip_jobs_thread.joinable()) {
+			clip_jobs_stopping = false;
+			clip_jobs_thread = std::thread(&Timeline::run_clip_jobs, this);
+		}
+	}
+	clip_jobs_condition.notify_all();
+}
+
+// Cancel the queued job of a clip, and wait for its running job (if any)
+bool Timeline::finish_clip_job(Clip *clip, bool& open)
+{
+	std::unique_lock<std::mutex> lock(clip_jobs_mutex);
+
+	bool cancelled = false;
+	for (auto itr = clip_jobs.begin(); itr != clip_jobs.end(); ++itr) {
+		if (itr->clip == clip) {
+			open = itr->open;
+			cancelled = true;
+			clip_jobs.erase(itr);
+			break;
+		}
+	}
+
+	clip_jobs_condition.wait(lock, [this, clip] { return running_clip_job != clip; });
+	return cancelled;
+}
+
+// Open and close clips in the background
+void Timeline::run_clip_jobs()
+{
+	while (true) {
+		ClipJob job;
+		{
+			std::unique_lock<std::mutex> lock(clip_jobs_mutex);
+			clip_jobs_condition.wait(lock, [this] { return clip_jobs_stopping || !clip_jobs.empty(); });
+			if (clip_jobs_stopping)
+				break;
+
+			job = clip_jobs.front();
+			clip_jobs.pop_front();
+			running_clip_job = job.clip;
+		}
+
+		// Debug output
+		ZmqLogger::Instance()->AppendDebugMethod(
+			"Timeline::run_clip_jobs",
+			"open", job.open,
+			"clip->Position()", job.clip->Position());
+
+		try {
+			if (job.open)
+				job.clip->Open();
+			else
+				job.clip->Close();
+
+		} catch (const std::exception & e) {
+			// The clip is removed from open_clips, so it's opened again when it's needed
+			if (job.open) {
+				const std::lock_guard<std::mutex> lock(clip_jobs_mutex);
+				failed_clip_opens.insert(job.clip);
+			}
+		}
+
+		{
+			const std::lock_guard<std::mutex> lock(clip_jobs_mutex);
+			running_clip_job = NULL;
+		}
+		clip_jobs_condition.notify_all();
+	}
+}
+
+// Remove the clips which failed to open in the background from open_clips
+void Timeline::forget_failed_clip_opens()
+{
+	std::set<Clip*> failed_clips;
+	{
+		const std::lock_guard<std::mutex> lock(clip_jobs_mutex);
+		failed_clips.swap(failed_clip_opens);
+	}
+	for (Clip* clip : failed_clips)
+		open_clips.erase(clip);
+}
+
+// Stop the background thread (dropping queued jobs)
+void Timeline::stop_clip_jobs()
+{
+	if (!clip_jobs_thread.joinable())
+		return;
+
+	{
+		const std::lock_guard<std::mutex> lock(clip_jobs_mutex);
+		clip_jobs_stopping = true;
+		clip_jobs.clear();
+	}
+	clip_jobs_condition.notify_all();
+	clip_jobs_thread.join();
+}
+
 // Calculate the max duration (in seconds) of the timeline, based on all the clips, and cache the value
 void Timeline::calculate_max_duration() {
 	double last_clip = 0.0;
@@ -815,7 +1045,7 @@ void Timeline::Clear()
 	// Close all open clips
 	for (auto clip : clips)
 	{
-		update_open_clips(clip, false);
+		close_clip(clip);
 
 		// Delete clip object (if timeline allocated it)
 		bool allocated = allocated_clips.count(clip);
@@ -826,6 +1056,7 @@ void Timeline::Clear()
 	// Clear all clips
 	clips.clear();
 	allocated_clips.clear();
+	pending_clips.clear();
 
 	// Close all effects
 	for (auto effect : effects)
@@ -861,8 +1092,7 @@ void Timeline::Close()
 	// Close all open clips
 	for (auto clip : clips)
 	{
-		// Open or Close this clip, based on if it's intersecting or not
-		update_open_clips(clip, false);
+		close_clip(clip);
 	}
 
 	// Mark timeline as closed
@@ -920,130 +1150,310 @@ std::shared_ptr<Frame> Timeline::GetFrame(int64_t requested_frame)
 			// Return cached frame
 			return frame;
 		} else {
-			// Get a list of clips that intersect with the requested section of timeline
-			// This also opens the readers for intersecting clips, and marks non-intersecting clips as 'needs closing'
-			std::vector<Clip *> nearby_clips;
-			nearby_clips = find_intersecting_clips(requested_frame, 1, true);
-
-			// Debug output
-			ZmqLogger::Instance()->AppendDebugMethod(
-					"Timeline::GetFrame (processing frame)",
-					"requested_frame", requested_frame,
-					"omp_get_thread_num()", omp_get_thread_num());
+			// Load the frame from the render cache, if it was rendered before from the same state
+			std::string render_key;
+			bool use_render_cache = RenderCache::Instance()->Enabled() && render_cache_key(requested_frame, render_key);
+			std::shared_ptr<Frame> new_frame;
+			if (use_render_cache)
+				new_frame = RenderCache::Instance()->GetFrame(render_key);
+
+			if (new_frame) {
+				// Debug output
+				ZmqLogger::Instance()->AppendDebugMethod(
+						"Timeline::GetFrame (Render cache frame found)",
+						"requested_frame", requested_frame);
 
-			// Init some basic properties about this frame
-			int samples_in_frame = Frame::GetSamplesPerFrame(requested_frame, info.fps, info.sample_rate, info.channels);
+				new_frame->SetFrameNumber(requested_frame);
+			} else {
+				// Render the frame (at the preview size)
+				new_frame = render_frame(requested_frame, preview_width, preview_height, false);
 
-			// Create blank frame (which will become the requested frame)
-			std::shared_ptr<Frame> new_frame(std::make_shared<Frame>(requested_frame, preview_width, preview_height, "#000000", samples_in_frame, info.channels));
-			new_frame->AddAudioSilence(samples_in_frame);
-			new_frame->SampleRate(info.sample_rate);
-			new_frame->ChannelsLayout(info.channel_layout);
+				// Save the frame for other timelines (and sessions)
+				if (use_render_cache)
+					RenderCache::Instance()->Add(render_key, new_frame);
+			}
 
 			// Debug output
 			ZmqLogger::Instance()->AppendDebugMethod(
-					"Timeline::GetFrame (Adding solid color)",
+					"Timeline::GetFrame (Add frame to cache)",
 					"requested_frame", requested_frame,
 					"info.width", info.width,
 					"info.height", info.height);
 
-			// Add Background Color to 1st layer (if animated or not black)
-			if ((color.red.GetCount() > 1 || color.green.GetCount() > 1 || color.blue.GetCount() > 1) ||
-				(color.red.GetValue(requested_frame) != 0.0 || color.green.GetValue(requested_frame) != 0.0 ||
-				 color.blue.GetValue(requested_frame) != 0.0))
-				new_frame->AddColor(preview_width, preview_height, color.GetColorHex(requested_frame));
+			// Add final frame to cache
+			final_cache->Add(new_frame);
 
-			// Debug output
-			ZmqLogger::Instance()->AppendDebugMethod(
-					"Timeline::GetFrame (Loop through clips)",
-					"requested_frame", requested_frame,
-					"clips.size()", clips.size(),
-					"nearby_clips.size()", nearby_clips.size());
+			// Return frame (or blank frame)
+			return new_frame;
+		}
+	}
+}
+
+// Get a frame quickly while scrubbing (a cached frame, or a reduced-resolution frame)
+std::shared_ptr<Frame> Timeline::GetScrubFrame(int64_t requested_frame)
+{
+	// Adjust out of bounds frame number
+	if (requested_frame < 1)
+		requested_frame = 1;
 
-			// Find Clips near this time
-			for (auto clip : nearby_clips) {
-				long clip_start_position = round(clip->Position() * info.fps.ToDouble()) + 1;
-				long clip_end_position = round((clip->Position() + clip->Duration()) * info.fps.ToDouble());
-				bool does_clip_intersect = (clip_start_position <= requested_frame && clip_end_position >= requested_frame);
+	// Cached frames are already at full quality
+	std::shared_ptr<Frame> frame = final_cache->GetFrame(requested_frame);
+	if (frame)
+		return frame;
 
-				// Debug output
-				ZmqLogger::Instance()->AppendDebugMethod(
-						"Timeline::GetFrame (Does clip intersect)",
-						"requested_frame", requested_frame,
-						"clip->Position()", clip->Position(),
-						"clip->Duration()", clip->Duration(),
-						"does_clip_intersect", does_clip_intersect);
-
-				// Clip is visible
-				if (does_clip_intersect) {
-					// Determine if clip is "top" clip on this layer (only happens when multiple clips are overlapping)
-					bool is_top_clip = true;
-					float max_volume = 0.0;
-					for (auto nearby_clip : nearby_clips) {
-						long nearby_clip_start_position = round(nearby_clip->Position() * info.fps.ToDouble()) + 1;
-						long nearby_clip_end_position = round((nearby_clip->Position() + nearby_clip->Duration()) * info.fps.ToDouble()) + 1;
-						long nearby_clip_start_frame = (nearby_clip->Start() * info.fps.ToDouble()) + 1;
-						long nearby_clip_frame_number = requested_frame - nearby_clip_start_position + nearby_clip_start_frame;
-
-						// Determine if top clip
-						if (clip->Id() != nearby_clip->Id() && clip->Layer() == nearby_clip->Layer() &&
-							nearby_clip_start_position <= requested_frame && nearby_clip_end_position >= requested_frame &&
-							nearby_clip_start_position > clip_start_position && is_top_clip == true) {
-							is_top_clip = false;
-						}
-
-						// Determine max volume of overlapping clips
-						if (nearby_clip->Reader() && nearby_clip->Reader()->info.has_audio &&
-							nearby_clip->has_audio.GetInt(nearby_clip_frame_number) != 0 &&
-							nearby_clip_start_position <= requested_frame && nearby_clip_end_position >= requested_frame) {
-							max_volume += nearby_clip->volume.GetValue(nearby_clip_frame_number);
-						}
-					}
+	// Reduced preview size (keeping the aspect ratio)
+	float scale = std::min(std::max(Settings::Instance()->SCRUB_PREVIEW_SCALE, 0.0f), 1.0f);
+	if (scale >= 1.0)
+		return GetFrame(requested_frame);
+	int width = std::max(int(round(preview_width * scale)), 1);
+	int height = std::max(int(round(preview_height * scale)), 1);
 
-					// Determine the frame needed for this clip (based on the position on the timeline)
-					long clip_start_frame = (clip->Start() * info.fps.ToDouble()) + 1;
-					long clip_frame_number = requested_frame - clip_start_position + clip_start_frame;
-
-					// Debug output
-					ZmqLogger::Instance()->AppendDebugMethod(
-							"Timeline::GetFrame (Calculate clip's frame #)",
-							"clip->Position()", clip->Position(),
-							"clip->Start()", clip->Start(),
-							"info.fps.ToFloat()", info.fps.ToFloat(),
-							"clip_frame_number", clip_frame_number);
-
-					// Add clip's frame as layer
-					add_layer(new_frame, clip, clip_frame_number, is_top_clip, max_volume);
-
-				} else {
-					// Debug output
-					ZmqLogger::Instance()->AppendDebugMethod(
-							"Timeline::GetFrame (clip does not intersect)",
-							"requested_frame", requested_frame,
-							"does_clip_intersect", does_clip_intersect);
+	// Prevent async calls to the following code
+	const std::lock_guard<std::recursive_mutex> lock(getFrameMutex);
+
+	// Check cache 2nd time
+	frame = final_cache->GetFrame(requested_frame);
+	if (frame)
+		return frame;
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod(
+			"Timeline::GetScrubFrame (rendering reduced frame)",
+			"requested_frame", requested_frame,
+			"width", width,
+			"height", height);
+
+	return render_frame(requested_frame, width, height, true);
+}
+
+// Render a frame of the timeline on a canvas of a specific size (without caching it)
+std::shared_ptr<Frame> Timeline::render_frame(int64_t requested_frame, int width, int height, bool is_scrubbing)
+{
+	// Get a list of clips that intersect with the requested section of timeline
+	// This also opens the readers for intersecting clips, and marks non-intersecting clips as 'needs closing'
+	std::vector<Clip *> nearby_clips;
+	nearby_clips = find_intersecting_clips(requested_frame, 1, true);
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod(
+			"Timeline::render_frame (processing frame)",
+			"requested_frame", requested_frame,
+			"omp_get_thread_num()", omp_get_thread_num());
+
+	// Init some basic properties about this frame
+	int samples_in_frame = Frame::GetSamplesPerFrame(requested_frame, info.fps, info.sample_rate, info.channels);
+
+	// Create blank frame (which will become the requested frame)
+	std::shared_ptr<Frame> new_frame(std::make_shared<Frame>(requested_frame, width, height, "#000000", samples_in_frame, info.channels));
+	new_frame->AddAudioSilence(samples_in_frame);
+	new_frame->SampleRate(info.sample_rate);
+	new_frame->ChannelsLayout(info.channel_layout);
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod(
+			"Timeline::render_frame (Adding solid color)",
+			"requested_frame", requested_frame,
+			"info.width", info.width,
+			"info.height", info.height);
+
+	// Add Background Color to 1st layer (if animated or not black)
+	if ((color.red.GetCount() > 1 || color.green.GetCount() > 1 || color.blue.GetCount() > 1) ||
+		(color.red.GetValue(requested_frame) != 0.0 || color.green.GetValue(requested_frame) != 0.0 ||
+		 color.blue.GetValue(requested_frame) != 0.0))
+		new_frame->AddColor(width, height, color.GetColorHex(requested_frame));
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod(
+			"Timeline::render_frame (Loop through clips)",
+			"requested_frame", requested_frame,
+			"clips.size()", clips.size(),
+			"nearby_clips.size()", nearby_clips.size());
+
+	// Find Clips near this time
+	for (auto clip : nearby_clips) {
+		long clip_start_position = round(clip->Position() * info.fps.ToDouble()) + 1;
+		long clip_end_position = round((clip->Position() + clip->Duration()) * info.fps.ToDouble());
+		bool does_clip_intersect = (clip_start_position <= requested_frame && clip_end_position >= requested_frame);
+
+		// Debug output
+		ZmqLogger::Instance()->AppendDebugMethod(
+				"Timeline::render_frame (Does clip intersect)",
+				"requested_frame", requested_frame,
+				"clip->Position()", clip->Position(),
+				"clip->Duration()", clip->Duration(),
+				"does_clip_intersect", does_clip_intersect);
+
+		// Clip is visible
+		if (does_clip_intersect) {
+			// Determine if clip is "top" clip on this layer (only happens when multiple clips are overlapping)
+			bool is_top_clip = true;
+			float max_volume = 0.0;
+			for (auto nearby_clip : nearby_clips) {
+				long nearby_clip_start_position = round(nearby_clip->Position() * info.fps.ToDouble()) + 1;
+				long nearby_clip_end_position = round((nearby_clip->Position() + nearby_clip->Duration()) * info.fps.ToDouble()) + 1;
+				long nearby_clip_start_frame = (nearby_clip->Start() * info.fps.ToDouble()) + 1;
+				long nearby_clip_frame_number = requested_frame - nearby_clip_start_position + nearby_clip_start_frame;
+
+				// Determine if top clip
+				if (clip->Id() != nearby_clip->Id() && clip->Layer() == nearby_clip->Layer() &&
+					nearby_clip_start_position <= requested_frame && nearby_clip_end_position >= requested_frame &&
+					nearby_clip_start_position > clip_start_position && is_top_clip == true) {
+					is_top_clip = false;
 				}
 
-			} // end clip loop
+				// Determine max volume of overlapping clips
+				if (nearby_clip->Reader() && nearby_clip->Reader()->info.has_audio &&
+					nearby_clip->has_audio.GetInt(nearby_clip_frame_number) != 0 &&
+					nearby_clip_start_position <= requested_frame && nearby_clip_end_position >= requested_frame) {
+					max_volume += nearby_clip->volume.GetValue(nearby_clip_frame_number);
+				}
+			}
+
+			// Determine the frame needed for this clip (based on the position on the timeline)
+			long clip_start_frame = (clip->Start() * info.fps.ToDouble()) + 1;
+			long clip_frame_number = requested_frame - clip_start_position + clip_start_frame;
 
 			// Debug output
 			ZmqLogger::Instance()->AppendDebugMethod(
-					"Timeline::GetFrame (Add frame to cache)",
+					"Timeline::render_frame (Calculate clip's frame #)",
+					"clip->Position()", clip->Position(),
+					"clip->Start()", clip->Start(),
+					"info.fps.ToFloat()", info.fps.ToFloat(),
+					"clip_frame_number", clip_frame_number);
+
+			// Add clip's frame as layer
+			add_layer(new_frame, clip, clip_frame_number, is_top_clip, max_volume, is_scrubbing);
+
+		} else {
+			// Debug output
+			ZmqLogger::Instance()->AppendDebugMethod(
+					"Timeline::render_frame (clip does not intersect)",
 					"requested_frame", requested_frame,
-					"info.width", info.width,
-					"info.height", info.height);
+					"does_clip_intersect", does_clip_intersect);
+		}
 
-			// Set frame # on mapped frame
-			new_frame->SetFrameNumber(requested_frame);
+	} // end clip loop
 
-			// Add final frame to cache
-			final_cache->Add(new_frame);
+	// Set frame # on mapped frame
+	new_frame->SetFrameNumber(requested_frame);
 
-			// Return frame (or blank frame)
-			return new_frame;
+	return new_frame;
+}
+
+// Get the render cache key of a frame
+bool Timeline::render_cache_key(int64_t requested_frame, std::string& key)
+{
+	// Settings of the timeline
+	Json::Value state;
+	state["version"] = OPENSHOT_VERSION_FULL;
+	state["width"] = preview_width;
+	state["height"] = preview_height;
+	state["fps"]["num"] = info.fps.num;
+	state["fps"]["den"] = info.fps.den;
+	state["sample_rate"] = info.sample_rate;
+	state["channels"] = info.channels;
+	state["channel_layout"] = info.channel_layout;
+	state["samples"] = Frame::GetSamplesPerFrame(requested_frame, info.fps, info.sample_rate, info.channels);
+	state["color"] = render_cache_state(color.JsonValue(), requested_frame);
+	state["high_quality_scaling"] = Settings::Instance()->HIGH_QUALITY_SCALING;
+	state["clips"] = Json::Value(Json::arrayValue);
+	state["effects"] = Json::Value(Json::arrayValue);
+
+	// Properties of the clips at this frame
+	for (auto clip : clips) {
+		long clip_start_position = round(clip->Position() * info.fps.ToDouble()) + 1;
+		long clip_end_position = round((clip->Position() + clip->Duration()) * info.fps.ToDouble()) + 1;
+		if (clip_start_position > requested_frame || clip_end_position < requested_frame)
+			continue;
+
+		// Time mapped audio depends on the previous frames, and attached clips depend on other objects
+		load_clip(clip);
+		if (clip->time.GetCount() > 1 || clip->GetAttachedClip() || clip->GetAttachedObject())
+			return false;
+
+		long clip_start_frame = (clip->Start() * info.fps.ToDouble()) + 1;
+		long clip_frame_number = requested_frame - clip_start_position + clip_start_frame;
+		Json::Value clip_state = render_cache_state(clip->JsonValue(), clip_frame_number);
+		clip_state["frame"] = (Json::Int64) clip_frame_number;
+
+		// A nested timeline renders the frame the clip requests from it (time mapped clips aren't cached, so
+		// only a FrameMapper changes its number), with its own clips and effects at that frame
+		if (!clip_state["reader"].isNull()) {
+			ReaderBase* clip_reader = clip->Reader();
+			int64_t reader_frame_number = clip_frame_number;
+			if (FrameMapper* mapper = dynamic_cast<FrameMapper*>(clip_reader)) {
+				try {
+					reader_frame_number = mapper->GetMappedFrame(clip_frame_number).Odd.Frame;
+				} catch (const OutOfBoundsFrame & e) {
+					return false;
+				}
+				clip_reader = mapper->Reader();
+			}
+			if (Timeline* nested_timeline = dynamic_cast<Timeline*>(clip_reader)) {
+				std::string nested_key;
+				if (!nested_timeline->render_cache_key(reader_frame_number, nested_key))
+					return false;
+				clip_state["reader"] = nested_key;
+			}
 		}
+
+		// Audio is ramped from the volume of the previous frame
+		clip_state["previous_volume"] = clip->volume.GetValue(clip_frame_number - 1);
+		state["clips"].append(clip_state);
 	}
+
+	// Properties of the effects at this frame
+	for (auto effect : effects) {
+		long effect_start_position = round(effect->Position() * info.fps.ToDouble()) + 1;
+		long effect_end_position = round((effect->Position() + effect->Duration()) * info.fps.ToDouble());
+		if (effect_start_position > requested_frame || effect_end_position < requested_frame)
+			continue;
+
+		long effect_start_frame = (effect->Start() * info.fps.ToDouble()) + 1;
+		long effect_frame_number = requested_frame - effect_start_position + effect_start_frame;
+		Json::Value effect_state = render_cache_state(effect->JsonValue(), effect_frame_number);
+		effect_state["frame"] = (Json::Int64) effect_frame_number;
+		state["effects"].append(effect_state);
+	}
+
+	key = RenderCache::Key(state);
+	return true;
 }
 
+// Replace the keyframes in JSON with their values at a frame, and add the size and modification time of files
+Json::Value Timeline::render_cache_state(const Json::Value& root, int64_t frame_number)
+{
+	if (root.isObject() && root.isMember("Points")) {
+		Keyframe keyframe;
+		keyframe.SetJsonValue(root);
+		return Json::Value(keyframe.GetValue(frame_number));
+	}
+
+	if (root.isArray()) {
+		Json::Value state(Json::arrayValue);
+		for (const auto& item : root)
+			state.append(render_cache_state(item, frame_number));
+		return state;
+	}
+
+	if (root.isObject()) {
+		Json::Value state(Json::objectValue);
+		for (const auto& name : root.getMemberNames()) {
+			const Json::Value& value = root[name];
+			if (value.isString() && (name == "path" || QString::fromStdString(name).endsWith("_path"))) {
+				// Frames are only valid for the same version of the file
+				QFileInfo file(QString::fromStdString(value.asString()));
+				state[name] = value.asString() + "|" + std::to_string(file.size()) + "|" +
+							  std::to_string(file.lastModified().toMSecsSinceEpoch());
+			} else {
+				state[name] = render_cache_state(value, frame_number);
+			}
+		}
+		return state;
+	}
+
+	return root;
+}
 
 // Find intersecting clips (or non intersecting clips)
 std::vector<Clip*> Timeline::find_intersecting_clips(int64_t requested_frame, int number_of_frames, bool include)
@@ -1055,6 +1465,10 @@ std::vector<Clip*> Timeline::find_intersecting_clips(int64_t requested_frame, in
 	float min_requested_frame = requested_frame;
 	float max_requested_frame = requested_frame + (number_of_frames - 1);
 
+	// Clips starting soon after the requested frames are opened ahead of time
+	std::set<Clip*> intersecting_clips;
+	float max_upcoming_frame = max_requested_frame + Settings::Instance()->CLIP_PREWARM_SECONDS * info.fps.ToDouble();
+
 	// Find Clips at this time
 	for (auto clip : clips)
 	{
@@ -1075,8 +1489,17 @@ std::vector<Clip*> Timeline::find_intersecting_clips(int64_t requested_frame, in
 			"clip->Position()", clip->Position(),
 			"does_clip_intersect", does_clip_intersect);
 
-		// Open (or schedule for closing) this clip, based on if it's intersecting or not
-		update_open_clips(clip, does_clip_intersect);
+		bool is_upcoming = !does_clip_intersect &&
+				clip_start_position > max_requested_frame && clip_start_position <= max_upcoming_frame;
+		if (does_clip_intersect)
+			intersecting_clips.insert(clip);
+
+		// Load the clip (if it isn't loaded yet), now that it's needed
+		if (does_clip_intersect || is_upcoming)
+			load_clip(clip);
+
+		// Open (or schedule for opening or closing) this clip, based on if it's intersecting or upcoming
+		update_open_clips(clip, does_clip_intersect, is_upcoming);
 
 		// Clip is visible
 		if (does_clip_intersect && include)
@@ -1089,10 +1512,69 @@ std::vector<Clip*> Timeline::find_intersecting_clips(int64_t requested_frame, in
 
 	} // end clip loop
 
+	// Don't keep too many clips open
+	limit_open_clips(intersecting_clips);
+
 	// return list
 	return matching_clips;
 }
 
+// Load a clip which was only partly loaded from JSON
+void Timeline::load_clip(Clip* clip)
+{
+	// Get lock (prevent getting frames while this happens)
+	const std::lock_guard<std::recursive_mutex> guard(getFrameMutex);
+
+	auto itr = pending_clips.find(clip);
+	if (itr == pending_clips.end())
+		return;
+	Json::Value root = pending_clip_json(clip);
+	pending_clips.erase(itr);
+
+	// Debug output
+	ZmqLogger::Instance()->AppendDebugMethod("Timeline::load_clip", "clip->Position()", clip->Position(), "pending_clips.size()", pending_clips.size());
+
+	// Load Json into Clip
+	clip->SetJsonValue(root);
+
+	// All clips should be converted to the frame rate of this timeline
+	if (auto_map_clips)
+		apply_mapper_to_clip(clip);
+}
+
+// Load the clips which aren't loaded yet, and have an effect matching a filter
+void Timeline::load_clips_with_effects(const std::function<bool(const Json::Value&)>& is_needed)
+{
+	// Get lock (prevent getting frames while this happens)
+	const std::lock_guard<std::recursive_mutex> guard(getFrameMutex);
+
+	// Find the clips first (loading a clip can load other clips)
+	std::vector<Clip*> needed_clips;
+	for (const auto& pending : pending_clips) {
+		for (const auto& effect : pending.second["effects"]) {
+			if (is_needed(effect)) {
+				needed_clips.push_back(pending.first);
+				break;
+			}
+		}
+	}
+	for (auto clip : needed_clips)
+		load_clip(clip);
+}
+
+// Get the JSON of a clip which isn't loaded yet
+Json::Value Timeline::pending_clip_json(Clip* clip) const
+{
+	// The timing of the clip may have changed since it was loaded
+	Json::Value root = pending_clips.at(clip);
+	root["id"] = clip->Id();
+	root["position"] = clip->Position();
+	root["layer"] = clip->Layer();
+	root["start"] = clip->Start();
+	root["end"] = clip->End();
+	return root;
+}
+
 // Set the cache object used by this reader
 void Timeline::SetCache(CacheBase* new_cache) {
 	// Get lock (prevent getting frames while this happens)
@@ -1134,7 +1616,10 @@ Json::Value Timeline::JsonValue() const {
 	// Find Clips at this time
 	for (const auto existing_clip : clips)
 	{
-		root["clips"].append(existing_clip->JsonValue());
+		if (pending_clips.count(existing_clip))
+			root["clips"].append(pending_clip_json(existing_clip));
+		else
+			root["clips"].append(existing_clip->JsonValue());
 	}
 
 	// Add array of effects
@@ -1150,6 +1635,16 @@ Json::Value Timeline::JsonValue() const {
 	return root;
 }
 
+// Save a binary snapshot of the project
+void Timeline::SaveSnapshot(const std::string& path) const {
+	ProjectSnapshot::Save(JsonValue(), path);
+}
+
+// Load a binary snapshot of the project
+void Timeline::LoadSnapshot(const std::string& path) {
+	SetJsonValue(ProjectSnapshot::Load(path));
+}
+
 // Load JSON string into this object
 void Timeline::SetJson(const std::string value) {
 
@@ -1171,7 +1666,7 @@ void Timeline::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Timeline::SetJsonValue(const Json::Value root) {
+void Timeline::SetJsonValue(const Json::Value& root) {
 
 	// Get lock (prevent getting frames while this happens)
 	const std::lock_guard<std::recursive_mutex> lock(getFrameMutex);
@@ -1190,9 +1685,10 @@ void Timeline::SetJsonValue(const Json::Value root) {
 	if (!root["clips"].isNull()) {
 		// Clear existing clips
 		clips.clear();
+		pending_clips.clear();
 
 		// loop through clips
-		for (const Json::Value existing_clip : root["clips"]) {
+		for (const Json::Value& existing_clip : root["clips"]) {
 			// Skip NULL nodes
 			if (existing_clip.isNull()) {
 				continue;
@@ -1211,12 +1707,29 @@ void Timeline::SetJsonValue(const Json::Value root) {
 			// before setting its parent timeline.
 			c->ParentTimeline(this);
 
+			if (Settings::Instance()->LAZY_LOAD_CLIPS) {
+				// Only load the timing of the clip now (the rest is loaded when the clip is first needed)
+				Json::Value timing;
+				for (const char* name : {"id", "position", "layer", "start", "end"}) {
+					if (!existing_clip[name].isNull())
+						timing[name] = existing_clip[name];
+				}
+				c->SetJsonValue(timing);
+				pending_clips[c] = existing_clip;
+				clips.push_back(c);
+				continue;
+			}
+
 			// Load Json into Clip
 			c->SetJsonValue(existing_clip);
 
 			// Add Clip to Timeline
 			AddClip(c);
 		}
+
+		// Sort clips (which weren't added with AddClip)
+		if (!pending_clips.empty())
+			sort_clips();
 	}
 
 	if (!root["effects"].isNull()) {
@@ -1224,7 +1737,7 @@ void Timeline::SetJsonValue(const Json::Value root) {
 		effects.clear();
 
 		// loop through effects
-		for (const Json::Value existing_effect :root["effects"]) {
+		for (const Json::Value& existing_effect : root["effects"]) {
 			// Skip NULL nodes
 			if (existing_effect.isNull()) {
 				continue;
@@ -1266,7 +1779,7 @@ void Timeline::SetJsonValue(const Json::Value root) {
 }
 
 // Apply a special formatted JSON object, which represents a change to the timeline (insert, update, delete)
-void Timeline::ApplyJsonDiff(std::string value) {
+void Timeline::ApplyJsonDiff(const std::string& value) {
 
 	// Get lock (prevent getting frames while this happens)
 	const std::lock_guard<std::recursive_mutex> lock(getFrameMutex);
@@ -1276,7 +1789,7 @@ void Timeline::ApplyJsonDiff(std::string value) {
 	{
 		const Json::Value root = openshot::stringToJson(value);
 		// Process the JSON change array, loop through each item
-		for (const Json::Value change : root) {
+		for (const Json::Value& change : root) {
 			std::string change_key = change["key"][(uint)0].asString();
 
 			// Process each type of change
@@ -1302,7 +1815,7 @@ void Timeline::ApplyJsonDiff(std::string value) {
 }
 
 // Apply JSON diff to clips
-void Timeline::apply_json_to_clips(Json::Value change) {
+void Timeline::apply_json_to_clips(const Json::Value& change) {
 
 	// Get key and type of change
 	std::string change_type = change["type"].asString();
@@ -1310,7 +1823,7 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 	Clip *existing_clip = NULL;
 
 	// Find id of clip (if any)
-	for (auto key_part : change["key"]) {
+	for (const auto& key_part : change["key"]) {
 		// Get each change
 		if (key_part.isObject()) {
 			// Check for id
@@ -1331,12 +1844,16 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 		}
 	}
 
+	// Load the clip (if it isn't loaded yet), so the change is applied to all of its properties
+	if (existing_clip)
+		load_clip(existing_clip);
+
 	// Check for a more specific key (targetting this clip's effects)
 	// For example: ["clips", {"id:123}, "effects", {"id":432}]
 	if (existing_clip && change["key"].size() == 4 && change["key"][2] == "effects")
 	{
 		// This change is actually targetting a specific effect under a clip (and not the clip)
-		Json::Value key_part = change["key"][3];
+		const Json::Value& key_part = change["key"][3];
 
 		if (key_part.isObject()) {
 			// Check for id
@@ -1350,14 +1867,9 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 				for (auto e : effect_list)
 				{
 					if (e->Id() == effect_id) {
-						// Apply the change to the effect directly
+						// Apply the change to the effect directly (which removes the changed frames from the cache)
 						apply_json_to_effects(change, e);
 
-						// Calculate start and end frames that this impacts, and remove those frames from the cache
-						int64_t new_starting_frame = (existing_clip->Position() * info.fps.ToDouble()) + 1;
-						int64_t new_ending_frame = ((existing_clip->Position() + existing_clip->Duration()) * info.fps.ToDouble()) + 1;
-						final_cache->Remove(new_starting_frame - 8, new_ending_frame + 8);
-
 						return; // effect found, don't update clip
 					}
 				}
@@ -1365,13 +1877,6 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 		}
 	}
 
-	// Calculate start and end frames that this impacts, and remove those frames from the cache
-	if (!change["value"].isArray() && !change["value"]["position"].isNull()) {
-		int64_t new_starting_frame = (change["value"]["position"].asDouble() * info.fps.ToDouble()) + 1;
-		int64_t new_ending_frame = ((change["value"]["position"].asDouble() + change["value"]["end"].asDouble() - change["value"]["start"].asDouble()) * info.fps.ToDouble()) + 1;
-		final_cache->Remove(new_starting_frame - 8, new_ending_frame + 8);
-	}
-
 	// Determine type of change operation
 	if (change_type == "insert") {
 
@@ -1381,25 +1886,37 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 		// Keep track of allocated clip objects
 		allocated_clips.insert(clip);
 
-		// Set properties of clip from JSON
+		// Set properties of clip from JSON (on this timeline, which decides if its reader is shared)
+		clip->ParentTimeline(this);
 		clip->SetJsonValue(change["value"]);
 
 		// Add clip to timeline
 		AddClip(clip);
 
+		// Remove the frames of the new clip from the cache
+		clear_clip_frames(clip);
+
 	} else if (change_type == "update") {
 
 		// Update existing clip
 		if (existing_clip) {
 
-			// Calculate start and end frames that this impacts, and remove those frames from the cache
-			int64_t old_starting_frame = (existing_clip->Position() * info.fps.ToDouble()) + 1;
-			int64_t old_ending_frame = ((existing_clip->Position() + existing_clip->Duration()) * info.fps.ToDouble()) + 1;
-			final_cache->Remove(old_starting_frame - 8, old_ending_frame + 8);
-
-			// Remove cache on clip's Reader (if found)
-			if (existing_clip->Reader() && existing_clip->Reader()->GetCache())
-				existing_clip->Reader()->GetCache()->Remove(old_starting_frame - 8, old_ending_frame + 8);
+			// Wait until the clip is done opening or closing in the background
+			bool open_job = false;
+			bool cancelled = finish_clip_job(existing_clip, open_job);
+
+			// Find the frames which change (before the clip is updated). Reader caches are kept: if the
+			// reader changes, the clip creates a new one. The reader JSON of a mapped clip is the
+			// FrameMapper's, so the reader is compared with the settings of the clip's own reader.
+			double first_x = std::numeric_limits<double>::infinity();
+			double last_x = -std::numeric_limits<double>::infinity();
+			Json::Value old_value = existing_clip->JsonValue();
+			if (change["value"].isMember("reader") && existing_clip->HasReaderSettings(change["value"]["reader"]))
+				old_value["reader"] = change["value"]["reader"];
+			bool changed = find_changed_frames(old_value, change["value"], first_x, last_x);
+			int64_t old_starting_frame = round(existing_clip->Position() * info.fps.ToDouble()) + 1;
+			int64_t old_ending_frame = round((existing_clip->Position() + existing_clip->Duration()) * info.fps.ToDouble()) + 1;
+			int64_t old_frame_offset = old_starting_frame - (int64_t(existing_clip->Start() * info.fps.ToDouble()) + 1);
 
 			// Update clip properties from JSON
 			existing_clip->SetJsonValue(change["value"]);
@@ -1408,6 +1925,23 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 			if (auto_map_clips) {
 				apply_mapper_to_clip(existing_clip);
 			}
+
+			// Queue the cancelled job again
+			if (cancelled)
+				queue_clip_job(existing_clip, open_job);
+
+			if (changed) {
+				// Remove the changed frames from the cache (all of them, if the clip was moved or trimmed)
+				clear_changed_frames(first_x, last_x, old_frame_offset, old_starting_frame, old_ending_frame);
+				if (std::isinf(first_x) || std::isinf(last_x))
+					clear_clip_frames(existing_clip);
+
+				// Clips attached to this clip change too
+				for (auto clip : clips) {
+					if (clip->GetAttachedClip() == existing_clip)
+						clear_clip_frames(clip);
+				}
+			}
 		}
 
 	} else if (change_type == "delete") {
@@ -1415,10 +1949,8 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 		// Remove existing clip
 		if (existing_clip) {
 
-			// Calculate start and end frames that this impacts, and remove those frames from the cache
-			int64_t old_starting_frame = (existing_clip->Position() * info.fps.ToDouble()) + 1;
-			int64_t old_ending_frame = ((existing_clip->Position() + existing_clip->Duration()) * info.fps.ToDouble()) + 1;
-			final_cache->Remove(old_starting_frame - 8, old_ending_frame + 8);
+			// Remove the frames of the clip from the cache
+			clear_clip_frames(existing_clip);
 
 			// Remove clip from timeline
 			RemoveClip(existing_clip);
@@ -1431,14 +1963,14 @@ void Timeline::apply_json_to_clips(Json::Value change) {
 }
 
 // Apply JSON diff to effects
-void Timeline::apply_json_to_effects(Json::Value change) {
+void Timeline::apply_json_to_effects(const Json::Value& change) {
 
 	// Get key and type of change
 	std::string change_type = change["type"].asString();
 	EffectBase *existing_effect = NULL;
 
 	// Find id of an effect (if any)
-	for (auto key_part : change["key"]) {
+	for (const auto& key_part : change["key"]) {
 
 		if (key_part.isObject()) {
 			// Check for id
@@ -1468,17 +2000,13 @@ void Timeline::apply_json_to_effects(Json::Value change) {
 }
 
 // Apply JSON diff to effects (if you already know which effect needs to be updated)
-void Timeline::apply_json_to_effects(Json::Value change, EffectBase* existing_effect) {
+void Timeline::apply_json_to_effects(const Json::Value& change, EffectBase* existing_effect) {
 
 	// Get key and type of change
 	std::string change_type = change["type"].asString();
 
-	// Calculate start and end frames that this impacts, and remove those frames from the cache
-	if (!change["value"].isArray() && !change["value"]["position"].isNull()) {
-		int64_t new_starting_frame = (change["value"]["position"].asDouble() * info.fps.ToDouble()) + 1;
-		int64_t new_ending_frame = ((change["value"]["position"].asDouble() + change["value"]["end"].asDouble() - change["value"]["start"].asDouble()) * info.fps.ToDouble()) + 1;
-		final_cache->Remove(new_starting_frame - 8, new_ending_frame + 8);
-	}
+	// Effects of a clip use the clip's frame numbers
+	Clip* parent_clip = existing_effect ? static_cast<Clip*>(existing_effect->ParentClip()) : NULL;
 
 	// Determine type of change operation
 	if (change_type == "insert") {
@@ -1500,6 +2028,9 @@ void Timeline::apply_json_to_effects(Json::Value change, EffectBase* existing_ef
 
 			// Add Effect to Timeline
 			AddEffect(e);
+
+			// Remove the frames of the new effect from the cache
+			clear_effect_frames(e);
 		}
 
 	} else if (change_type == "update") {
@@ -1507,13 +2038,36 @@ void Timeline::apply_json_to_effects(Json::Value change, EffectBase* existing_ef
 		// Update existing effect
 		if (existing_effect) {
 
-			// Calculate start and end frames that this impacts, and remove those frames from the cache
-			int64_t old_starting_frame = (existing_effect->Position() * info.fps.ToDouble()) + 1;
-			int64_t old_ending_frame = ((existing_effect->Position() + existing_effect->Duration()) * info.fps.ToDouble()) + 1;
-			final_cache->Remove(old_starting_frame - 8, old_ending_frame + 8);
+			// Find the frames which change (before the effect is updated)
+			double first_x = std::numeric_limits<double>::infinity();
+			double last_x = -std::numeric_limits<double>::infinity();
+			bool changed = find_changed_frames(existing_effect->JsonValue(), change["value"], first_x, last_x);
+			int64_t old_starting_frame = round(existing_effect->Position() * info.fps.ToDouble()) + 1;
+			int64_t old_ending_frame = round((existing_effect->Position() + existing_effect->Duration()) * info.fps.ToDouble()) + 1;
+			int64_t old_frame_offset = old_starting_frame - (int64_t(existing_effect->Start() * info.fps.ToDouble()) + 1);
+			if (parent_clip) {
+				old_starting_frame = round(parent_clip->Position() * info.fps.ToDouble()) + 1;
+				old_ending_frame = round((parent_clip->Position() + parent_clip->Duration()) * info.fps.ToDouble()) + 1;
+				old_frame_offset = old_starting_frame - (int64_t(parent_clip->Start() * info.fps.ToDouble()) + 1);
+			}
 
 			// Update effect properties from JSON
 			existing_effect->SetJsonValue(change["value"]);
+
+			if (changed) {
+				// Remove the changed frames from the cache (all of them, if the effect was moved or trimmed)
+				clear_changed_frames(first_x, last_x, old_frame_offset, old_starting_frame, old_ending_frame);
+				if (!parent_clip && (std::isinf(first_x) || std::isinf(last_x)))
+					clear_effect_frames(existing_effect);
+
+				// Clips attached to the effect's tracked objects change too
+				if (existing_effect->info.has_tracked_object) {
+					for (auto clip : clips) {
+						if (clip->GetAttachedObject())
+							clear_clip_frames(clip);
+					}
+				}
+			}
 		}
 
 	} else if (change_type == "delete") {
@@ -1521,10 +2075,11 @@ void Timeline::apply_json_to_effects(Json::Value change, EffectBase* existing_ef
 		// Remove existing effect
 		if (existing_effect) {
 
-			// Calculate start and end frames that this impacts, and remove those frames from the cache
-			int64_t old_starting_frame = (existing_effect->Position() * info.fps.ToDouble()) + 1;
-			int64_t old_ending_frame = ((existing_effect->Position() + existing_effect->Duration()) * info.fps.ToDouble()) + 1;
-			final_cache->Remove(old_starting_frame - 8, old_ending_frame + 8);
+			// Remove the frames of the effect from the cache
+			if (parent_clip)
+				clear_clip_frames(parent_clip);
+			else
+				clear_effect_frames(existing_effect);
 
 			// Remove effect from timeline
 			RemoveEffect(existing_effect);
@@ -1537,7 +2092,7 @@ void Timeline::apply_json_to_effects(Json::Value change, EffectBase* existing_ef
 }
 
 // Apply JSON diff to timeline properties
-void Timeline::apply_json_to_timeline(Json::Value change) {
+void Timeline::apply_json_to_timeline(const Json::Value& change) {
 	bool cache_dirty = true;
 
 	// Get key and type of change
@@ -1547,6 +2102,9 @@ void Timeline::apply_json_to_timeline(Json::Value change) {
 	if (change["key"].size() >= 2)
 		sub_key = change["key"][(uint)1].asString();
 
+	// Keyframes of the timeline only change the frames between their changed points
+	Json::Value old_keyframes = keyframes_json_value();
+
 	// Determine type of change operation
 	if (change_type == "insert" || change_type == "update") {
 
@@ -1658,12 +2216,131 @@ void Timeline::apply_json_to_timeline(Json::Value change) {
 
 	}
 
+	if (root_key == "color" || root_key == "viewport_scale" || root_key == "viewport_x" || root_key == "viewport_y") {
+		// Remove the changed frames from the cache (reader caches are still valid)
+		double first_x = std::numeric_limits<double>::infinity();
+		double last_x = -std::numeric_limits<double>::infinity();
+		if (find_changed_frames(old_keyframes, keyframes_json_value(), first_x, last_x))
+			clear_changed_frames(first_x, last_x, 0, 1, std::numeric_limits<int64_t>::max());
+		cache_dirty = false;
+	}
+
 	if (cache_dirty) {
 		// Clear entire cache
 		ClearAllCache();
 	}
 }
 
+// Generate a Json::Value of the keyframes of the timeline (which can change without clearing the whole cache)
+Json::Value Timeline::keyframes_json_value() const
+{
+	Json::Value root;
+	root["color"] = color.JsonValue();
+	root["viewport_scale"] = viewport_scale.JsonValue();
+	root["viewport_x"] = viewport_x.JsonValue();
+	root["viewport_y"] = viewport_y.JsonValue();
+	return root;
+}
+
+// Find the frames where a property of a clip or effect changes
+bool Timeline::find_changed_frames(const Json::Value& old_value, const Json::Value& new_value, double& first_x, double& last_x)
+{
+	if (old_value == new_value || (old_value.isNumeric() && new_value.isNumeric() && old_value.asDouble() == new_value.asDouble()))
+		return false;
+
+	if (old_value.isObject() && new_value.isObject() && old_value.isMember("Points") && new_value.isMember("Points")) {
+		// Keyframes only change between the points around the changed points
+		Keyframe old_keyframe;
+		Keyframe new_keyframe;
+		old_keyframe.SetJsonValue(old_value);
+		new_keyframe.SetJsonValue(new_value);
+		int64_t old_count = old_keyframe.GetCount();
+		int64_t new_count = new_keyframe.GetCount();
+
+		// Count the matching points at the start and at the end
+		int64_t same_before = 0;
+		while (same_before < old_count && same_before < new_count &&
+			   old_keyframe.GetPoint(same_before).JsonValue() == new_keyframe.GetPoint(same_before).JsonValue())
+			same_before++;
+		if (same_before == old_count && same_before == new_count)
+			return false;
+		int64_t same_after = 0;
+		while (same_after < old_count - same_before && same_after < new_count - same_before &&
+			   old_keyframe.GetPoint(old_count - 1 - same_after).JsonValue() == new_keyframe.GetPoint(new_count - 1 - same_after).JsonValue())
+			same_after++;
+
+		// Values before the first point (and after the last point) are constant
+		first_x = std::min(first_x, same_before > 0 ? old_keyframe.GetPoint(same_before - 1).co.X : -std::numeric_limits<double>::infinity());
+		last_x = std::max(last_x, same_after > 0 ? old_keyframe.GetPoint(old_count - same_after).co.X : std::numeric_limits<double>::infinity());
+		return true;
+	}
+
+	if (old_value.isObject() && new_value.isObject()) {
+		// Objects (such as colors, or objects of keyframes) change where their members change.
+		// Members which aren't in the current JSON are ignored when the JSON is loaded.
+		bool changed = false;
+		for (const auto& name : new_value.getMemberNames()) {
+			if (old_value.isMember(name))
+				changed = find_changed_frames(old_value[name], new_value[name], first_x, last_x) || changed;
+		}
+		return changed;
+	}
+
+	// Any other value changes every frame
+	first_x = -std::numeric_limits<double>::infinity();
+	last_x = std::numeric_limits<double>::infinity();
+	return true;
+}
+
+// Remove a range of timeline frames from the cache (and the frames of the clips composited into them)
+void Timeline::clear_cache_range(int64_t start_frame, int64_t end_frame)
+{
+	if (end_frame < start_frame)
+		return;
+
+	if (final_cache)
+		final_cache->Remove(start_frame, end_frame);
+
+	// Cached clip frames are composited onto the layers below them
+	for (auto clip : clips) {
+		int64_t clip_start_position = round(clip->Position() * info.fps.ToDouble()) + 1;
+		int64_t clip_end_position = round((clip->Position() + clip->Duration()) * info.fps.ToDouble()) + 1;
+		if (clip_start_position > end_frame || clip_end_position < start_frame)
+			continue;
+
+		int64_t clip_frame_offset = (int64_t(clip->Start() * info.fps.ToDouble()) + 1) - clip_start_position;
+		clip->GetCache()->Remove(std::max(start_frame, clip_start_position) + clip_frame_offset,
+								 std::min(end_frame, clip_end_position) + clip_frame_offset);
+	}
+}
+
+// Remove the timeline frames of a changed span (of clip or effect frame numbers) from the cache
+void Timeline::clear_changed_frames(double first_x, double last_x, int64_t frame_offset, int64_t start_frame, int64_t end_frame)
+{
+	if (first_x > start_frame - frame_offset)
+		start_frame = std::max(start_frame, int64_t(floor(first_x)) + frame_offset - 1);
+	if (last_x < end_frame - frame_offset)
+		end_frame = std::min(end_frame, int64_t(ceil(last_x)) + frame_offset + 1);
+
+	clear_cache_range(start_frame, end_frame);
+}
+
+// Remove all the timeline frames of a clip from the cache
+void Timeline::clear_clip_frames(Clip* clip)
+{
+	int64_t starting_frame = round(clip->Position() * info.fps.ToDouble()) + 1;
+	int64_t ending_frame = round((clip->Position() + clip->Duration()) * info.fps.ToDouble()) + 1;
+	clear_cache_range(starting_frame, ending_frame);
+}
+
+// Remove all the timeline frames of a timeline effect from the cache
+void Timeline::clear_effect_frames(EffectBase* effect)
+{
+	int64_t starting_frame = round(effect->Position() * info.fps.ToDouble()) + 1;
+	int64_t ending_frame = round((effect->Position() + effect->Duration()) * info.fps.ToDouble()) + 1;
+	clear_cache_range(starting_frame, ending_frame);
+}
+
 // Clear all caches
 void Timeline::ClearAllCache(bool deep) {
 
@@ -1675,6 +2352,10 @@ void Timeline::ClearAllCache(bool deep) {
 	// Loop through all clips
 	try {
 		for (const auto clip : clips) {
+			// Clips which aren't loaded yet have nothing cached
+			if (pending_clips.count(clip))
+				continue;
+
 			// Clear cache on clip
 			clip->Reader()->GetCache()->Clear();
 
@@ -13,10 +13,17 @@
 #ifndef OPENSHOT_TIMELINE_H
 #define OPENSHOT_TIMELINE_H
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <thread>
+#include <vector>
 #include <QtGui/QImage>
 #include <QtGui/QPainter>
 #include <QtCore/QRegularExpression>
@@ -149,10 +156,11 @@ namespace openshot {
 	private:
 		bool is_open; ///<Is Timeline Open?
 		bool auto_map_clips; ///< Auto map framerates and sample rates to all clips
+		bool share_media_sources; ///< Clips loaded from JSON share decoders with clips of other timelines
 		std::list<openshot::Clip*> clips; ///<List of clips on this timeline
-		std::list<openshot::Clip*> closing_clips; ///<List of clips that need to be closed
-		std::map<openshot::Clip*, openshot::Clip*> open_clips; ///<List of 'opened' clips on this timeline
+		std::map<openshot::Clip*, std::chrono::steady_clock::time_point> open_clips; ///<List of 'opened' clips on this timeline (and when they were last needed)
 		std::set<openshot::Clip*> allocated_clips; ///<List of clips that were allocated by this timeline
+		std::map<openshot::Clip*, Json::Value> pending_clips; ///< JSON of the clips which are only partly loaded (see Settings::LAZY_LOAD_CLIPS)
 		std::list<openshot::EffectBase*> effects; ///<List of clips on this timeline
 		std::set<openshot::EffectBase*> allocated_effects; ///<List of effects that were allocated by this timeline
 		openshot::CacheBase *final_cache; ///<Final cache of timeline frames
@@ -164,17 +172,60 @@ namespace openshot {
 
 		std::map<std::string, std::shared_ptr<openshot::TrackedObjectBase>> tracked_objects; ///< map of TrackedObjectBBoxes and their IDs
 
+		/// A clip to open or close in the background
+		struct ClipJob {
+			openshot::Clip* clip;
+			bool open;
+		};
+		std::deque<ClipJob> clip_jobs; ///< Clips waiting to be opened or closed in the background (one job per clip)
+		openshot::Clip* running_clip_job; ///< Clip being opened or closed in the background (if any)
+		std::set<openshot::Clip*> failed_clip_opens; ///< Clips which failed to open in the background (until they're removed from open_clips)
+		std::thread clip_jobs_thread;
+		std::mutex clip_jobs_mutex;
+		std::condition_variable clip_jobs_condition;
+		bool clip_jobs_stopping;
+
 		/// Process a new layer of video or audio
-		void add_layer(std::shared_ptr<openshot::Frame> new_frame, openshot::Clip* source_clip, int64_t clip_frame_number, bool is_top_clip, float max_volume);
+		void add_layer(std::shared_ptr<openshot::Frame> new_frame, openshot::Clip* source_clip, int64_t clip_frame_number, bool is_top_clip, float max_volume, bool is_scrubbing = false);
 
 		/// Apply a FrameMapper to a clip which matches the settings of this timeline
 		void apply_mapper_to_clip(openshot::Clip* clip);
 
 		// Apply JSON Diffs to various objects contained in this timeline
-		void apply_json_to_clips(Json::Value change); ///<Apply JSON diff to clips
-		void apply_json_to_effects(Json::Value change); ///< Apply JSON diff to effects
-		void apply_json_to_effects(Json::Value change, openshot::EffectBase* existing_effect); ///<Apply JSON diff to a specific effect
-		void apply_json_to_timeline(Json::Value change); ///<Apply JSON diff to timeline properties
+		void apply_json_to_clips(const Json::Value& change); ///<Apply JSON diff to clips
+		void apply_json_to_effects(const Json::Value& change); ///< Apply JSON diff to effects
+		void apply_json_to_effects(const Json::Value& change, openshot::EffectBase* existing_effect); ///<Apply JSON diff to a specific effect
+		void apply_json_to_timeline(const Json::Value& change); ///<Apply JSON diff to timeline properties
+
+		/// Find the frames where a property of a clip or effect (or a keyframe of the timeline) changes
+		///
+		/// @returns True if any frame changes
+		/// @param old_value The current JSON of the object
+		/// @param new_value The new JSON of the object
+		/// @param first_x Set to the first frame number which changes (or -infinity), if it's before first_x
+		/// @param last_x Set to the last frame number which changes (or +infinity), if it's after last_x
+		bool find_changed_frames(const Json::Value& old_value, const Json::Value& new_value, double& first_x, double& last_x);
+
+		/// Remove a range of timeline frames from the cache (and the frames of the clips composited into them)
+		void clear_cache_range(int64_t start_frame, int64_t end_frame);
+
+		/// Remove the timeline frames of a changed span (of clip or effect frame numbers) from the cache
+		///
+		/// @param first_x The first changed frame number of the clip or effect
+		/// @param last_x The last changed frame number of the clip or effect
+		/// @param frame_offset The timeline frame number minus the clip or effect frame number
+		/// @param start_frame The first timeline frame of the clip or effect
+		/// @param end_frame The last timeline frame of the clip or effect
+		void clear_changed_frames(double first_x, double last_x, int64_t frame_offset, int64_t start_frame, int64_t end_frame);
+
+		/// Remove all the timeline frames of a clip from the cache
+		void clear_clip_frames(openshot::Clip* clip);
+
+		/// Remove all the timeline frames of a timeline effect from the cache
+		void clear_effect_frames(openshot::EffectBase* effect);
+
+		/// Generate a Json::Value of the keyframes of the timeline (color and viewport)
+		Json::Value keyframes_json_value() const;
 
 		/// Calculate the max duration (in seconds) of the timeline, based on all the clips, and cache the value
 		void calculate_max_duration();
@@ -190,20 +241,65 @@ namespace openshot {
 		/// @param include Include or Exclude intersecting clips
 		std::vector<openshot::Clip*> find_intersecting_clips(int64_t requested_frame, int number_of_frames, bool include);
 
+		/// Get the render cache key of a frame: a hash of the timeline settings, and the properties of the clips and
+		/// effects at that frame. Returns false if the frame can't be cached (i.e. it depends on other frames).
+		bool render_cache_key(int64_t requested_frame, std::string& key);
+
+		/// Replace the keyframes in JSON with their values at a frame, and add the size and modification time of files
+		Json::Value render_cache_state(const Json::Value& root, int64_t frame_number);
+
+		/// Load a clip which was only partly loaded from JSON (if it was)
+		void load_clip(openshot::Clip* clip);
+
+		/// Load the clips which aren't loaded yet, and have an effect matching a filter (so their
+		/// effects and tracked objects can be found)
+		void load_clips_with_effects(const std::function<bool(const Json::Value&)>& is_needed);
+
+		/// Get the JSON of a clip which isn't loaded yet (with its current timing)
+		Json::Value pending_clip_json(openshot::Clip* clip) const;
+
 		/// Get a clip's frame or generate a blank frame
 		std::shared_ptr<openshot::Frame> GetOrCreateFrame(std::shared_ptr<Frame> background_frame, openshot::Clip* clip, int64_t number, openshot::TimelineInfoStruct* options);
 
 		/// Compare 2 floating point numbers for equality
 		bool isEqual(double a, double b);
 
+		/// Render a frame of the timeline on a canvas of a specific size (without caching it). Scrubbing
+		/// frames also bypass the clips' caches, so they are never reused for full-size frames.
+		std::shared_ptr<openshot::Frame> render_frame(int64_t requested_frame, int width, int height, bool is_scrubbing);
+
 		/// Sort clips by position on the timeline
 		void sort_clips();
 
 		/// Sort effects by position on the timeline
 		void sort_effects();
 
-		/// Update the list of 'opened' clips
-		void update_open_clips(openshot::Clip *clip, bool does_clip_intersect);
+		/// Update the list of 'opened' clips. Intersecting clips are opened right away, upcoming clips are
+		/// opened in the background, and other clips are closed in the background once they haven't been
+		/// needed for Settings::CLIP_CLOSE_DELAY seconds.
+		void update_open_clips(openshot::Clip *clip, bool does_clip_intersect, bool is_upcoming = false);
+
+		/// Close the least recently needed clips, while more clips are open than Settings::MAX_OPEN_CLIPS
+		void limit_open_clips(const std::set<openshot::Clip*>& needed_clips);
+
+		/// Close a clip right away (and remove it from the list of 'opened' clips)
+		void close_clip(openshot::Clip *clip);
+
+		/// Open or close a clip in the background (replacing the clip's queued job, if any)
+		void queue_clip_job(openshot::Clip *clip, bool open);
+
+		/// Cancel the queued job of a clip, and wait for its running job (if any), so the clip can be used.
+		/// Returns true if a job was cancelled (and sets @a open to the type of job).
+		bool finish_clip_job(openshot::Clip *clip, bool& open);
+
+		/// Remove the clips which failed to open in the background from open_clips (so they're opened again when needed)
+		void forget_failed_clip_opens();
+
+		/// Open and close clips in the background (on clip_jobs_thread)
+		void run_clip_jobs();
+
+		/// Stop the background thread (dropping queued jobs)
+		void stop_clip_jobs();
 
 	public:
 
@@ -234,12 +330,12 @@ namespace openshot {
 		/// Add to the tracked_objects map a pointer to a tracked object (TrackedObjectBBox)
 		void AddTrackedObject(std::shared_ptr<openshot::TrackedObjectBase> trackedObject);
 		/// Return tracked object pointer by it's id
-		std::shared_ptr<openshot::TrackedObjectBase> GetTrackedObject(std::string id) const;
+		std::shared_ptr<openshot::TrackedObjectBase> GetTrackedObject(std::string id);
 		/// Return the ID's of the tracked objects as a list of strings
-		std::list<std::string> GetTrackedObjectsIds() const;
+		std::list<std::string> GetTrackedObjectsIds();
 		/// Return the trackedObject's properties as a JSON string
 		#ifdef USE_OPENCV
-		std::string GetTrackedObjectValues(std::string id, int64_t frame_number) const;
+		std::string GetTrackedObjectValues(std::string id, int64_t frame_number);
 		#endif
 
 		/// @brief Add an openshot::Clip to the timeline
@@ -262,6 +358,13 @@ namespace openshot {
 		/// @brief Automatically map all clips to the timeline's framerate and samplerate
 		void AutoMapClips(bool auto_map) { auto_map_clips = auto_map; };
 
+		/// Determine if clips loaded from JSON share their decoders (see MediaSourceRegistry)
+		bool ShareMediaSources() { return share_media_sources; };
+
+		/// @brief Share the decoders of clips loaded from JSON with other clips of the same files (if
+		/// Settings::SHARE_MEDIA_SOURCES is also set). Timelines used on other threads should not.
+		void ShareMediaSources(bool share) { share_media_sources = share; };
+
 		/// Clear all clips, effects, and frame mappers from timeline (and free memory)
 		void Clear();
 
@@ -293,7 +396,7 @@ namespace openshot {
 		std::list<openshot::EffectBase*> Effects() { return effects; };
 
 		/// Return the list of effects on all clips
-		std::list<openshot::EffectBase*> ClipEffects() const;
+		std::list<openshot::EffectBase*> ClipEffects();
 
 		/// Get the cache object used by this reader
 		openshot::CacheBase* GetCache() override { return final_cache; };
@@ -308,6 +411,14 @@ namespace openshot {
 		/// @param requested_frame The frame number that is requested.
 		std::shared_ptr<openshot::Frame> GetFrame(int64_t requested_frame) override;
 
+		/// @brief Get a frame quickly while scrubbing: a cached frame if available, or else a frame rendered
+		/// at a reduced resolution (Settings::SCRUB_PREVIEW_SCALE of the preview size), which isn't cached.
+		///
+		/// Call GetFrame() once the playhead rests, to refine the frame to the full preview size.
+		/// @returns The requested frame (containing the image)
+		/// @param requested_frame The frame number that is requested.
+		std::shared_ptr<openshot::Frame> GetScrubFrame(int64_t requested_frame);
+
 		// Curves for the viewport
 		openshot::Keyframe viewport_scale; ///<Curve representing the scale of the viewport (0 to 100)
 		openshot::Keyframe viewport_x; ///<Curve representing the x coordinate for the viewport
@@ -326,7 +437,16 @@ namespace openshot {
 		std::string Json() const override; ///< Generate JSON string of this object
 		void SetJson(const std::string value) override; ///< Load JSON string into this object
 		Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
+
+		/// @brief Save a binary snapshot of the project (see openshot::ProjectSnapshot), which is much faster to
+		/// save and load than JSON (for autosaves)
+		/// @param path The path of the snapshot file
+		void SaveSnapshot(const std::string& path) const;
+
+		/// @brief Load a binary snapshot of the project (saved with SaveSnapshot)
+		/// @param path The path of the snapshot file
+		void LoadSnapshot(const std::string& path);
 
 		/// Set Max Image Size (used for performance optimization). Convenience function for setting
 		/// Settings::Instance()->MAX_WIDTH and Settings::Instance()->MAX_HEIGHT.
@@ -336,7 +456,7 @@ namespace openshot {
 		/// This is primarily designed to keep the timeline (and its child objects... such as clips and effects) in sync
 		/// with another application... such as OpenShot Video Editor (http://www.openshot.org).
 		/// @param value A JSON string containing a key, value, and type of change.
-		void ApplyJsonDiff(std::string value);
+		void ApplyJsonDiff(const std::string& value);
 
 		/// Open the reader (and start consuming resources)
 		void Open() override;
@@ -11,12 +11,15 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
 #include "TrackedObjectBBox.h"
 
 #include "Clip.h"
 
+#include "ProtobufFrameFile.h"
 #include "trackerdata.pb.h"
 #include <google/protobuf/util/time_util.h>
 
@@ -67,6 +70,7 @@ void TrackedObjectBBox::AddBox(int64_t _frame_num, float _cx, float _cy, float _
 		// There isn't a bounding-box indexed by the time of given frame, insert a new one
 		BoxVec.insert({time, newBBox});
 	}
+	InvalidateTimeline();
 }
 
 // Get the size of BoxVec map
@@ -84,13 +88,9 @@ bool TrackedObjectBBox::Contains(int64_t frame_num) const
 {
 	// Get the time of given frame
 	double time = this->FrameNToTime(frame_num, 1.0);
-	// Create an iterator that points to the BoxVec pair indexed by the time of given frame (or the closest time)
-	auto it = BoxVec.lower_bound(time);
-	if (it == BoxVec.end()){
-		// BoxVec pair not found
-		return false;
-	}
-	return true;
+	// There is a BoxVec pair indexed by the time of given frame (or the closest upper time)
+	// unless it's after the last one
+	return !BoxVec.empty() && time <= BoxVec.rbegin()->first;
 }
 
 // Check if there is a bounding-box in the exact frame number
@@ -118,65 +118,119 @@ void TrackedObjectBBox::RemoveBox(int64_t frame_number)
 	{
 		// The BoxVec pair exists, so remove it
 		BoxVec.erase(time);
+		InvalidateTimeline();
 	}
 	return;
 }
 
-// Return a bounding-box from BoxVec with it's properties adjusted by the Keyframes
-BBox TrackedObjectBBox::GetBox(int64_t frame_number)
+// Get the BBox at a given time from BoxVec, without the Keyframes adjustments
+bool TrackedObjectBBox::LookupBox(double time, BBox& box) const
 {
-	// Get the time position of the given frame.
-	double time = this->FrameNToTime(frame_number, this->TimeScale);
-
 	// Return a iterator pointing to the BoxVec pair indexed by time or to the pair indexed
 	// by the closest upper time value.
 	auto currentBBoxIterator = BoxVec.lower_bound(time);
 
-	// Check if there is a pair indexed by time, returns an empty bbox if there isn't.
+	// Check if there is a pair indexed by time
 	if (currentBBoxIterator == BoxVec.end())
-	{
-		// Create and return an empty bounding-box object
-		BBox emptyBBox;
-		return emptyBBox;
-	}
+		return false;
 
 	// Check if the iterator matches a BBox indexed by time or points to the first element of BoxVec
 	if ((currentBBoxIterator->first == time) || (currentBBoxIterator == BoxVec.begin()))
 	{
-		// Get the BBox indexed by time
-		BBox currentBBox = currentBBoxIterator->second;
+		box = currentBBoxIterator->second;
+		return true;
+	}
 
-		// Adjust the BBox properties by the Keyframes values
-		currentBBox.cx += this->delta_x.GetValue(frame_number);
-		currentBBox.cy += this->delta_y.GetValue(frame_number);
-		currentBBox.width *= this->scale_x.GetValue(frame_number);
-		currentBBox.height *= this->scale_y.GetValue(frame_number);
-		currentBBox.angle += this->rotation.GetValue(frame_number);
+	// Interpolate a BBox in the middle of the BBoxes indexed by the closest lower and upper times
+	auto previousBBoxIterator = prev(currentBBoxIterator, 1);
+	box = InterpolateBoxes(previousBBoxIterator->first, currentBBoxIterator->first,
+						   previousBBoxIterator->second, currentBBoxIterator->second, time);
+	return true;
+}
 
-		return currentBBox;
+// Get the dense bounding-box timeline, (re)building it if BoxVec, BaseFps or TimeScale changed
+std::shared_ptr<const TrackedObjectBBox::BoxTimeline> TrackedObjectBBox::GetTimeline() const
+{
+	std::shared_ptr<const BoxTimeline> timeline = std::atomic_load(&boxTimeline);
+	if (timeline && timeline->box_count == BoxVec.size() && timeline->time_scale == TimeScale
+		&& timeline->fps.num == BaseFps.num && timeline->fps.den == BaseFps.den)
+		return timeline;
+
+	double frames_per_time = BaseFps.ToDouble() * TimeScale;
+	if (BoxVec.empty() || !(frames_per_time > 0.0))
+		return nullptr;
+
+	// Frames between the first and the last BBox (frames outside of them are looked up in BoxVec)
+	int64_t first_frame = (int64_t)floor(BoxVec.begin()->first * frames_per_time);
+	int64_t last_frame = (int64_t)floor(BoxVec.rbegin()->first * frames_per_time) + 1;
+	while (last_frame > first_frame && FrameNToTime(last_frame, TimeScale) > BoxVec.rbegin()->first)
+		last_frame--;
+
+	// Don't allocate a dense timeline for a few boxes spread across a very long time
+	size_t length = last_frame - first_frame + 1;
+	if (length > std::max<size_t>(4096, 16 * BoxVec.size()))
+		return nullptr;
+
+	auto built = std::make_shared<BoxTimeline>();
+	built->first_frame = first_frame;
+	built->time_scale = TimeScale;
+	built->fps = BaseFps;
+	built->box_count = BoxVec.size();
+	for (std::vector<float>* values : {&built->cx, &built->cy, &built->width, &built->height, &built->angle})
+		values->reserve(length);
+
+	BBox box;
+	for (size_t i = 0; i < length && LookupBox(FrameNToTime(first_frame + i, TimeScale), box); i++)
+	{
+		built->cx.push_back(box.cx);
+		built->cy.push_back(box.cy);
+		built->width.push_back(box.width);
+		built->height.push_back(box.height);
+		built->angle.push_back(box.angle);
 	}
 
-	// BBox indexed by the closest upper time
-	BBox currentBBox = currentBBoxIterator->second;
-	// BBox indexed by the closet lower time
-	BBox previousBBox = prev(currentBBoxIterator, 1)->second;
+	timeline = built;
+	std::atomic_store(&boxTimeline, timeline);
+	return timeline;
+}
 
-	// Interpolate a BBox in the middle of previousBBox and currentBBox
-	BBox interpolatedBBox = InterpolateBoxes(prev(currentBBoxIterator, 1)->first, currentBBoxIterator->first,
-											 previousBBox, currentBBox, time);
+// Discard the dense bounding-box timeline
+void TrackedObjectBBox::InvalidateTimeline()
+{
+	std::atomic_store(&boxTimeline, std::shared_ptr<const BoxTimeline>());
+}
+
+// Return a bounding-box from BoxVec with it's properties adjusted by the Keyframes
+BBox TrackedObjectBBox::GetBox(int64_t frame_number)
+{
+	BBox currentBBox;
+
+	// Take the (already interpolated) BBox from the dense timeline, when the frame is in it
+	std::shared_ptr<const BoxTimeline> timeline = GetTimeline();
+	if (timeline && frame_number >= timeline->first_frame
+		&& frame_number - timeline->first_frame < (int64_t)timeline->cx.size())
+	{
+		size_t i = frame_number - timeline->first_frame;
+		currentBBox = BBox(timeline->cx[i], timeline->cy[i], timeline->width[i], timeline->height[i], timeline->angle[i]);
+	}
+	else if (!LookupBox(FrameNToTime(frame_number, this->TimeScale), currentBBox))
+	{
+		// There is no BBox at (or after) this frame: return an empty bounding-box
+		return BBox();
+	}
 
 	// Adjust the BBox properties by the Keyframes values
-	interpolatedBBox.cx += this->delta_x.GetValue(frame_number);
-	interpolatedBBox.cy += this->delta_y.GetValue(frame_number);
-	interpolatedBBox.width *= this->scale_x.GetValue(frame_number);
-	interpolatedBBox.height *= this->scale_y.GetValue(frame_number);
-	interpolatedBBox.angle += this->rotation.GetValue(frame_number);
+	currentBBox.cx += this->delta_x.GetValue(frame_number);
+	currentBBox.cy += this->delta_y.GetValue(frame_number);
+	currentBBox.width *= this->scale_x.GetValue(frame_number);
+	currentBBox.height *= this->scale_y.GetValue(frame_number);
+	currentBBox.angle += this->rotation.GetValue(frame_number);
 
-	return interpolatedBBox;
+	return currentBBox;
 }
 
 // Interpolate the bouding-boxes properties
-BBox TrackedObjectBBox::InterpolateBoxes(double t1, double t2, BBox left, BBox right, double target)
+BBox TrackedObjectBBox::InterpolateBoxes(double t1, double t2, BBox left, BBox right, double target) const
 {
 	// Interpolate the x-coordinate of the center point
 	Point cx_left(t1, left.cx, openshot::InterpolationType::LINEAR);
@@ -235,29 +289,14 @@ void TrackedObjectBBox::ScalePoints(double time_scale){
 // Load the bounding-boxes information from the protobuf file
 bool TrackedObjectBBox::LoadBoxData(std::string inputFilePath)
 {
-	using std::ios;
-
-	// Variable to hold the loaded data
+	// Variable to hold the loaded data (frames are read one at a time)
 	pb_tracker::Tracker bboxMessage;
 
-	// Read the existing tracker message.
-	std::fstream input(inputFilePath, ios::in | ios::binary);
-
-	// Check if it was able to read the protobuf data
-	if (!bboxMessage.ParseFromIstream(&input))
-	{
-		std::cerr << "Failed to parse protobuf message." << std::endl;
-		return false;
-	}
-
 	this->clear();
 
-	// Iterate over all frames of the saved message
-	for (size_t i = 0; i < bboxMessage.frame_size(); i++)
+	// Iterate over all frames of the saved data
+	bool loaded = ReadProtobufFrames(inputFilePath, bboxMessage, [this](const pb_tracker::Frame &pbFrameData)
 	{
-		// Get data of the i-th frame
-		const pb_tracker::Frame &pbFrameData = bboxMessage.frame(i);
-
 		// Get frame number
 		size_t frame_number = pbFrameData.id();
 
@@ -276,6 +315,13 @@ bool TrackedObjectBBox::LoadBoxData(std::string inputFilePath)
 			// The bounding-box properties are valid, so add it to the BoxVec map
 			this->AddBox(frame_number, cx, cy, width, height, angle);
 		}
+	});
+
+	// Check if it was able to read the protobuf data
+	if (!loaded)
+	{
+		std::cerr << "Failed to parse protobuf message." << std::endl;
+		return false;
 	}
 
 	// Show the time stamp from the last update in tracker data file
@@ -285,9 +331,6 @@ bool TrackedObjectBBox::LoadBoxData(std::string inputFilePath)
 				  << TimeUtil::ToString(bboxMessage.last_updated()) << std::endl;
 	}
 
-	// Delete all global objects allocated by libprotobuf.
-	google::protobuf::ShutdownProtobufLibrary();
-
 	return true;
 }
 
@@ -295,6 +338,7 @@ bool TrackedObjectBBox::LoadBoxData(std::string inputFilePath)
 void TrackedObjectBBox::clear()
 {
 	BoxVec.clear();
+	InvalidateTimeline();
 }
 
 // Generate JSON string of this object
@@ -355,7 +399,7 @@ void TrackedObjectBBox::SetJson(const std::string value)
 }
 
 // Load Json::Value into this object
-void TrackedObjectBBox::SetJsonValue(const Json::Value root)
+void TrackedObjectBBox::SetJsonValue(const Json::Value& root)
 {
 
 	// Set the Id by the given JSON object
@@ -14,6 +14,9 @@
 #ifndef OPENSHOT_TRACKEDOBJECTBBOX_H
 #define OPENSHOT_TRACKEDOBJECTBBOX_H
 
+#include <memory>
+#include <vector>
+
 #include "TrackedObjectBase.h"
 
 #include "Color.h"
@@ -98,7 +101,7 @@ namespace openshot
 		}
 
 		/// Load Json::Value into this object
-		void SetJsonValue(const Json::Value root)
+		void SetJsonValue(const Json::Value& root)
 		{
 
 			// Set data from Json (if key is found)
@@ -133,8 +136,28 @@ namespace openshot
 		Fraction BaseFps;
 		double TimeScale;
 
+		/// Dense, frame-indexed copy of BoxVec (as a structure of arrays), holding the interpolated
+		/// bounding-box of every frame in [first_frame, first_frame + cx.size())
+		struct BoxTimeline
+		{
+			int64_t first_frame = 0;
+			double time_scale = 1.0;
+			Fraction fps;
+			size_t box_count = 0;
+			std::vector<float> cx, cy, width, height, angle;
+		};
+		/// Built on demand, and shared (read-only) by concurrent GetBox calls
+		mutable std::shared_ptr<const BoxTimeline> boxTimeline;
+
+		/// Get the BBox at a given time from BoxVec (interpolated, without the Keyframes adjustments)
+		bool LookupBox(double time, BBox& box) const;
+		/// Get the dense bounding-box timeline, (re)building it if BoxVec, BaseFps or TimeScale changed
+		std::shared_ptr<const BoxTimeline> GetTimeline() const;
+		/// Discard the dense bounding-box timeline
+		void InvalidateTimeline();
+
 	public:
-		std::map<double, BBox> BoxVec; ///< Index the bounding-box by time of each frame
+		std::map<double, BBox> BoxVec; ///< Index the bounding-box by time of each frame (use AddBox / RemoveBox to modify it)
 		Keyframe delta_x; ///< X-direction displacement Keyframe
 		Keyframe delta_y; ///< Y-direction displacement Keyframe
 		Keyframe scale_x; ///< X-direction scale Keyframe
@@ -191,7 +214,7 @@ namespace openshot
 		double FrameNToTime(int64_t frame_number, double time_scale) const;
 
 		/// Interpolate the bouding-boxes properties
-		BBox InterpolateBoxes(double t1, double t2, BBox left, BBox right, double target);
+		BBox InterpolateBoxes(double t1, double t2, BBox left, BBox right, double target) const;
 
 		/// Clear the BoxVec map
 		void clear();
@@ -200,7 +223,7 @@ namespace openshot
 		std::string Json() const override;				  ///< Generate JSON string of this object
 		Json::Value JsonValue() const override;			 ///< Generate Json::Value for this object
 		void SetJson(const std::string value) override;	 ///< Load JSON string into this object
-		void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+		void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
 		/// Get all properties for a specific frame (perfect for a UI to display the current state
 		/// of all properties at any time)
@@ -81,7 +81,7 @@ namespace openshot {
 		virtual std::string Json() const = 0;				  ///< Generate JSON string of this object
 		virtual Json::Value JsonValue() const = 0;			 ///< Generate Json::Value for this object
 		virtual void SetJson(const std::string value) = 0;	 ///< Load JSON string into this object
-		virtual void SetJsonValue(const Json::Value root) = 0; ///< Load Json::Value into this object
+		virtual void SetJsonValue(const Json::Value& root) = 0; ///< Load Json::Value into this object
 
 		/// Get all properties for a specific frame (perfect for a UI to display the current state
 		/// of all properties at any time)
@@ -201,7 +201,7 @@ void WriterBase::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void WriterBase::SetJsonValue(const Json::Value root) {
+void WriterBase::SetJsonValue(const Json::Value& root) {
 
 	// Set data from Json (if key is found)
 	if (!root["has_video"].isNull())
@@ -154,7 +154,7 @@ void Compressor::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Compressor::SetJsonValue(const Json::Value root) {
+void Compressor::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
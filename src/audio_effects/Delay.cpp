@@ -138,7 +138,7 @@ void Delay::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Delay::SetJsonValue(const Json::Value root) {
+void Delay::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -193,7 +193,7 @@ void Distortion::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Distortion::SetJsonValue(const Json::Value root) {
+void Distortion::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -143,7 +143,7 @@ void Echo::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Echo::SetJsonValue(const Json::Value root) {
+void Echo::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
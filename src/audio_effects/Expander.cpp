@@ -160,7 +160,7 @@ void Expander::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Expander::SetJsonValue(const Json::Value root) {
+void Expander::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
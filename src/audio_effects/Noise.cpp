@@ -101,7 +101,7 @@ void Noise::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Noise::SetJsonValue(const Json::Value root) {
+void Noise::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
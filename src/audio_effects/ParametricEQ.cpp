@@ -210,7 +210,7 @@ void ParametricEQ::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void ParametricEQ::SetJsonValue(const Json::Value root) {
+void ParametricEQ::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -120,7 +120,7 @@ void Robotization::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Robotization::SetJsonValue(const Json::Value root) {
+void Robotization::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
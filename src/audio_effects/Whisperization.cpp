@@ -128,7 +128,7 @@ void Whisperization::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Whisperization::SetJsonValue(const Json::Value root) {
+void Whisperization::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
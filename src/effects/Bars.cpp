@@ -138,7 +138,7 @@ void Bars::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Bars::SetJsonValue(const Json::Value root) {
+void Bars::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
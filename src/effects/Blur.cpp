@@ -191,7 +191,7 @@ void Blur::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Blur::SetJsonValue(const Json::Value root) {
+void Blur::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -130,7 +130,7 @@ void Brightness::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Brightness::SetJsonValue(const Json::Value root) {
+void Brightness::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
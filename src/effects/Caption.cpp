@@ -405,7 +405,7 @@ void Caption::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Caption::SetJsonValue(const Json::Value root) {
+void Caption::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
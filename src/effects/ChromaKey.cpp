@@ -53,6 +53,127 @@ void ChromaKey::init_effect_details()
 	info.has_video = true;
 }
 
+#if USE_BABL
+// Key out the pixels of all rows (in parallel), given the distance to the key color
+// of each pixel in the babl-converted rows
+template <typename Distance>
+static void key_rows(unsigned char *bits, int bytesperline, const unsigned char *converted, int rowwidth,
+					 int width, int height, int threshold, int halothreshold, Distance distance)
+{
+	#pragma omp parallel for
+	for (int y = 0; y < height; ++y)
+	{
+		unsigned char *pixel = bits + y * bytesperline;
+		const unsigned char *row = converted + y * rowwidth;
+
+		for (int x = 0; x < width; ++x, pixel += 4)
+		{
+			float tmp = distance(row, x);
+
+			if (tmp <= threshold)
+			{
+				pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+			}
+			else if (tmp <= threshold + halothreshold)
+			{
+				float alphamult = (tmp - threshold) / halothreshold;
+
+				pixel[0] *= alphamult;
+				pixel[1] *= alphamult;
+				pixel[2] *= alphamult;
+				pixel[3] *= alphamult;
+			}
+		}
+	}
+}
+
+// Tabulate the CIEDE2000 distance to the (CIE Lab u8) key color: the squared
+// lightness term for each L, and the sum of the chroma and hue terms for each a,b
+static void cie_distance_luts(const unsigned char *mask, std::vector<float> &lightness_lut, std::vector<float> &chroma_lut)
+{
+	float KL = 1.0;
+	float KC = 1.0;
+	float KH = 1.0;
+	float pi = 4 * std::atan(1);
+
+	float L1 = ((float) mask[0]) / 2.55;
+	float a1 = mask[1] - 127;
+	float b1 = mask[2] - 127;
+	float C1 = std::sqrt(a1 * a1 + b1 * b1);
+
+	lightness_lut.resize(256);
+	for (int L = 0; L < 256; ++L)
+	{
+		float L2 = ((float) L) / 2.55;
+		float delta_L_prime = L2 - L1;
+		float L_bar = (L1 + L2) / 2;
+		float SL = 1 + 0.015 * std::pow(L_bar - 50, 2) / std::sqrt(20 + std::pow(L_bar - 50, 2));
+		lightness_lut[L] = std::pow(delta_L_prime / KL / SL, 2);
+	}
+
+	chroma_lut.resize(256 * 256);
+	#pragma omp parallel for
+	for (int a = 0; a < 256; ++a)
+	{
+		for (int b = 0; b < 256; ++b)
+		{
+			int   a2 = a - 127;
+			int   b2 = b - 127;
+			float C2 = std::sqrt(a2 * a2 + b2 * b2);
+
+			float C_bar = (C1 + C2) / 2;
+
+			float a_prime_multiplier = 1 + 0.5 * (1 - std::sqrt(C_bar / (C_bar + 25)));
+			float a1_prime = a1 * a_prime_multiplier;
+			float a2_prime = a2 * a_prime_multiplier;
+
+			float C1_prime = std::sqrt(a1_prime * a1_prime + b1 * b1);
+			float C2_prime = std::sqrt(a2_prime * a2_prime + b2 * b2);
+			float C_prime_bar = (C1_prime + C2_prime) / 2;
+			float delta_C_prime = C2_prime - C1_prime;
+
+			float h1_prime = std::atan2(b1, a1_prime) * 180 / pi;
+			float h2_prime = std::atan2(b2, a2_prime) * 180 / pi;
+
+			float delta_h_prime = h2_prime - h1_prime;
+			double H_prime_bar = (C1_prime != 0 && C2_prime != 0) ? (h1_prime + h2_prime) / 2 : (h1_prime + h2_prime);
+
+			if (delta_h_prime < -180)
+			{
+				delta_h_prime += 360;
+				if (H_prime_bar < 180)
+					H_prime_bar += 180;
+				else
+					H_prime_bar -= 180;
+			}
+			else if (delta_h_prime > 180)
+			{
+				delta_h_prime -= 360;
+				if (H_prime_bar < 180)
+					H_prime_bar += 180;
+				else
+					H_prime_bar -= 180;
+			}
+
+			float delta_H_prime = 2 * std::sqrt(C1_prime * C2_prime) * std::sin(delta_h_prime * pi / 360);
+
+			float T = 1
+				- 0.17 * std::cos((H_prime_bar - 30) * pi / 180)
+				+ 0.24 * std::cos(H_prime_bar * pi / 90)
+				+ 0.32 * std::cos((3 * H_prime_bar + 6) * pi / 180)
+				- 0.20 * std::cos((4 * H_prime_bar - 64) * pi / 180);
+
+			float SC = 1 + 0.045 * C_prime_bar;
+			float SH = 1 + 0.015 * C_prime_bar * T;
+			float RT = -2 * std::sqrt(C_prime_bar / (C_prime_bar + 25)) * std::sin(pi / 3 * std::exp(-std::pow((H_prime_bar - 275) / 25, 2)));
+			chroma_lut[(a << 8) | b] = std::pow(delta_C_prime / KC / SC, 2)
+						+ std::pow(delta_h_prime / KH / SH, 2)
+						+ RT * delta_C_prime / KC / SC * delta_H_prime / KH / SH;
+		}
+	}
+}
+#endif
+
 // This method is required for all derived classes of EffectBase, and returns a
 // modified openshot::Frame object
 //
@@ -111,8 +232,6 @@ std::shared_ptr<openshot::Frame> ChromaKey::GetFrame(std::shared_ptr<openshot::F
 	int width = image->width();
 	int height = image->height();
 
-	int pixelcount = width * height;
-
 #if USE_BABL
 	if (method > CHROMAKEY_BASIC && method <= CHROMAKEY_LAST_METHOD)
 	{
@@ -170,11 +289,8 @@ std::shared_ptr<openshot::Frame> ChromaKey::GetFrame(std::shared_ptr<openshot::F
 
 		if (rgb && format && (fish = babl_fish(rgb, format)) != 0)
 		{
-			int		idx = 0;
 			unsigned char	mask_in[4];
 			union { float f[4]; unsigned char u[4]; } mask;
-			float const *pf = (float *) pixelbuf.data();
-			unsigned char const *pc = pixelbuf.data();
 
 			mask_in[0] = mask_R;
 			mask_in[1] = mask_G;
@@ -182,193 +298,74 @@ std::shared_ptr<openshot::Frame> ChromaKey::GetFrame(std::shared_ptr<openshot::F
 			mask_in[3] = 255;
 			babl_process(fish, mask_in, &mask, 1);
 
-			if (0) //image->bytesPerLine() == width * 4)
-			{
-				// Because babl_process is expensive to call, but efficient
-				// with long sequences of pixels, attempt to convert the
-				// entire buffer at once if we can
-				babl_process(fish, image->bits(), pixelbuf.data(), pixelcount);
-			}
-			else
-			{
-				unsigned char *rowdata = pixelbuf.data();
+			// Take the pixel buffer once (scanLine() may detach the image,
+			// which must not happen from several threads)
+			unsigned char *bits = image->bits();
+			int bytesperline = image->bytesPerLine();
+			unsigned char *converted = pixelbuf.data();
 
-				for (int y = 0; y < height; ++y, rowdata += rowwidth)
-					babl_process(fish, image->scanLine(y), rowdata, width);
-			}
+			// Because babl_process is expensive to call, but efficient with
+			// long sequences of pixels, convert whole rows (in parallel)
+			#pragma omp parallel for
+			for (int y = 0; y < height; ++y)
+				babl_process(fish, bits + y * bytesperline, converted + y * rowwidth, width);
 
 			switch(method)
 			{
 			case CHROMAKEY_HSVL_H:
-				for (int y = 0; y < height; ++y)
-				{
-					unsigned char *pixel = image->scanLine(y);
-
-					for (int x = 0; x < width; ++x, pixel += 4, pf += 3)
-					{
-						float tmp = fabs(pf[0] - mask.f[0]);
+				key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, halothreshold,
+					[&](const unsigned char *row, int x) {
+						float tmp = fabs(((const float *) row)[3 * x] - mask.f[0]);
 
 						if (tmp > 0.5)
 							tmp = 1.0 - tmp;
-						tmp *= 500;
-						if (tmp <= threshold)
-						{
-							pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-						}
-						else if (tmp <= threshold + halothreshold)
-						{
-							float alphamult = (tmp - threshold) / halothreshold;
-
-							pixel[0] *= alphamult;
-							pixel[1] *= alphamult;
-							pixel[2] *= alphamult;
-							pixel[3] *= alphamult;
-						}
-					}
-				}
+						return tmp * 500;
+					});
 				break;
 
 			case CHROMAKEY_HSV_S:
 			case CHROMAKEY_HSL_S:
-				for (int y = 0; y < height; ++y)
-				{
-					unsigned char *pixel = image->scanLine(y);
-
-					for (int x = 0; x < width; ++x, pixel += 4, pf += 3)
-					{
-						float tmp = fabs(pf[1] - mask.f[1]) * 255;
-
-						if (tmp <= threshold)
-						{
-							pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-						}
-						else if (tmp <= threshold + halothreshold)
-						{
-							float alphamult = (tmp - threshold) / halothreshold;
-
-							pixel[0] *= alphamult;
-							pixel[1] *= alphamult;
-							pixel[2] *= alphamult;
-							pixel[3] *= alphamult;
-						}
-					}
-				}
+				key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, halothreshold,
+					[&](const unsigned char *row, int x) {
+						return fabs(((const float *) row)[3 * x + 1] - mask.f[1]) * 255;
+					});
 				break;
 
 			case CHROMAKEY_HSV_V:
 			case CHROMAKEY_HSL_L:
-				for (int y = 0; y < height; ++y)
-				{
-					unsigned char *pixel = image->scanLine(y);
-
-					for (int x = 0; x < width; ++x, pixel += 4, pf += 3)
-					{
-						float tmp = fabs(pf[2] - mask.f[2]) * 255;
-
-						if (tmp <= threshold)
-						{
-							pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-						}
-						else if (tmp <= threshold + halothreshold)
-						{
-							float alphamult = (tmp - threshold) / halothreshold;
-
-							pixel[0] *= alphamult;
-							pixel[1] *= alphamult;
-							pixel[2] *= alphamult;
-							pixel[3] *= alphamult;
-						}
-					}
-				}
+				key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, halothreshold,
+					[&](const unsigned char *row, int x) {
+						return fabs(((const float *) row)[3 * x + 2] - mask.f[2]) * 255;
+					});
 				break;
 
 			case CHROMAKEY_YCBCR:
-				for (int y = 0; y < height; ++y)
-				{
-					unsigned char *pixel = image->scanLine(y);
-
-					for (int x = 0; x < width; ++x, pixel += 4, pc += 3)
-					{
-						int db = (int) pc[1] - mask.u[1];
-						int dr = (int) pc[2] - mask.u[2];
-						float tmp = sqrt(db * db + dr * dr);
-
-						if (tmp <= threshold)
-						{
-							pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-						}
-						else if (tmp <= threshold + halothreshold)
-						{
-							float alphamult = (tmp - threshold) / halothreshold;
-
-							pixel[0] *= alphamult;
-							pixel[1] *= alphamult;
-							pixel[2] *= alphamult;
-							pixel[3] *= alphamult;
-						}
-					}
-				}
+				key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, halothreshold,
+					[&](const unsigned char *row, int x) {
+						int db = (int) row[3 * x + 1] - mask.u[1];
+						int dr = (int) row[3 * x + 2] - mask.u[2];
+						return (float) sqrt(db * db + dr * dr);
+					});
 				break;
 
 			case CHROMAKEY_CIE_LCH_L:
-				for (int y = 0; y < height; ++y)
-				{
-					unsigned char *pixel = image->scanLine(y);
-
-					for (int x = 0; x < width; ++x, pixel += 4, pf += 3)
-					{
-						float tmp = fabs(pf[0] - mask.f[0]);
-
-						if (tmp <= threshold)
-						{
-							pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-						}
-						else if (tmp <= threshold + halothreshold)
-						{
-							float alphamult = (tmp - threshold) / halothreshold;
-
-							pixel[0] *= alphamult;
-							pixel[1] *= alphamult;
-							pixel[2] *= alphamult;
-							pixel[3] *= alphamult;
-						}
-					}
-				}
+				key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, halothreshold,
+					[&](const unsigned char *row, int x) {
+						return fabs(((const float *) row)[3 * x] - mask.f[0]);
+					});
 				break;
 
 			case CHROMAKEY_CIE_LCH_C:
-				for (int y = 0; y < height; ++y)
-				{
-					unsigned char *pixel = image->scanLine(y);
-
-					for (int x = 0; x < width; ++x, pixel += 4, pf += 3)
-					{
-						float tmp = fabs(pf[1] - mask.f[1]);
-
-						if (tmp <= threshold)
-						{
-							pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-						}
-						else if (tmp <= threshold + halothreshold)
-						{
-							float alphamult = (tmp - threshold) / halothreshold;
-
-							pixel[0] *= alphamult;
-							pixel[1] *= alphamult;
-							pixel[2] *= alphamult;
-							pixel[3] *= alphamult;
-						}
-					}
-				}
+				key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, halothreshold,
+					[&](const unsigned char *row, int x) {
+						return fabs(((const float *) row)[3 * x + 1] - mask.f[1]);
+					});
 				break;
 
 			case CHROMAKEY_CIE_LCH_H:
-				for (int y = 0; y < height; ++y)
-				{
-					unsigned char *pixel = image->scanLine(y);
-
-					for (int x = 0; x < width; ++x, pixel += 4, pf += 3)
-					{
+				// No halo for hues
+				key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, 0,
+					[&](const unsigned char *row, int x) {
 						// Hues in LCH(ab) are an angle on a color wheel.
 						// We are tring to find the angular distance
 						// between the two angles. It can never be more
@@ -376,108 +373,34 @@ std::shared_ptr<openshot::Frame> ChromaKey::GetFrame(std::shared_ptr<openshot::F
 						// angle that can be calculated by going in the
 						// other diretion, which  can be found by
 						// subtracting the angle we have from 360.
-						float tmp = fabs(pf[2] - mask.f[2]);
+						float tmp = fabs(((const float *) row)[3 * x + 2] - mask.f[2]);
 
 						if (tmp > 180.0)
 							tmp = 360.0 - tmp;
-						if (tmp <= threshold)
-							pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-					}
-				}
+						return tmp;
+					});
 				break;
 
 			case CHROMAKEY_CIE_DISTANCE:
 				{
-					float KL = 1.0;
-					float KC = 1.0;
-					float KH = 1.0;
-					float pi = 4 * std::atan(1);
-
-					float L1 = ((float) mask.u[0]) / 2.55;
-					float a1 = mask.u[1] - 127;
-					float b1 = mask.u[2] - 127;
-					float C1 = std::sqrt(a1 * a1 + b1 * b1);
-
-					for (int y = 0; y < height; ++y)
-					{
-						unsigned char *pixel = image->scanLine(y);
-
-						for (int x = 0; x < width; ++x, pixel += 4, pc += 3)
-						{
-							float L2 = ((float) pc[0]) / 2.55;
-							int   a2 = pc[1] - 127;
-							int   b2 = pc[2] - 127;
-							float C2 = std::sqrt(a2 * a2 + b2 * b2);
-
-							float delta_L_prime = L2 - L1;
-							float L_bar = (L1 + L2) / 2;
-							float C_bar = (C1 + C2) / 2;
-
-							float a_prime_multiplier = 1 + 0.5 * (1 - std::sqrt(C_bar / (C_bar + 25)));
-							float a1_prime = a1 * a_prime_multiplier;
-							float a2_prime = a2 * a_prime_multiplier;
-
-							float C1_prime = std::sqrt(a1_prime * a1_prime + b1 * b1);
-							float C2_prime = std::sqrt(a2_prime * a2_prime + b2 * b2);
-							float C_prime_bar = (C1_prime + C2_prime) / 2;
-							float delta_C_prime = C2_prime - C1_prime;
-
-							float h1_prime = std::atan2(b1, a1_prime) * 180 / pi;
-							float h2_prime = std::atan2(b2, a2_prime) * 180 / pi;
-
-							float delta_h_prime = h2_prime - h1_prime;
-							double H_prime_bar = (C1_prime != 0 && C2_prime != 0) ? (h1_prime + h2_prime) / 2 : (h1_prime + h2_prime);
-
-							if (delta_h_prime < -180)
-							{
-								delta_h_prime += 360;
-								if (H_prime_bar < 180)
-									H_prime_bar += 180;
-								else
-									H_prime_bar -= 180;
-							}
-							else if (delta_h_prime > 180)
-							{
-								delta_h_prime -= 360;
-								if (H_prime_bar < 180)
-									H_prime_bar += 180;
-								else
-									H_prime_bar -= 180;
-							}
-
-							float delta_H_prime = 2 * std::sqrt(C1_prime * C2_prime) * std::sin(delta_h_prime * pi / 360);
-
-							float T = 1
-								- 0.17 * std::cos((H_prime_bar - 30) * pi / 180)
-								+ 0.24 * std::cos(H_prime_bar * pi / 90)
-								+ 0.32 * std::cos((3 * H_prime_bar + 6) * pi / 180)
-								- 0.20 * std::cos((4 * H_prime_bar - 64) * pi / 180);
-
-							float SL = 1 + 0.015 * std::pow(L_bar - 50, 2) / std::sqrt(20 + std::pow(L_bar - 50, 2));
-							float SC = 1 + 0.045 * C_prime_bar;
-							float SH = 1 + 0.015 * C_prime_bar * T;
-							float RT = -2 * std::sqrt(C_prime_bar / (C_prime_bar + 25)) * std::sin(pi / 3 * std::exp(-std::pow((H_prime_bar - 275) / 25, 2)));
-							float delta_E = std::sqrt(std::pow(delta_L_prime / KL / SL, 2)
-										+ std::pow(delta_C_prime / KC / SC, 2)
-										+ std::pow(delta_h_prime / KH / SH, 2)
-										+ RT * delta_C_prime / KC / SC * delta_H_prime / KH / SH);
-							if (delta_E <= threshold)
-							{
-								pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-							}
-							else if (delta_E <= threshold + halothreshold)
-							{
-								float alphamult = (delta_E - threshold) / halothreshold;
-
-								pixel[0] *= alphamult;
-								pixel[1] *= alphamult;
-								pixel[2] *= alphamult;
-								pixel[3] *= alphamult;
-							}
-						}
-					}
+					// The CIEDE2000 distance splits into a term that only depends on the
+					// pixel's lightness, and one that only depends on its a,b chroma. Both
+					// are tabulated for every (8 bit) Lab value, so each pixel costs two
+					// lookups and a square root instead of the whole formula.
+					std::vector<float> lightness_lut;
+					std::vector<float> chroma_lut;
+					cie_distance_luts(mask.u, lightness_lut, chroma_lut);
+
+					key_rows(bits, bytesperline, converted, rowwidth, width, height, threshold, halothreshold,
+						[&](const unsigned char *row, int x) {
+							const unsigned char *pc = row + 3 * x;
+							return std::sqrt(lightness_lut[pc[0]] + chroma_lut[(pc[1] << 8) | pc[2]]);
+						});
 				}
 				break;
+
+			case CHROMAKEY_BASIC:
+				break;
 			}
 
 			return frame;
@@ -485,10 +408,14 @@ std::shared_ptr<openshot::Frame> ChromaKey::GetFrame(std::shared_ptr<openshot::F
 	}
 #endif
 
+	unsigned char *bits = image->bits();
+	int bytesperline = image->bytesPerLine();
+
 	// Loop through pixels
+	#pragma omp parallel for
 	for (int y = 0; y < height; ++y)
 	{
-		unsigned char * pixel = image->scanLine(y);
+		unsigned char * pixel = bits + y * bytesperline;
 
 		for (int x = 0; x < width; ++x, pixel += 4)
 		{
@@ -553,7 +480,7 @@ void ChromaKey::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void ChromaKey::SetJsonValue(const Json::Value root) {
+void ChromaKey::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -218,7 +218,7 @@ void ColorShift::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void ColorShift::SetJsonValue(const Json::Value root) {
+void ColorShift::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
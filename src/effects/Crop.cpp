@@ -158,7 +158,7 @@ void Crop::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Crop::SetJsonValue(const Json::Value root) {
+void Crop::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -117,7 +117,7 @@ void Deinterlace::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Deinterlace::SetJsonValue(const Json::Value root) {
+void Deinterlace::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
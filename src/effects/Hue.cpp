@@ -130,7 +130,7 @@ void Hue::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Hue::SetJsonValue(const Json::Value root) {
+void Hue::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
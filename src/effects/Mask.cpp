@@ -220,7 +220,7 @@ void Mask::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Mask::SetJsonValue(const Json::Value root) {
+void Mask::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -76,7 +76,7 @@ void Negate::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Negate::SetJsonValue(const Json::Value root) {
+void Negate::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
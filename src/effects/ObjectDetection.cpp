@@ -18,6 +18,7 @@
 #include "effects/Tracker.h"
 #include "Exceptions.h"
 #include "Timeline.h"
+#include "ProtobufFrameFile.h"
 #include "objdetectdata.pb.h"
 
 #include <QImage>
@@ -83,11 +84,11 @@ std::shared_ptr<Frame> ObjectDetection::GetFrame(std::shared_ptr<Frame> frame, i
 	std::vector<std::shared_ptr<QImage>> childClipImages;
 
 	// Check if track data exists for the requested frame
-	if (detectionsData.find(frame_number) != detectionsData.end()) {
+	DetectionData detections;
+	if (GetDetections(frame_number, detections)) {
 		float fw = cv_image.size().width;
 		float fh = cv_image.size().height;
 
-		DetectionData detections = detectionsData[frame_number];
 		for(int i = 0; i<detections.boxes.size(); i++){
 
 			// Does not show boxes with confidence below the threshold
@@ -276,65 +277,108 @@ void ObjectDetection::drawPred(int classId, float conf, cv::Rect2d box, cv::Mat&
 	}
 }
 
+// Convert the protobuf message of a frame into its detections
+static DetectionData frameDetections(const pb_objdetect::Frame& pbFrameData)
+{
+	// Load bounding box data
+	const google::protobuf::RepeatedPtrField<pb_objdetect::Frame_Box > &pBox = pbFrameData.bounding_box();
+
+	// Construct data vectors related to detections in the current frame
+	std::vector<int> classIds;
+	std::vector<float> confidences;
+	std::vector<cv::Rect_<float>> boxes;
+	std::vector<int> objectIds;
+
+	// Iterate through the detected objects
+	for(int i = 0; i < pbFrameData.bounding_box_size(); i++)
+	{
+		// Create OpenCV rectangle with the bouding box info
+		cv::Rect_<float> box(pBox.Get(i).x(), pBox.Get(i).y(), pBox.Get(i).w(), pBox.Get(i).h());
+
+		// Push back data into vectors
+		boxes.push_back(box);
+		classIds.push_back(pBox.Get(i).classid());
+		confidences.push_back(pBox.Get(i).confidence());
+		objectIds.push_back(pBox.Get(i).objectid());
+	}
+
+	return DetectionData(classIds, confidences, boxes, pbFrameData.id(), objectIds);
+}
+
+// Get the detections of a frame, from the loaded data or from the mapped data file
+bool ObjectDetection::GetDetections(int64_t frame_number, DetectionData& detections) const
+{
+	auto it = detectionsData.find(frame_number);
+	if (it != detectionsData.end()) {
+		detections = it->second;
+		return true;
+	}
+
+	pb_objdetect::Frame pbFrameData;
+	if (!detectionsFile || !detectionsFile->ReadFrame(frame_number, pbFrameData))
+		return false;
+
+	detections = frameDetections(pbFrameData);
+	return true;
+}
+
 // Load protobuf data file
 bool ObjectDetection::LoadObjDetectdData(std::string inputFilePath){
 	// Create tracker message
 	pb_objdetect::ObjDetect objMessage;
 
-	// Read the existing tracker message.
-	std::fstream input(inputFilePath, std::ios::in | std::ios::binary);
-	if (!objMessage.ParseFromIstream(&input)) {
-		std::cerr << "Failed to parse protobuf message." << std::endl;
-		return false;
-	}
-
 	// Make sure classNames, detectionsData and trackedObjects are empty
 	classNames.clear();
 	detectionsData.clear();
 	trackedObjects.clear();
 
-	// Seed to generate same random numbers
-	std::srand(1);
-	// Get all classes names and assign a color to them
-	for(int i = 0; i < objMessage.classnames_size(); i++)
+	// Get all classes names and assign a color to them (the header is read before the frames)
+	auto loadClassNames = [&]()
 	{
-		classNames.push_back(objMessage.classnames(i));
-		classesColor.push_back(cv::Scalar(std::rand()%205 + 50, std::rand()%205 + 50, std::rand()%205 + 50));
+		// Seed to generate same random numbers
+		std::srand(1);
+		for(int i = 0; i < objMessage.classnames_size(); i++)
+		{
+			classNames.push_back(objMessage.classnames(i));
+			classesColor.push_back(cv::Scalar(std::rand()%205 + 50, std::rand()%205 + 50, std::rand()%205 + 50));
+		}
+	};
+	bool classNamesLoaded = false;
+
+	// Frame-indexed files stay mapped: detections are parsed again when their frame is rendered
+	auto mappedData = std::make_shared<ProtobufFrameReader>();
+	bool indexed = false;
+	try {
+		indexed = mappedData->Open(inputFilePath);
+	} catch (const InvalidFile& e) {
+		std::cerr << "Failed to parse protobuf message." << std::endl;
+		return false;
 	}
 
-	// Iterate over all frames of the saved message
-	for (size_t i = 0; i < objMessage.frame_size(); i++)
+	// Iterate over all frames of the saved data (tracked objects need all of their boxes)
+	bool loaded = ReadProtobufFrames(inputFilePath, objMessage, [&](const pb_objdetect::Frame& pbFrameData)
 	{
-		// Create protobuf message reader
-		const pb_objdetect::Frame& pbFrameData = objMessage.frame(i);
+		if (!classNamesLoaded) {
+			loadClassNames();
+			classNamesLoaded = true;
+		}
 
 		// Get frame Id
 		size_t id = pbFrameData.id();
 
-		// Load bounding box data
-		const google::protobuf::RepeatedPtrField<pb_objdetect::Frame_Box > &pBox = pbFrameData.bounding_box();
-
-		// Construct data vectors related to detections in the current frame
-		std::vector<int> classIds;
-		std::vector<float> confidences;
-		std::vector<cv::Rect_<float>> boxes;
-		std::vector<int> objectIds;
+		DetectionData detections = frameDetections(pbFrameData);
 
 		// Iterate through the detected objects
-		for(int i = 0; i < pbFrameData.bounding_box_size(); i++)
+		for(int i = 0; i < detections.boxes.size(); i++)
 		{
 			// Get bounding box coordinates
-			float x = pBox.Get(i).x();
-			float y = pBox.Get(i).y();
-			float w = pBox.Get(i).w();
-			float h = pBox.Get(i).h();
-			// Get class Id (which will be assign to a class name)
-			int classId = pBox.Get(i).classid();
-			// Get prediction confidence
-			float confidence = pBox.Get(i).confidence();
+			float x = detections.boxes[i].x;
+			float y = detections.boxes[i].y;
+			float w = detections.boxes[i].width;
+			float h = detections.boxes[i].height;
 
 			// Get the object Id
-			int objectId = pBox.Get(i).objectid();
+			int objectId = detections.objectIds[i];
 
 			// Search for the object id on trackedObjects map
 			auto trackedObject = trackedObjects.find(objectId);
@@ -347,6 +391,7 @@ bool ObjectDetection::LoadObjDetectdData(std::string inputFilePath){
 			else
 			{
 				// There is no tracked object with that id, so insert a new one
+				int classId = detections.classIds[i];
 				TrackedObjectBBox trackedObj((int)classesColor[classId](0), (int)classesColor[classId](1), (int)classesColor[classId](2), (int)0);
 				trackedObj.AddBox(id, x+(w/2), y+(h/2), w, h, 0.0);
 
@@ -359,23 +404,21 @@ bool ObjectDetection::LoadObjDetectdData(std::string inputFilePath){
 				trackedObjPtr->Id(std::to_string(objectId));
 				trackedObjects.insert({objectId, trackedObjPtr});
 			}
-
-			// Create OpenCV rectangle with the bouding box info
-			cv::Rect_<float> box(x, y, w, h);
-
-			// Push back data into vectors
-			boxes.push_back(box);
-			classIds.push_back(classId);
-			confidences.push_back(confidence);
-			objectIds.push_back(objectId);
 		}
 
 		// Assign data to object detector map
-		detectionsData[id] = DetectionData(classIds, confidences, boxes, id, objectIds);
+		if (!indexed)
+			detectionsData[id] = detections;
+	});
+	if (!loaded) {
+		std::cerr << "Failed to parse protobuf message." << std::endl;
+		return false;
 	}
 
-	// Delete all global objects allocated by libprotobuf.
-	google::protobuf::ShutdownProtobufLibrary();
+	if (!classNamesLoaded)
+		loadClassNames();
+
+	detectionsFile = indexed ? mappedData : nullptr;
 
 	return true;
 }
@@ -389,10 +432,10 @@ std::string ObjectDetection::GetVisibleObjects(int64_t frame_number) const{
 	root["visible_objects_id"] = Json::Value(Json::arrayValue);
 
 	// Check if track data exists for the requested frame
-	if (detectionsData.find(frame_number) == detectionsData.end()){
+	DetectionData detections;
+	if (!GetDetections(frame_number, detections)){
 		return root.toStyledString();
 	}
-	DetectionData detections = detectionsData.at(frame_number);
 
 	// Iterate through the tracked objects
 	for(int i = 0; i<detections.boxes.size(); i++){
@@ -474,7 +517,7 @@ void ObjectDetection::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void ObjectDetection::SetJsonValue(const Json::Value root) {
+void ObjectDetection::SetJsonValue(const Json::Value& root) {
 	// Set parent data
 	EffectBase::SetJsonValue(root);
 
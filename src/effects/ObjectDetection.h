@@ -50,6 +50,7 @@ namespace openshot
 {
     // Forward decls
     class Frame;
+    class ProtobufFrameReader;
 
     /**
      * @brief This effect displays all the detected objects on a clip.
@@ -59,6 +60,8 @@ namespace openshot
     private:
         std::string protobuf_data_path;
         std::map<size_t, DetectionData> detectionsData;
+        /// Mapped detection data (when the data file is frame-indexed, detectionsData stays empty)
+        std::shared_ptr<ProtobufFrameReader> detectionsFile;
         std::vector<std::string> classNames;
 
         std::vector<cv::Scalar> classesColor;
@@ -78,6 +81,8 @@ namespace openshot
                         int thickness, bool is_background, bool draw_text);
         /// Draw rotated rectangle with alpha channel
         void DrawRectangleRGBA(cv::Mat &frame_image, cv::RotatedRect box, std::vector<int> color, float alpha, int thickness, bool is_background);
+        /// Get the detections of a frame. Returns false if there's no data for it.
+        bool GetDetections(int64_t frame_number, DetectionData& detections) const;
 
 
     public:
@@ -112,7 +117,7 @@ namespace openshot
         std::string Json() const override; ///< Generate JSON string of this object
         void SetJson(const std::string value) override; ///< Load JSON string into this object
         Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-        void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+        void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
         /// Get all properties for a specific frame (perfect for a UI to display the current state
         /// of all properties at any time)
@@ -130,7 +130,7 @@ void Pixelate::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Pixelate::SetJsonValue(const Json::Value root) {
+void Pixelate::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -187,7 +187,7 @@ void Saturation::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Saturation::SetJsonValue(const Json::Value root) {
+void Saturation::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
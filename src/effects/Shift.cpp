@@ -153,7 +153,7 @@ void Shift::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Shift::SetJsonValue(const Json::Value root) {
+void Shift::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -17,6 +17,7 @@
 
 #include "effects/Stabilizer.h"
 #include "Exceptions.h"
+#include "ProtobufFrameFile.h"
 #include "stabilizedata.pb.h"
 
 #include <google/protobuf/util/time_util.h>
@@ -70,7 +71,8 @@ std::shared_ptr<Frame> Stabilizer::GetFrame(std::shared_ptr<Frame> frame, int64_
 	if(!frame_image.empty()){
 
 		// Check if track data exists for the requested frame
-		if(transformationData.find(frame_number) != transformationData.end()){
+		EffectTransformParam transform;
+		if(GetTransformation(frame_number, transform)){
 
 			float zoom_value = zoom.GetValue(frame_number);
 
@@ -78,13 +80,13 @@ std::shared_ptr<Frame> Stabilizer::GetFrame(std::shared_ptr<Frame> frame, int64_
 			cv::Mat T(2,3,CV_64F);
 
 			// Set rotation matrix values
-			T.at<double>(0,0) = cos(transformationData[frame_number].da);
-			T.at<double>(0,1) = -sin(transformationData[frame_number].da);
-			T.at<double>(1,0) = sin(transformationData[frame_number].da);
-			T.at<double>(1,1) = cos(transformationData[frame_number].da);
+			T.at<double>(0,0) = cos(transform.da);
+			T.at<double>(0,1) = -sin(transform.da);
+			T.at<double>(1,0) = sin(transform.da);
+			T.at<double>(1,1) = cos(transform.da);
 
-			T.at<double>(0,2) = transformationData[frame_number].dx * frame_image.size().width;
-			T.at<double>(1,2) = transformationData[frame_number].dy * frame_image.size().height;
+			T.at<double>(0,2) = transform.dx * frame_image.size().width;
+			T.at<double>(1,2) = transform.dy * frame_image.size().height;
 
 			// Apply rotation matrix to image
 			cv::Mat frame_stabilized;
@@ -102,28 +104,51 @@ std::shared_ptr<Frame> Stabilizer::GetFrame(std::shared_ptr<Frame> frame, int64_
 	return frame;
 }
 
+// Get the transformation of a frame, from the loaded data or from the mapped data file
+bool Stabilizer::GetTransformation(int64_t frame_number, EffectTransformParam& transform) const
+{
+	if(!stabilizedData){
+		auto it = transformationData.find(frame_number);
+		if(it == transformationData.end())
+			return false;
+		transform = it->second;
+		return true;
+	}
+
+	pb_stabilize::Frame pbFrameData;
+	if(!stabilizedData->ReadFrame(frame_number, pbFrameData))
+		return false;
+
+	transform = EffectTransformParam(pbFrameData.dx(), pbFrameData.dy(), pbFrameData.da());
+	return true;
+}
+
 // Load protobuf data file
 bool Stabilizer::LoadStabilizedData(std::string inputFilePath){
-	using std::ios;
-	// Create stabilization message
-	pb_stabilize::Stabilization stabilizationMessage;
+	// Make sure the data maps are empty
+	const std::lock_guard<std::mutex> lock(dataMutex);
+	transformationData.clear();
+	trajectoryData.clear();
 
-	// Read the existing tracker message.
-	std::fstream input(inputFilePath, ios::in | ios::binary);
-	if (!stabilizationMessage.ParseFromIstream(&input)) {
+	// Frame-indexed files are only mapped: frames are parsed when they're rendered
+	auto mappedData = std::make_shared<ProtobufFrameReader>();
+	stabilizedData.reset();
+	try {
+		if(mappedData->Open(inputFilePath)){
+			stabilizedData = mappedData;
+			return true;
+		}
+	} catch (const InvalidFile& e) {
 		std::cerr << "Failed to parse protobuf message." << std::endl;
 		return false;
 	}
 
-	// Make sure the data maps are empty
-	transformationData.clear();
-	trajectoryData.clear();
+	// Create stabilization message
+	pb_stabilize::Stabilization stabilizationMessage;
 
 	// Iterate over all frames of the saved message and assign to the data maps
-	for (size_t i = 0; i < stabilizationMessage.frame_size(); i++) {
-
-		// Create stabilization message
-		const pb_stabilize::Frame& pbFrameData = stabilizationMessage.frame(i);
+	size_t i = 0;
+	bool loaded = ReadProtobufFrames(inputFilePath, stabilizationMessage, [&](const pb_stabilize::Frame& pbFrameData){
 
 		// Load frame number
 		size_t id = pbFrameData.id();
@@ -134,7 +159,7 @@ bool Stabilizer::LoadStabilizedData(std::string inputFilePath){
 		float a = pbFrameData.a();
 
 		// Assign data to trajectory map
-		trajectoryData[i] = EffectCamTrajectory(x,y,a);
+		trajectoryData[i++] = EffectCamTrajectory(x,y,a);
 
 		// Load transformation data
 		float dx = pbFrameData.dx();
@@ -143,14 +168,43 @@ bool Stabilizer::LoadStabilizedData(std::string inputFilePath){
 
 		// Assing data to transformation map
 		transformationData[id] = EffectTransformParam(dx,dy,da);
+	});
+	if (!loaded) {
+		std::cerr << "Failed to parse protobuf message." << std::endl;
+		return false;
 	}
 
-	// Delete all global objects allocated by libprotobuf.
-	google::protobuf::ShutdownProtobufLibrary();
-
 	return true;
 }
 
+// Fill the data maps from a frame-indexed data file (if they aren't filled yet)
+void Stabilizer::load_data_maps(){
+	if(!stabilizedData || !transformationData.empty())
+		return;
+
+	pb_stabilize::Frame pbFrameData;
+	for(size_t i = 0; i < stabilizedData->Count(); i++){
+		if(!stabilizedData->ReadFrameAt(i, pbFrameData))
+			continue;
+		trajectoryData[i] = EffectCamTrajectory(pbFrameData.x(), pbFrameData.y(), pbFrameData.a());
+		transformationData[pbFrameData.id()] = EffectTransformParam(pbFrameData.dx(), pbFrameData.dy(), pbFrameData.da());
+	}
+}
+
+// Get the camera trajectory data of every frame
+const std::map<size_t,EffectCamTrajectory>& Stabilizer::TrajectoryData(){
+	const std::lock_guard<std::mutex> lock(dataMutex);
+	load_data_maps();
+	return trajectoryData;
+}
+
+// Get the transformation data of every frame
+const std::map<size_t,EffectTransformParam>& Stabilizer::TransformationData(){
+	const std::lock_guard<std::mutex> lock(dataMutex);
+	load_data_maps();
+	return transformationData;
+}
+
 
 
 // Generate JSON string of this object
@@ -191,7 +245,7 @@ void Stabilizer::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Stabilizer::SetJsonValue(const Json::Value root) {
+void Stabilizer::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
@@ -16,7 +16,9 @@
 
 #include "EffectBase.h"
 
+#include <map>
 #include <memory>
+#include <mutex>
 
 #include "Json.h"
 #include "KeyFrame.h"
@@ -56,6 +58,7 @@ namespace openshot
 {
     // Forwward decls
     class Frame;
+    class ProtobufFrameReader;
 
     /**
      * @brief This class stabilizes a video clip to remove undesired shaking and jitter.
@@ -70,11 +73,20 @@ namespace openshot
         void init_effect_details();
         std::string protobuf_data_path;
         Keyframe zoom;
+        /// Mapped stabilization data (when the data file is frame-indexed, frames are read from it when rendered)
+        std::shared_ptr<ProtobufFrameReader> stabilizedData;
+        std::map <size_t,EffectCamTrajectory> trajectoryData; // Save camera trajectory data
+        std::map <size_t,EffectTransformParam> transformationData; // Save transormation data
+        std::mutex dataMutex;
+
+        /// Get the transformation of a frame. Returns false if there's no data for it.
+        bool GetTransformation(int64_t frame_number, EffectTransformParam& transform) const;
+
+        /// Fill the data maps from a frame-indexed data file (if they aren't filled yet)
+        void load_data_maps();
 
     public:
         std::string teste;
-        std::map <size_t,EffectCamTrajectory> trajectoryData; // Save camera trajectory data
-        std::map <size_t,EffectTransformParam> transformationData; // Save transormation data
 
         Stabilizer();
 
@@ -98,11 +110,17 @@ namespace openshot
         /// Load protobuf data file
         bool LoadStabilizedData(std::string inputFilePath);
 
+        /// Get the camera trajectory data of every frame
+        const std::map<size_t,EffectCamTrajectory>& TrajectoryData();
+
+        /// Get the transformation data of every frame
+        const std::map<size_t,EffectTransformParam>& TransformationData();
+
         // Get and Set JSON methods
         std::string Json() const override; ///< Generate JSON string of this object
         void SetJson(const std::string value) override; ///< Load JSON string into this object
         Json::Value JsonValue() const override; ///< Generate Json::Value for this object
-        void SetJsonValue(const Json::Value root) override; ///< Load Json::Value into this object
+        void SetJsonValue(const Json::Value& root) override; ///< Load Json::Value into this object
 
         /// Get all properties for a specific frame (perfect for a UI to display the current state
         /// of all properties at any time)
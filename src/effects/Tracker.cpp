@@ -282,7 +282,7 @@ void Tracker::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Tracker::SetJsonValue(const Json::Value root) {
+void Tracker::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
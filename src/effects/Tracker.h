@@ -82,7 +82,7 @@ namespace openshot
         /// Generate Json::Value for this object
         Json::Value JsonValue() const override;
         /// Load Json::Value into this object
-        void SetJsonValue(const Json::Value root) override;
+        void SetJsonValue(const Json::Value& root) override;
 
         /// Get all properties for a specific frame
         ///
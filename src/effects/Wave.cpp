@@ -132,7 +132,7 @@ void Wave::SetJson(const std::string value) {
 }
 
 // Load Json::Value into this object
-void Wave::SetJsonValue(const Json::Value root) {
+void Wave::SetJsonValue(const Json::Value& root) {
 
 	// Set parent data
 	EffectBase::SetJsonValue(root);
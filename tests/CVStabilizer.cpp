@@ -20,6 +20,7 @@
 #include "Clip.h"
 #include "CVStabilization.h"  // for TransformParam, CamTrajectory, CVStabilization
 #include "ProcessingController.h"
+#include "effects/Stabilizer.h"
 
 using namespace openshot;
 
@@ -116,4 +117,12 @@ TEST_CASE( "SaveLoad_Protobuf", "[libopenshot][opencv][stabilizer]" )
     CHECK((int) (ct_1.x * 10000) == (int) (ct_2.x * 10000));
     CHECK((int) (ct_1.y * 10000) == (int) (ct_2.y * 10000));
     CHECK((int) (ct_1.a * 10000) == (int) (ct_2.a * 10000));
+
+    // The effect reads the same data (from the frame-indexed file)
+    openshot::Stabilizer effect("stabilizer.data");
+    const auto& transformations = effect.TransformationData();
+    REQUIRE(transformations.count(20) == 1);
+    CHECK((int) (tp_1.dx * 10000) == (int) (transformations.at(20).dx * 10000));
+    CHECK((int) (tp_1.da * 10000) == (int) (transformations.at(20).da * 10000));
+    CHECK(effect.TrajectoryData().size() == transformations.size());
 }
@@ -10,7 +10,10 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 #include <QDir>
 
 #include "openshot_catch.h"
@@ -332,3 +335,78 @@ TEST_CASE( "JSON", "[libopenshot][cachememory]" )
 	CHECK(c.JsonValue()["version"].asString() == "5");
 
 }
+
+TEST_CASE( "concurrent Add and GetFrame", "[libopenshot][cachememory]" )
+{
+	// Frames with images
+	auto new_frame = [](int64_t number) {
+		auto f = std::make_shared<Frame>(number, 64, 48, "#000000");
+		f->AddColor(64, 48, "#000000");
+		return f;
+	};
+
+	// Create cache object (with room for about 40 frames)
+	auto frame_bytes = new_frame(1)->GetBytes();
+	REQUIRE(frame_bytes > 0);
+	CacheMemory c(frame_bytes * 40);
+
+	// Add and read frames from several threads
+	std::atomic<int> wrong_frames(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&c, &wrong_frames, &new_frame, t]() {
+			for (int i = 1; i <= 200; i++) {
+				int64_t number = t * 200 + i;
+				c.Add(new_frame(number));
+				auto f = c.GetFrame(number - 1);
+				if (f && f->number != number - 1)
+					wrong_frames++;
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK(wrong_frames == 0);
+
+	// The byte budget is still enforced
+	CHECK(c.Count() >= 20);
+	CHECK(c.Count() <= 40);
+	CHECK(c.GetBytes() == frame_bytes * c.Count());
+	CHECK(c.GetFrames().size() == (size_t)c.Count());
+
+	c.Clear();
+	CHECK(c.Count() == 0);
+	CHECK(c.GetBytes() == 0);
+}
+
+TEST_CASE( "re-added Frames are measured again", "[libopenshot][cachememory]" )
+{
+	// Size of a frame without an image, and with one
+	auto f = std::make_shared<Frame>(1, 320, 240, "#000000");
+	int64_t blank_bytes = f->GetBytes();
+	f->AddColor(320, 240, "#000000");
+	int64_t frame_bytes = f->GetBytes();
+	REQUIRE(frame_bytes > blank_bytes);
+
+	// Decoders add frames before their images
+	CacheMemory c(frame_bytes * 30);
+	std::vector<std::shared_ptr<Frame>> frames;
+	for (int i = 1; i <= 50; i++) {
+		frames.push_back(std::make_shared<Frame>(i, 320, 240, "#000000"));
+		c.Add(frames.back());
+	}
+	CHECK(c.Count() == 50);
+	CHECK(c.GetBytes() == blank_bytes * 50);
+
+	// Adding the frames again (with images) counts their images, and evicts the oldest frames
+	for (auto& frame : frames) {
+		frame->AddColor(320, 240, "#000000");
+		c.Add(frame);
+	}
+	CHECK(c.Count() >= 20);
+	CHECK(c.Count() <= 30);
+	CHECK(c.GetBytes() == frame_bytes * c.Count());
+	CHECK_FALSE(c.Contains(1));
+	CHECK(c.Contains(50));
+}
@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @brief Unit tests for openshot::ChunkWriter
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <string>
+
+#include <QDir>
+#include <QFile>
+
+#include "openshot_catch.h"
+
+#include "ChunkWriter.h"
+#include "DummyReader.h"
+#include "Exceptions.h"
+#include "FFmpegReader.h"
+#include "Fraction.h"
+
+using namespace openshot;
+
+TEST_CASE( "Write renditions", "[libopenshot][chunkwriter]" )
+{
+	QDir folder(QDir::tempPath() + "/chunk-writer-renditions");
+	folder.removeRecursively();
+
+	DummyReader r(Fraction(24, 1), 320, 240, 44100, 2, 5.0);
+	ChunkWriter w(folder.path().toStdString(), &r);
+	w.SetChunkSize(24);
+	w.Open();
+	w.WriteFrame(&r, 1, 48);
+	w.Close();
+
+	// 2 chunks, each in the final, preview (1/2 size) and thumb (1/4 size) renditions
+	const char* renditions[] = {"final", "preview", "thumb"};
+	for (int i = 0; i < 3; i++) {
+		for (const char* chunk : {"000001.webm", "000002.webm"}) {
+			QString chunk_path = folder.filePath(QString(renditions[i]) + "/" + chunk);
+			REQUIRE(QFile::exists(chunk_path));
+
+			FFmpegReader chunk_reader(chunk_path.toStdString());
+			CHECK(chunk_reader.info.has_video);
+			CHECK(chunk_reader.info.has_audio);
+			CHECK(chunk_reader.info.width == 320 >> i);
+			CHECK(chunk_reader.info.height == 240 >> i);
+		}
+		CHECK_FALSE(QFile::exists(folder.filePath(QString(renditions[i]) + "/000003.webm")));
+	}
+
+	// Thumbnail of the first frame of each chunk
+	CHECK(QFile::exists(folder.filePath("000001.jpeg")));
+	CHECK(QFile::exists(folder.filePath("000002.jpeg")));
+
+	folder.removeRecursively();
+}
+
+TEST_CASE( "Encoder errors", "[libopenshot][chunkwriter]" )
+{
+	QDir folder(QDir::tempPath() + "/chunk-writer-errors");
+	folder.removeRecursively();
+	folder.mkpath(".");
+
+	// A file in place of the "final" folder, so its chunks can't be written
+	QFile blocker(folder.filePath("final"));
+	REQUIRE(blocker.open(QIODevice::WriteOnly));
+	blocker.close();
+
+	DummyReader r(Fraction(24, 1), 320, 240, 44100, 2, 5.0);
+	ChunkWriter w(folder.path().toStdString(), &r);
+	w.SetChunkSize(24);
+	w.Open();
+
+	// The encoder's error is rethrown (by a later WriteFrame, or by Close)
+	try {
+		w.WriteFrame(&r, 1, 10);
+	} catch (const InvalidFile& e) {
+	}
+	CHECK_THROWS_AS(w.Close(), InvalidFile);
+	CHECK_FALSE(w.IsOpen());
+
+	// The other renditions were still written
+	CHECK(QFile::exists(folder.filePath("preview/000001.webm")));
+
+	folder.removeRecursively();
+}
@@ -29,6 +29,7 @@
 #include "FrameMapper.h"
 #include "Timeline.h"
 #include "Json.h"
+#include "Settings.h"
 #include "effects/Negate.h"
 
 using namespace openshot;
@@ -243,6 +244,198 @@ TEST_CASE( "verify parent Timeline", "[libopenshot][clip]" )
 	CHECK(360 == c1.GetFrame(1)->GetImage()->height());
 }
 
+TEST_CASE( "final image size", "[libopenshot][clip]" )
+{
+	Timeline t1(640, 480, Fraction(30,1), 44100, 2, LAYOUT_STEREO);
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "sintel_trailer-720p.mp4";
+	Settings::Instance()->SHARE_MEDIA_SOURCES = false;
+	Clip c1(path.str());
+	Settings::Instance()->SHARE_MEDIA_SOURCES = true;
+	c1.scale_x = Keyframe(0.5);
+	c1.scale_y = Keyframe(0.5);
+	c1.Open();
+
+	// No timeline to scale against
+	int width = 0;
+	int height = 0;
+	CHECK_FALSE(c1.FinalImageSize(1280, 720, width, height));
+
+	// Fit to the timeline, then scale by half
+	t1.AddClip(&c1);
+	CHECK(c1.FinalImageSize(1280, 720, width, height));
+	CHECK(width == 320);
+	CHECK(height == 180);
+
+	// The reader decodes straight to that size
+	std::shared_ptr<Frame> f = c1.Reader()->GetFrame(1);
+	CHECK(f->GetImage()->width() == 320);
+	CHECK(f->GetImage()->height() == 180);
+
+	// A shared reader decodes at the largest size its open clips need
+	Clip c2(path.str());
+	c2.scale_x = Keyframe(0.5);
+	c2.scale_y = Keyframe(0.5);
+	t1.AddClip(&c2);
+	c2.Open();
+	CHECK(c2.Reader()->GetFrame(1)->GetImage()->width() == 320);
+
+	// ... so frames cached for a smaller clip are decoded again for a larger one
+	Clip c3(path.str());
+	t1.AddClip(&c3);
+	c3.Open();
+	CHECK(c3.Reader()->GetCache() == c2.Reader()->GetCache());
+	CHECK(c3.Reader()->GetFrame(1)->GetImage()->width() == 640);
+	c3.Close();
+	c2.Close();
+
+	// Animated scale keyframes have no single final size
+	c1.scale_x.AddPoint(100, 1.0);
+	CHECK_FALSE(c1.FinalImageSize(1280, 720, width, height));
+}
+
+TEST_CASE( "final image size changes clear the reader cache", "[libopenshot][clip]" )
+{
+	Timeline t1(640, 480, Fraction(30,1), 44100, 2, LAYOUT_STEREO);
+	t1.AutoMapClips(false);
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "sintel_trailer-720p.mp4";
+	Settings::Instance()->SHARE_MEDIA_SOURCES = false;
+	Clip c1(path.str());
+	Settings::Instance()->SHARE_MEDIA_SOURCES = true;
+	c1.scale_x = Keyframe(0.5);
+	c1.scale_y = Keyframe(0.5);
+	t1.AddClip(&c1);
+	c1.Open();
+
+	CacheBase* cache = c1.Reader()->GetCache();
+	REQUIRE(cache);
+	CHECK(c1.Reader()->GetFrame(1)->GetImage()->width() == 320);
+	CHECK(cache->Count() > 0);
+
+	// Properties which don't change the final size keep the decoded frames
+	Json::Value root;
+	root["alpha"] = Keyframe(0.5).JsonValue();
+	c1.SetJsonValue(root);
+	CHECK(cache->Count() > 0);
+
+	// A new scale clears them (so they aren't scaled up again)
+	root = Json::Value();
+	root["scale_x"] = Keyframe(1.0).JsonValue();
+	root["scale_y"] = Keyframe(1.0).JsonValue();
+	c1.SetJsonValue(root);
+	CHECK(cache->Count() == 0);
+	CHECK(c1.Reader()->GetFrame(1)->GetImage()->width() == 640);
+
+	// Effects need the source image (so adding or removing the first one clears them too)
+	Negate negate;
+	c1.AddEffect(&negate);
+	CHECK(cache->Count() == 0);
+	CHECK(c1.Reader()->GetFrame(1)->GetImage()->width() == 1280);
+	c1.RemoveEffect(&negate);
+	CHECK(cache->Count() == 0);
+	CHECK(c1.Reader()->GetFrame(1)->GetImage()->width() == 640);
+	c1.Close();
+}
+
+TEST_CASE( "shared media source", "[libopenshot][clip]" )
+{
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "sintel_trailer-720p.mp4";
+	Clip c1(path.str());
+	Clip c2(path.str());
+	Clip c3;
+	c3.SetJsonValue(c1.JsonValue());
+
+	// Each clip has its own reader, decoding from one shared reader (and cache)
+	CHECK(c1.Reader() != c2.Reader());
+	CHECK(c1.Reader()->GetCache() == c2.Reader()->GetCache());
+	CHECK(c1.Reader()->Name() == "FFmpegReader");
+	CHECK(c3.Reader()->JsonValue()["path"].asString() == path.str());
+
+	// Clips created from the reader's JSON share the source of the file
+	CHECK(c3.Reader()->GetCache() == c1.Reader()->GetCache());
+
+	// The shared reader stays open until the last clip closes it
+	c1.Open();
+	c2.Open();
+	c1.Close();
+	CHECK_FALSE(c1.Reader()->IsOpen());
+	CHECK(c2.Reader()->IsOpen());
+	CHECK(c2.GetFrame(10)->number == 10);
+	CHECK_THROWS_AS(c1.Reader()->GetFrame(10), ReaderClosed);
+	c2.Close();
+
+	// Sharing can be disabled
+	Settings::Instance()->SHARE_MEDIA_SOURCES = false;
+	Clip c4(path.str());
+	Settings::Instance()->SHARE_MEDIA_SOURCES = true;
+	CHECK(c4.Reader()->GetCache() != c1.Reader()->GetCache());
+
+	// Or by a timeline, for the clips it loads
+	Timeline t1(640, 480, Fraction(30,1), 44100, 2, LAYOUT_STEREO);
+	t1.ShareMediaSources(false);
+	Clip c5;
+	c5.ParentTimeline(&t1);
+	c5.SetJsonValue(c1.JsonValue());
+	CHECK(c5.Reader()->GetCache() != c1.Reader()->GetCache());
+}
+
+TEST_CASE( "SetJsonValue keeps an unchanged reader", "[libopenshot][clip]" )
+{
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "sintel_trailer-720p.mp4";
+	Clip c1(path.str());
+	c1.Open();
+	ReaderBase* r = c1.Reader();
+
+	// Updating properties (with the same reader JSON) keeps the open reader
+	Json::Value root = c1.JsonValue();
+	root["position"] = 5.0;
+	c1.SetJsonValue(root);
+	CHECK(c1.Reader() == r);
+	CHECK(c1.Reader()->IsOpen());
+	CHECK(c1.Position() == Approx(5.0).margin(0.00001));
+
+	// New reader settings create a new reader
+	std::stringstream path2;
+	path2 << TEST_MEDIA_PATH << "test.mp4";
+	root["reader"]["path"] = path2.str();
+	c1.SetJsonValue(root);
+	CHECK(c1.Reader()->JsonValue()["path"].asString() == path2.str());
+	CHECK(c1.Reader()->IsOpen());
+	c1.Close();
+}
+
+TEST_CASE( "static layer reuse", "[libopenshot][clip]" )
+{
+	Timeline t1(640, 480, Fraction(30,1), 44100, 2, LAYOUT_STEREO);
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "front.png";
+	Clip c1(path.str());
+	c1.location_x = Keyframe(0.1);
+	t1.AddClip(&c1);
+	c1.Open();
+
+	// Constant properties: consecutive frames get the same composited image
+	auto background = std::make_shared<Frame>(1, 640, 480, "#000000");
+	auto f1 = c1.GetFrame(background, 1);
+	background = std::make_shared<Frame>(2, 640, 480, "#000000");
+	auto f2 = c1.GetFrame(background, 2);
+	CHECK(*f1->GetImage() == *f2->GetImage());
+
+	// Changing a property invalidates the reused layer
+	c1.location_x = Keyframe(-0.1);
+	background = std::make_shared<Frame>(3, 640, 480, "#000000");
+	auto f3 = c1.GetFrame(background, 3);
+	CHECK_FALSE(*f1->GetImage() == *f3->GetImage());
+
+	c1.Close();
+}
+
 TEST_CASE( "has_video", "[libopenshot][clip]" )
 {
 	std::stringstream path;
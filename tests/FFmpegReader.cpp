@@ -10,8 +10,13 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
-#include <sstream>
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <sstream>
+#include <vector>
+
+#include <QDir>
 
 #include "openshot_catch.h"
 
@@ -20,9 +25,24 @@
 #include "Frame.h"
 #include "Timeline.h"
 #include "Json.h"
+#include "Settings.h"
 
 using namespace openshot;
 
+// Check that 2 frames have the same image and audio
+static void check_same_frame(std::shared_ptr<Frame> f, std::shared_ptr<Frame> expected)
+{
+	CHECK(f->number == expected->number);
+	CHECK(*f->GetImage() == *expected->GetImage());
+	REQUIRE(f->GetAudioSamplesCount() == expected->GetAudioSamplesCount());
+	REQUIRE(f->GetAudioChannelsCount() == expected->GetAudioChannelsCount());
+	for (int channel = 0; channel < f->GetAudioChannelsCount(); channel++) {
+		const float* samples = f->GetAudioSamples(channel);
+		const float* expected_samples = expected->GetAudioSamples(channel);
+		CHECK(std::equal(samples, samples + f->GetAudioSamplesCount(), expected_samples));
+	}
+}
+
 TEST_CASE( "Invalid_Path", "[libopenshot][ffmpegreader]" )
 {
 	// Check invalid path
@@ -173,6 +193,101 @@ TEST_CASE( "Seek", "[libopenshot][ffmpegreader]" )
 
 }
 
+TEST_CASE( "Seek with keyframe index", "[libopenshot][ffmpegreader]" )
+{
+	QDir index_path = QDir::tempPath() + QString("/keyframe-index/");
+	index_path.removeRecursively();
+	Settings::Instance()->ENABLE_KEYFRAME_INDEX = true;
+	Settings::Instance()->PATH_KEYFRAME_INDEX = index_path.path().toStdString();
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "sintel_trailer-720p.mp4";
+
+	const std::vector<int64_t> numbers = {300, 301, 315, 275, 270, 500, 100, 600, 1, 10, 700, 5};
+
+	// Decode the frames without the index (in order, so every seek is forwards)
+	Settings::Instance()->ENABLE_KEYFRAME_INDEX = false;
+	std::map<int64_t, std::shared_ptr<Frame>> expected;
+	{
+		FFmpegReader r(path.str());
+		r.Open();
+		std::vector<int64_t> sorted_numbers = numbers;
+		std::sort(sorted_numbers.begin(), sorted_numbers.end());
+		for (int64_t number : sorted_numbers)
+			expected[number] = std::make_shared<Frame>(*r.GetFrame(number));
+		r.Close();
+	}
+	CHECK(index_path.entryList(QDir::Files).empty());
+	Settings::Instance()->ENABLE_KEYFRAME_INDEX = true;
+
+	// Build the index (and save it), then load it with a 2nd reader
+	for (int pass = 0; pass < 2; pass++) {
+		FFmpegReader r(path.str());
+		r.Open();
+
+		for (int64_t number : numbers) {
+			std::shared_ptr<Frame> f = r.GetFrame(number);
+			check_same_frame(f, expected[number]);
+		}
+
+		r.Close();
+		CHECK(index_path.entryList(QDir::Files).size() == 1);
+	}
+
+	Settings::Instance()->ENABLE_KEYFRAME_INDEX = false;
+	Settings::Instance()->PATH_KEYFRAME_INDEX = "";
+	index_path.removeRecursively();
+}
+
+TEST_CASE( "Read ahead", "[libopenshot][ffmpegreader]" )
+{
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "sintel_trailer-720p.mp4";
+
+	// Frames are read forwards, backwards (after a seek), then from the start again
+	std::vector<int64_t> numbers;
+	for (int64_t number = 1; number <= 30; number++)
+		numbers.push_back(number);
+	for (int64_t number = 300; number >= 280; number--)
+		numbers.push_back(number);
+	for (int64_t number = 5; number <= 12; number++)
+		numbers.push_back(number);
+
+	// Decode the frames without reading ahead
+	Settings::Instance()->READ_AHEAD_FRAMES = 0;
+	std::map<int64_t, std::shared_ptr<Frame>> expected;
+	{
+		FFmpegReader r(path.str());
+		r.Open();
+		for (int64_t number : numbers) {
+			if (!expected.count(number))
+				expected[number] = std::make_shared<Frame>(*r.GetFrame(number));
+		}
+		expected[100] = std::make_shared<Frame>(*r.GetFrame(100));
+		expected[101] = std::make_shared<Frame>(*r.GetFrame(101));
+		r.Close();
+	}
+
+	Settings::Instance()->READ_AHEAD_FRAMES = 8;
+	FFmpegReader r(path.str());
+	r.Open();
+
+	// Each frame matches (including frames decoded ahead of a seek backwards)
+	for (int64_t number : numbers) {
+		std::shared_ptr<Frame> f = r.GetFrame(number);
+		check_same_frame(f, expected[number]);
+	}
+
+	// Re-open, and read again
+	r.Close();
+	r.Open();
+	check_same_frame(r.GetFrame(100), expected[100]);
+	check_same_frame(r.GetFrame(101), expected[101]);
+	r.Close();
+
+	Settings::Instance()->READ_AHEAD_FRAMES = 0;
+}
+
 TEST_CASE( "Frame_Rate", "[libopenshot][ffmpegreader]" )
 {
 	// Create a reader
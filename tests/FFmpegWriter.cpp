@@ -12,6 +12,7 @@
 
 #include <sstream>
 #include <memory>
+#include <vector>
 
 #include "openshot_catch.h"
 
@@ -233,3 +234,28 @@ TEST_CASE( "Gif", "[libopenshot][ffmpegwriter]" )
     // Close reader
     r1.Close();
 }
+
+TEST_CASE( "Pad final audio frame", "[libopenshot][ffmpegwriter]" )
+{
+	// mp2 encodes frames of exactly 1152 samples, so a short final frame must be padded
+	FFmpegWriter w("output_mp2.mkv");
+	w.SetAudioOptions(true, "mp2", 44100, 2, LAYOUT_STEREO, 192000);
+	w.Open();
+
+	// 10 frames of 1470 samples (14700 samples, which isn't a multiple of 1152)
+	std::vector<float> samples(1470, 0.5f);
+	for (int64_t number = 1; number <= 10; number++) {
+		auto f = std::make_shared<Frame>(number, 16, 16, "#000000", 1470, 2);
+		f->AddAudio(true, 0, 0, samples.data(), 1470, 1.0);
+		f->AddAudio(true, 1, 0, samples.data(), 1470, 1.0);
+		w.WriteFrame(f);
+	}
+	w.Close();
+
+	// Every sample was encoded (including the last 876 samples)
+	FFmpegReader r("output_mp2.mkv");
+	r.Open();
+	CHECK(r.info.has_audio);
+	CHECK(r.info.duration >= Approx(14700 / 44100.0).margin(0.001));
+	r.Close();
+}
@@ -662,6 +662,29 @@ TEST_CASE( "TrackedObjectBBox GetVal interpolation", "[libopenshot][keyframe]" )
 
 }
 
+TEST_CASE( "TrackedObjectBBox GetVal after edits", "[libopenshot][keyframe]" )
+{
+	TrackedObjectBBox kfb;
+
+	kfb.AddBox(1, 10.0, 10.0, 100.0, 100.0, 0.0);
+	kfb.AddBox(11, 20.0, 20.0, 100.0, 100.0, 0.0);
+
+	CHECK(kfb.GetBox(6).cx == 15.0);
+	CHECK(kfb.GetBox(12).cx == -1.0);
+
+	// Changed and removed boxes are picked up by the following lookups
+	kfb.AddBox(11, 30.0, 30.0, 100.0, 100.0, 0.0);
+	CHECK(kfb.GetBox(6).cx == 20.0);
+
+	kfb.AddBox(21, 40.0, 40.0, 100.0, 100.0, 0.0);
+	kfb.RemoveBox(11);
+	CHECK(kfb.GetBox(11).cx == 25.0);
+	CHECK(kfb.GetBox(21).cx == 40.0);
+
+	kfb.delta_x.AddPoint(1, 5.0);
+	CHECK(kfb.GetBox(11).cx == 30.0);
+}
+
 
 TEST_CASE( "TrackedObjectBBox SetJson", "[libopenshot][keyframe]" )
 {
@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @brief Unit tests for openshot::ParallelExporter
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <sstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "openshot_catch.h"
+
+#include "ParallelExporter.h"
+#include "Clip.h"
+#include "Exceptions.h"
+#include "FFmpegReader.h"
+#include "Fraction.h"
+#include "Frame.h"
+#include "Timeline.h"
+
+using namespace openshot;
+
+#if IS_FFMPEG_3_2
+// Times (in seconds) of the keyframes of the video stream of a file
+static std::vector<double> keyframe_times(const std::string& path)
+{
+	AVFormatContext* input = NULL;
+	REQUIRE(avformat_open_input(&input, path.c_str(), NULL, NULL) == 0);
+	REQUIRE(avformat_find_stream_info(input, NULL) >= 0);
+	int index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+	REQUIRE(index >= 0);
+
+	std::vector<double> times;
+	AVPacket* packet = av_packet_alloc();
+	while (av_read_frame(input, packet) >= 0) {
+		if (packet->stream_index == index && (packet->flags & AV_PKT_FLAG_KEY))
+			times.push_back(packet->pts * av_q2d(input->streams[index]->time_base));
+		AV_FREE_PACKET(packet);
+	}
+	av_packet_free(&packet);
+	avformat_close_input(&input);
+	return times;
+}
+#endif
+
+TEST_CASE( "Export segments", "[libopenshot][parallelexporter]" )
+{
+	// Timeline with a 4 second clip
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "sintel_trailer-720p.mp4";
+	Timeline t(640, 360, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	Clip c(path.str());
+	c.End(4.0);
+	t.AddClip(&c);
+
+	// Export with 4 threads (5 segments of 24 frames), and with 1 thread (in one piece)
+	for (int threads : {4, 1}) {
+		ParallelExporter e(&t, threads > 1 ? "output_parallel.mp4" : "output_serial.mp4");
+		e.SetThreads(threads);
+		e.SetAudioOptions(true, "aac", 44100, 2, LAYOUT_STEREO, 128000);
+		e.SetVideoOptions(true, "libx264", Fraction(30, 1), 640, 360, Fraction(1, 1), false, false, 2000000);
+		e.SetOption(VIDEO_STREAM, "g", "12");
+		e.SetOption(VIDEO_STREAM, "x264-params", "scenecut=0");
+		e.Export(1, 120);
+	}
+
+	FFmpegReader r("output_parallel.mp4");
+	r.Open();
+	CHECK(r.info.has_video);
+	CHECK(r.info.has_audio);
+	CHECK(r.info.width == 640);
+	CHECK(r.info.height == 360);
+	CHECK(r.info.duration == Approx(4.0).margin(0.2));
+	CHECK(r.GetFrame(100)->number == 100);
+	CHECK(r.GetFrame(100)->GetAudioChannelsCount() == 2);
+	r.Close();
+
+#if IS_FFMPEG_3_2
+	// Segments start on the keyframes of a single encode (every 12 frames)
+	std::vector<double> parallel_keyframes = keyframe_times("output_parallel.mp4");
+	std::vector<double> serial_keyframes = keyframe_times("output_serial.mp4");
+	REQUIRE(serial_keyframes.size() == 10);
+	REQUIRE(parallel_keyframes.size() == serial_keyframes.size());
+	for (size_t i = 0; i < serial_keyframes.size(); i++) {
+		CHECK(parallel_keyframes[i] == Approx(serial_keyframes[i]).margin(0.001));
+		CHECK(parallel_keyframes[i] - parallel_keyframes[0] == Approx(i * 0.4).margin(0.001));
+	}
+#endif
+}
+
+TEST_CASE( "Invalid range", "[libopenshot][parallelexporter]" )
+{
+	Timeline t(640, 360, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	ParallelExporter e(&t, "output_parallel.mp4");
+	e.SetVideoOptions(true, "libx264", Fraction(30, 1), 640, 360, Fraction(1, 1), false, false, 2000000);
+	CHECK_THROWS_AS(e.Export(10, 5), InvalidOptions);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file
+ * @brief Unit tests for openshot::ProjectSnapshot
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <sstream>
+#include <string>
+#include <QDir>
+#include <QFile>
+
+#include "openshot_catch.h"
+
+#include "Clip.h"
+#include "Exceptions.h"
+#include "KeyFrame.h"
+#include "ProjectSnapshot.h"
+#include "Timeline.h"
+
+using namespace openshot;
+
+TEST_CASE( "Encode and Decode", "[libopenshot][projectsnapshot]" )
+{
+	Json::Value root;
+	root["null"] = Json::Value();
+	root["bool"] = true;
+	root["int"] = -42;
+	root["uint"] = Json::Value(Json::LargestUInt(18446744073709551615ull));
+	root["double"] = 0.1;
+	root["string"] = "caf\xc3\xa9";
+	root["array"].append(1);
+	root["array"].append("two");
+	root["array"].append(Json::Value(Json::objectValue));
+	root["object"]["nested"]["empty"] = Json::Value(Json::arrayValue);
+
+	std::string data = ProjectSnapshot::Encode(root);
+	Json::Value decoded = ProjectSnapshot::Decode(data.data(), data.size());
+	CHECK(decoded == root);
+	CHECK(decoded["int"].type() == Json::intValue);
+	CHECK(decoded["uint"].type() == Json::uintValue);
+	CHECK(decoded["double"].asDouble() == 0.1);
+}
+
+TEST_CASE( "Keyframe points", "[libopenshot][projectsnapshot]" )
+{
+	Keyframe k;
+	for (int i = 1; i <= 1000; i++)
+		k.AddPoint(i, i * 0.25, (InterpolationType) (i % 3));
+
+	// Points are saved as records (much smaller than their JSON)
+	Json::Value root = k.JsonValue();
+	std::string data = ProjectSnapshot::Encode(root);
+	CHECK(data.size() < root.toStyledString().size() / 2);
+
+	Json::Value decoded = ProjectSnapshot::Decode(data.data(), data.size());
+	CHECK(decoded == root);
+
+	Keyframe loaded;
+	loaded.SetJsonValue(decoded);
+	CHECK(loaded.GetLength() == k.GetLength());
+	CHECK(loaded.GetValue(500) == Approx(k.GetValue(500)).margin(0.0001));
+
+	// Arrays of other objects aren't changed
+	root["Points"][0]["extra"] = 1;
+	data = ProjectSnapshot::Encode(root);
+	CHECK(ProjectSnapshot::Decode(data.data(), data.size()) == root);
+}
+
+TEST_CASE( "Invalid snapshots", "[libopenshot][projectsnapshot]" )
+{
+	Json::Value root;
+	root["key"] = "value";
+	std::string data = ProjectSnapshot::Encode(root);
+
+	// Truncated data
+	CHECK_THROWS_AS(ProjectSnapshot::Decode(data.data(), data.size() - 1), InvalidFormat);
+
+	// Not a snapshot
+	std::string json = root.toStyledString();
+	CHECK_THROWS_AS(ProjectSnapshot::Decode(json.data(), json.size()), InvalidFormat);
+
+	// Missing file
+	CHECK_THROWS_AS(ProjectSnapshot::Load(QDir::tempPath().toStdString() + "/missing-snapshot.osps"), InvalidFile);
+}
+
+TEST_CASE( "Save and Load Timeline", "[libopenshot][projectsnapshot]" )
+{
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "front3.png";
+	std::string snapshot_path = QDir::tempPath().toStdString() + "/timeline-snapshot.osps";
+
+	Timeline t(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	Clip clip(path.str());
+	clip.Layer(1);
+	clip.Position(2.0);
+	clip.alpha.AddPoint(1, 0.0);
+	clip.alpha.AddPoint(60, 1.0, BEZIER);
+	t.AddClip(&clip);
+	t.SaveSnapshot(snapshot_path);
+
+	Timeline loaded(320, 240, Fraction(24, 1), 48000, 1, LAYOUT_MONO);
+	loaded.LoadSnapshot(snapshot_path);
+	CHECK(loaded.info.width == 640);
+	CHECK(loaded.info.fps.num == 30);
+	REQUIRE(loaded.Clips().size() == 1);
+	CHECK(loaded.Clips().front()->Position() == Approx(2.0).margin(0.0001));
+	CHECK(loaded.Clips().front()->alpha.GetValue(30) == Approx(clip.alpha.GetValue(30)).margin(0.0001));
+
+	QFile::remove(QString::fromStdString(snapshot_path));
+}
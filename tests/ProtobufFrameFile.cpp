@@ -0,0 +1,186 @@
+/**
+ * @file
+ * @brief Unit tests for openshot::ProtobufFrameWriter and openshot::ProtobufFrameReader
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <QDir>
+#include <QFile>
+
+#include "openshot_catch.h"
+
+#include "Exceptions.h"
+#include "ProtobufFrameFile.h"
+#include "trackerdata.pb.h"
+
+using namespace openshot;
+
+// Write a frame-indexed file of frames 1-3 (with frame 2 added twice)
+static std::string write_indexed_file(const std::string& name)
+{
+	std::string path = QDir::tempPath().toStdString() + "/" + name;
+
+	pb_tracker::Tracker header;
+	header.mutable_last_updated()->set_seconds(1234);
+
+	ProtobufFrameWriter writer(path, header);
+	for (int id : {3, 2, 1, 2}) {
+		pb_tracker::Frame frame;
+		frame.set_id(id);
+		frame.set_rotation(id * 10.0f);
+		frame.mutable_bounding_box()->set_x1(id / 10.0f);
+		CHECK(writer.AddFrame(id, frame));
+	}
+	CHECK(writer.Close());
+	return path;
+}
+
+static std::string read_file(const std::string& path)
+{
+	std::ifstream input(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::string& path, const std::string& data)
+{
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	output.write(data.data(), data.size());
+}
+
+// Overwrite a little-endian 64-bit value in the data of a file
+static void set_value(std::string& data, size_t offset, uint64_t value)
+{
+	for (size_t i = 0; i < 8; i++)
+		data[offset + i] = char((value >> (8 * i)) & 0xff);
+}
+
+TEST_CASE( "Round trip", "[libopenshot][opencv][protobufframefile]" )
+{
+	std::string path = write_indexed_file("frames_round_trip.data");
+
+	ProtobufFrameReader reader;
+	REQUIRE(reader.Open(path));
+	REQUIRE(reader.Count() == 3);
+	CHECK(reader.FrameId(0) == 1);
+	CHECK(reader.FrameId(1) == 2);
+	CHECK(reader.FrameId(2) == 3);
+	CHECK(reader.Contains(2));
+	CHECK_FALSE(reader.Contains(4));
+
+	pb_tracker::Tracker header;
+	REQUIRE(reader.ReadHeader(header));
+	CHECK(header.last_updated().seconds() == 1234);
+	CHECK(header.frame_size() == 0);
+
+	pb_tracker::Frame frame;
+	REQUIRE(reader.ReadFrame(3, frame));
+	CHECK(frame.id() == 3);
+	CHECK(frame.rotation() == Approx(30.0f));
+	CHECK(frame.bounding_box().x1() == Approx(0.3f));
+	CHECK_FALSE(reader.ReadFrame(4, frame));
+	reader.Close();
+
+	// Every frame is passed in order (the last copy of frame 2 is kept)
+	pb_tracker::Tracker message;
+	std::vector<int> ids;
+	CHECK(ReadProtobufFrames(path, message, [&](const pb_tracker::Frame& f) { ids.push_back(f.id()); }));
+	CHECK(ids == std::vector<int>({1, 2, 3}));
+	CHECK(message.last_updated().seconds() == 1234);
+
+	QFile::remove(QString::fromStdString(path));
+}
+
+TEST_CASE( "Legacy single message", "[libopenshot][opencv][protobufframefile]" )
+{
+	std::string path = QDir::tempPath().toStdString() + "/frames_legacy.data";
+
+	// Files of older versions are one message, with every frame
+	pb_tracker::Tracker legacy;
+	legacy.mutable_last_updated()->set_seconds(99);
+	for (int id = 1; id <= 5; id++) {
+		pb_tracker::Frame* frame = legacy.add_frame();
+		frame->set_id(id);
+		frame->set_rotation(id);
+	}
+	{
+		std::fstream output(path, std::ios::out | std::ios::trunc | std::ios::binary);
+		REQUIRE(legacy.SerializeToOstream(&output));
+	}
+
+	ProtobufFrameReader reader;
+	CHECK_FALSE(reader.Open(path));
+	CHECK_FALSE(reader.IsOpen());
+
+	pb_tracker::Tracker message;
+	std::vector<int> ids;
+	float rotations = 0.0f;
+	CHECK(ReadProtobufFrames(path, message, [&](const pb_tracker::Frame& f) {
+		ids.push_back(f.id());
+		rotations += f.rotation();
+	}));
+	CHECK(ids == std::vector<int>({1, 2, 3, 4, 5}));
+	CHECK(rotations == Approx(15.0f));
+	CHECK(message.last_updated().seconds() == 99);
+	CHECK(message.frame_size() == 0);
+
+	QFile::remove(QString::fromStdString(path));
+}
+
+TEST_CASE( "Damaged files", "[libopenshot][opencv][protobufframefile]" )
+{
+	std::string path = write_indexed_file("frames_damaged.data");
+	const std::string data = read_file(path);
+	const size_t index_end = data.size() - 8 - 8;
+	uint64_t index_offset = 0;
+	for (size_t i = 0; i < 8; i++)
+		index_offset |= uint64_t((unsigned char) data[index_end + i]) << (8 * i);
+	REQUIRE(index_offset < index_end);
+
+	ProtobufFrameReader reader;
+	pb_tracker::Tracker message;
+	auto ignore = [](const pb_tracker::Frame&) {};
+
+	SECTION("truncated") {
+		write_file(path, data.substr(0, data.size() - 10));
+		CHECK_THROWS_AS(reader.Open(path), InvalidFile);
+		CHECK_FALSE(ReadProtobufFrames(path, message, ignore));
+
+		write_file(path, data.substr(0, 12));
+		CHECK_THROWS_AS(reader.Open(path), InvalidFile);
+	}
+	SECTION("index offset out of bounds") {
+		std::string damaged = data;
+		set_value(damaged, index_end, UINT64_MAX - 4);
+		write_file(path, damaged);
+		CHECK_THROWS_AS(reader.Open(path), InvalidFile);
+		CHECK_FALSE(ReadProtobufFrames(path, message, ignore));
+	}
+	SECTION("frame count too large") {
+		std::string damaged = data;
+		set_value(damaged, index_offset, UINT64_MAX / 2);
+		write_file(path, damaged);
+		CHECK_THROWS_AS(reader.Open(path), InvalidFile);
+	}
+	SECTION("frame record out of bounds") {
+		std::string damaged = data;
+		set_value(damaged, index_offset + 8 + 8, UINT64_MAX - 2);
+		write_file(path, damaged);
+		CHECK_THROWS_AS(reader.Open(path), InvalidFile);
+		CHECK_FALSE(ReadProtobufFrames(path, message, ignore));
+	}
+	CHECK_FALSE(reader.IsOpen());
+
+	QFile::remove(QString::fromStdString(path));
+}
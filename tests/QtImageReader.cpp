@@ -18,6 +18,8 @@
 #include "Clip.h"
 #include "Exceptions.h"
 #include "Frame.h"
+#include "ImageCache.h"
+#include "Settings.h"
 #include "Timeline.h"
 
 using namespace openshot;
@@ -84,3 +86,43 @@ TEST_CASE( "Check_SVG_Loading", "[libopenshot][qtimagereader]" )
     t1.Close();
     r.Close();
 }
+
+TEST_CASE( "Shared_Decoded_Images", "[libopenshot][qtimagereader]" )
+{
+    std::stringstream path;
+    path << TEST_MEDIA_PATH << "front.png";
+    ImageCache* cache = ImageCache::Instance();
+    cache->Clear();
+
+    // Readers of the same file share their decoded and scaled images
+    QtImageReader r1(path.str());
+    QtImageReader r2(path.str());
+    r1.Open();
+    r2.Open();
+    std::shared_ptr<Frame> f1 = r1.GetFrame(1);
+    std::shared_ptr<Frame> f2 = r2.GetFrame(1);
+    CHECK(f1->GetImage() == f2->GetImage());
+    CHECK(f1->GetImage()->width() == r1.info.width);
+    CHECK(cache->Count() == 2);
+
+    // Images are released once they're unused (with no budget for recent images)
+    int64_t max_bytes = Settings::Instance()->IMAGE_CACHE_MAX_BYTES;
+    Settings::Instance()->IMAGE_CACHE_MAX_BYTES = 0;
+    cache->Clear();
+    CHECK(cache->Count() == 2);
+    f1.reset();
+    f2.reset();
+    r1.Close();
+    r2.Close();
+    CHECK(cache->Count() == 0);
+    Settings::Instance()->IMAGE_CACHE_MAX_BYTES = max_bytes;
+
+    // Recent images are kept (up to the budget), so opening the file again doesn't decode it
+    r1.Open();
+    std::shared_ptr<QImage> image = r1.GetFrame(1)->GetImage();
+    r1.Close();
+    CHECK(cache->Count() == 2);
+    r2.Open();
+    CHECK(r2.GetFrame(1)->GetImage() == image);
+    r2.Close();
+}
@@ -38,7 +38,7 @@ TEST_CASE( "derived class", "[libopenshot][readerbase]" )
 		std::string Json() const { return ""; };
 		void SetJson(std::string value) { };
 		Json::Value JsonValue() const { return Json::Value("{}"); };
-		void SetJsonValue(Json::Value root) { };
+		void SetJsonValue(const Json::Value& root) { };
 		bool IsOpen() { return true; };
 		std::string Name() { return "TestReader"; };
 	};
@@ -0,0 +1,186 @@
+/**
+ * @file
+ * @brief Unit tests for openshot::RenderCache
+ * @author Jonathan Thomas <jonathan@openshot.org>
+ *
+ * @ref License
+ */
+
+// Copyright (c) 2008-2019 OpenShot Studios, LLC
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <QDir>
+
+#include "openshot_catch.h"
+
+#include "Clip.h"
+#include "Frame.h"
+#include "RenderCache.h"
+#include "Settings.h"
+#include "Timeline.h"
+
+using namespace openshot;
+
+TEST_CASE( "Add and GetFrame", "[libopenshot][rendercache]" )
+{
+	QDir temp_path = QDir::tempPath() + QString("/render_cache_add/");
+	Settings::Instance()->RENDER_CACHE_PATH = temp_path.path().toStdString();
+	RenderCache* cache = RenderCache::Instance();
+	cache->Clear();
+	CHECK(cache->Enabled());
+
+	// Frame with an image and audio
+	auto f = std::make_shared<Frame>(1, 64, 48, "#ff0000", 100, 2);
+	std::vector<float> samples(100, 0.5f);
+	f->AddAudio(true, 0, 0, samples.data(), 100, 1.0);
+	f->AddAudio(true, 1, 0, samples.data(), 100, 1.0);
+	cache->Add(RenderCache::Key(Json::Value("state 1")), f);
+	CHECK(cache->Count() == 1);
+
+	auto cached = cache->GetFrame(RenderCache::Key(Json::Value("state 1")));
+	REQUIRE(cached != nullptr);
+	CHECK(cached->GetWidth() == 64);
+	CHECK(cached->GetHeight() == 48);
+	CHECK(*cached->GetImage() == *f->GetImage());
+	CHECK(cached->GetAudioChannelsCount() == 2);
+	CHECK(cached->GetAudioSamplesCount() == 100);
+	CHECK(cached->GetAudioSamples(1)[50] == Approx(0.5f).margin(0.00001));
+
+	// Different state
+	CHECK(cache->GetFrame(RenderCache::Key(Json::Value("state 2"))) == nullptr);
+
+	cache->Clear();
+	CHECK(cache->Count() == 0);
+	Settings::Instance()->RENDER_CACHE_PATH = "";
+	CHECK_FALSE(cache->Enabled());
+}
+
+TEST_CASE( "max bytes", "[libopenshot][rendercache]" )
+{
+	QDir temp_path = QDir::tempPath() + QString("/render_cache_max_bytes/");
+	Settings::Instance()->RENDER_CACHE_PATH = temp_path.path().toStdString();
+	RenderCache* cache = RenderCache::Instance();
+	cache->Clear();
+
+	// Measure the size of one frame
+	auto f = std::make_shared<Frame>(1, 64, 48, "#00ff00", 0, 2);
+	cache->Add(RenderCache::Key(Json::Value(0)), f);
+	int64_t frame_bytes = temp_path.entryInfoList(QStringList() << "*.frame").first().size();
+	REQUIRE(frame_bytes > 0);
+
+	// The least recently used frames are deleted
+	Settings::Instance()->RENDER_CACHE_MAX_BYTES = frame_bytes * 3;
+	for (int i = 1; i < 10; i++)
+		cache->Add(RenderCache::Key(Json::Value(i)), f);
+	CHECK(cache->Count() > 0);
+	CHECK(cache->Count() <= 3);
+
+	cache->Clear();
+	Settings::Instance()->RENDER_CACHE_MAX_BYTES = 2LL * 1024 * 1024 * 1024;
+	Settings::Instance()->RENDER_CACHE_PATH = "";
+}
+
+TEST_CASE( "shared by timelines", "[libopenshot][rendercache]" )
+{
+	QDir temp_path = QDir::tempPath() + QString("/render_cache_timelines/");
+	Settings::Instance()->RENDER_CACHE_PATH = temp_path.path().toStdString();
+	RenderCache* cache = RenderCache::Instance();
+	cache->Clear();
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "interlaced.png";
+
+	// Render a frame
+	Timeline t1(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	Clip c1(path.str());
+	c1.Id("C1");
+	c1.End(10);
+	t1.AddClip(&c1);
+	t1.Open();
+	t1.GetFrame(1);
+	CHECK(cache->Count() == 1);
+
+	// Another timeline with the same clip loads the frame
+	Timeline t2(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	Clip c2(path.str());
+	c2.Id("C1");
+	c2.End(10);
+	t2.AddClip(&c2);
+	t2.Open();
+	auto f = t2.GetFrame(1);
+	CHECK(f->number == 1);
+	CHECK(f->GetWidth() == 640);
+	CHECK(cache->Count() == 1);
+
+	// Changing a property renders the frame again
+	c2.alpha = Keyframe(0.5);
+	t2.ClearAllCache();
+	t2.GetFrame(1);
+	CHECK(cache->Count() == 2);
+
+	// So does changing the volume of the previous frame (which audio is ramped from)
+	t2.GetFrame(2);
+	CHECK(cache->Count() == 3);
+	c2.volume = Keyframe();
+	c2.volume.AddPoint(1, 0.0);
+	c2.volume.AddPoint(2, 1.0);
+	t2.ClearAllCache();
+	t2.GetFrame(2);
+	CHECK(cache->Count() == 4);
+
+	t1.Close();
+	t2.Close();
+	cache->Clear();
+	Settings::Instance()->RENDER_CACHE_PATH = "";
+}
+
+TEST_CASE( "nested timelines", "[libopenshot][rendercache]" )
+{
+	QDir temp_path = QDir::tempPath() + QString("/render_cache_nested/");
+	Settings::Instance()->RENDER_CACHE_PATH = temp_path.path().toStdString();
+	RenderCache* cache = RenderCache::Instance();
+	cache->Clear();
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "interlaced.png";
+
+	// A timeline at a third of the frame rate, nested in a clip (frames 4 to 6 show its frame 2)
+	Timeline nested(640, 480, Fraction(10, 1), 44100, 2, LAYOUT_STEREO);
+	Clip c1(path.str());
+	c1.Id("C1");
+	c1.End(10);
+	nested.AddClip(&c1);
+
+	Timeline t(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	Clip c2(&nested);
+	c2.Id("C2");
+	c2.End(10);
+	t.AddClip(&c2);
+	t.Open();
+	t.GetFrame(4);
+	t.GetFrame(5);
+	t.GetFrame(8);
+	// (the nested timeline caches its own frames too)
+	int64_t count = cache->Count();
+	CHECK(count >= 3);
+
+	// Fading the nested clip out after its frame 2 only renders the frames after it again
+	c1.alpha = Keyframe();
+	c1.alpha.AddPoint(1, 1.0);
+	c1.alpha.AddPoint(2, 1.0);
+	c1.alpha.AddPoint(4, 0.0);
+	t.ClearAllCache(true);
+	t.GetFrame(4);
+	t.GetFrame(5);
+	CHECK(cache->Count() == count);
+	t.GetFrame(8);
+	CHECK(cache->Count() > count);
+
+	t.Close();
+	cache->Clear();
+	Settings::Instance()->RENDER_CACHE_PATH = "";
+}
@@ -10,10 +10,12 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include <chrono>
 #include <string>
 #include <sstream>
 #include <memory>
 #include <list>
+#include <thread>
 #include <omp.h>
 
 #include "openshot_catch.h"
@@ -23,6 +25,8 @@
 #include "Clip.h"
 #include "Frame.h"
 #include "Fraction.h"
+#include "Settings.h"
+#include "Exceptions.h"
 #include "effects/Blur.h"
 #include "effects/Negate.h"
 
@@ -600,6 +604,174 @@ TEST_CASE( "Effect: Blur", "[libopenshot][timeline]" )
 	t.Close();
 }
 
+TEST_CASE( "GetScrubFrame", "[libopenshot][timeline]" )
+{
+	// Create a timeline
+	Timeline t(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "front.png";
+	Clip clip(path.str());
+	t.AddClip(&clip);
+	t.Open();
+
+	// Uncached frames are rendered at a reduced size (and not cached)
+	Settings::Instance()->SCRUB_PREVIEW_SCALE = 0.5;
+	std::shared_ptr<Frame> f = t.GetScrubFrame(1);
+	REQUIRE(f != nullptr);
+	CHECK(f->number == 1);
+	CHECK(f->GetWidth() == 320);
+	CHECK(f->GetHeight() == 240);
+	CHECK_FALSE(t.GetCache()->Contains(1));
+
+	// Full size frames aren't affected by the reduced frame, and are then used while scrubbing
+	f = t.GetFrame(1);
+	CHECK(f->GetWidth() == 640);
+	CHECK(f->GetHeight() == 480);
+	f = t.GetScrubFrame(1);
+	CHECK(f->GetWidth() == 640);
+
+	t.Close();
+}
+
+TEST_CASE( "Open and close clips in the background", "[libopenshot][timeline]" )
+{
+	// Create a timeline
+	Timeline t(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	Settings::Instance()->CLIP_PREWARM_SECONDS = 2.0;
+	Settings::Instance()->CLIP_CLOSE_DELAY = 0.0;
+
+	std::stringstream path;
+	path << TEST_MEDIA_PATH << "front.png";
+	Clip clip1(path.str());
+	clip1.Position(0.0);
+	clip1.End(1.0);
+	Clip clip2(path.str());
+	clip2.Position(1.5);
+	clip2.End(1.0);
+	Clip clip3(path.str());
+	clip3.Position(10.0);
+	clip3.End(1.0);
+	t.AddClip(&clip1);
+	t.AddClip(&clip2);
+	t.AddClip(&clip3);
+	t.Open();
+
+	// Clips starting soon are opened ahead of time
+	t.GetFrame(1);
+	CHECK(clip1.IsOpen());
+	for (int i = 0; i < 200 && !clip2.IsOpen(); i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	CHECK(clip2.IsOpen());
+	CHECK_FALSE(clip3.IsOpen());
+
+	// Clips which are no longer needed are closed
+	t.GetFrame(305);
+	CHECK(clip3.IsOpen());
+	for (int i = 0; i < 200 && (clip1.IsOpen() || clip2.IsOpen()); i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	CHECK_FALSE(clip1.IsOpen());
+	CHECK_FALSE(clip2.IsOpen());
+
+	t.Close();
+	CHECK_FALSE(clip3.IsOpen());
+	Settings::Instance()->CLIP_CLOSE_DELAY = 3.0;
+}
+
+TEST_CASE( "Lazy clip loading", "[libopenshot][timeline]" )
+{
+	// Project with a clip at the start, and a clip much later
+	std::stringstream path1;
+	path1 << TEST_MEDIA_PATH << "interlaced.png";
+	Timeline project(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	project.AutoMapClips(false);
+	Clip clip1(path1.str());
+	clip1.Id("C1");
+	clip1.End(10);
+	project.AddClip(&clip1);
+	Clip clip2(path1.str());
+	clip2.Id("C2");
+	clip2.Position(100);
+	clip2.End(10);
+	clip2.alpha = Keyframe(0.5);
+	project.AddClip(&clip2);
+
+	Settings::Instance()->LAZY_LOAD_CLIPS = true;
+	Timeline t(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	t.SetJson(project.Json());
+	Settings::Instance()->LAZY_LOAD_CLIPS = false;
+
+	// Only the timing of the clips is loaded
+	REQUIRE(t.Clips().size() == 2);
+	Clip* lazy1 = t.Clips().front();
+	Clip* lazy2 = t.Clips().back();
+	CHECK(lazy2->Position() == Approx(100.0).margin(0.00001));
+	CHECK(t.GetMaxFrame() == 110 * 30 + 1);
+	CHECK_THROWS_AS(lazy1->Reader(), ReaderClosed);
+	CHECK_THROWS_AS(lazy2->Reader(), ReaderClosed);
+
+	// Clips are loaded when a frame needs them
+	t.Open();
+	t.GetFrame(1);
+	CHECK(lazy1->Reader()->Name() == "FrameMapper");
+	CHECK_THROWS_AS(lazy2->Reader(), ReaderClosed);
+
+	// JSON of clips which aren't loaded yet is saved as it was loaded
+	lazy2->Position(50);
+	Json::Value root = t.JsonValue();
+	CHECK(root["clips"][1]["position"].asDouble() == Approx(50.0).margin(0.00001));
+	CHECK(root["clips"][1]["reader"]["path"].asString() == path1.str());
+
+	// ... and loaded by GetClip
+	CHECK(t.GetClip("C2") == lazy2);
+	CHECK(lazy2->Position() == Approx(50.0).margin(0.00001));
+	CHECK(lazy2->alpha.GetValue(1) == Approx(0.5).margin(0.00001));
+	CHECK(lazy2->Reader()->Name() == "FrameMapper");
+
+	t.Close();
+}
+
+TEST_CASE( "Lazy clip loading of effects", "[libopenshot][timeline]" )
+{
+	// Project with a clip with an effect, and a clip without effects
+	std::stringstream path1;
+	path1 << TEST_MEDIA_PATH << "interlaced.png";
+	Timeline project(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	project.AutoMapClips(false);
+	Negate negate;
+	negate.Id("E1");
+	Clip clip1(path1.str());
+	clip1.Id("C1");
+	clip1.End(10);
+	clip1.AddEffect(&negate);
+	project.AddClip(&clip1);
+	Clip clip2(path1.str());
+	clip2.Id("C2");
+	clip2.Position(100);
+	clip2.End(10);
+	project.AddClip(&clip2);
+
+	Settings::Instance()->LAZY_LOAD_CLIPS = true;
+	Timeline t(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	t.SetJson(project.Json());
+	Settings::Instance()->LAZY_LOAD_CLIPS = false;
+	REQUIRE(t.Clips().size() == 2);
+	Clip* lazy1 = t.Clips().front();
+	Clip* lazy2 = t.Clips().back();
+
+	// A new frame rate maps the loaded clips (the others are mapped when they're loaded)
+	t.info.fps = Fraction(24, 1);
+	CHECK_NOTHROW(t.ApplyMapperToClips());
+	CHECK_THROWS_AS(lazy1->Reader(), ReaderClosed);
+
+	// Finding the effects of the clips loads the clips with effects
+	std::list<EffectBase*> effects = t.ClipEffects();
+	REQUIRE(effects.size() == 1);
+	CHECK(effects.front()->Id() == "E1");
+	CHECK(lazy1->Reader()->Name() == "FrameMapper");
+	CHECK_THROWS_AS(lazy2->Reader(), ReaderClosed);
+}
+
 TEST_CASE( "GetMaxFrame and GetMaxTime", "[libopenshot][timeline]" )
 {
 	// Create a timeline
@@ -798,6 +970,61 @@ TEST_CASE( "ApplyJSONDiff and FrameMappers", "[libopenshot][timeline]" )
 	CHECK(clip1.Reader()->Name() == "QtImageReader");
 }
 
+TEST_CASE( "ApplyJSONDiff only clears changed frames", "[libopenshot][timeline]" )
+{
+	// Create a timeline
+	Timeline t(640, 480, Fraction(30, 1), 44100, 2, LAYOUT_STEREO);
+	t.Open();
+
+	// Add clip
+	std::stringstream path1;
+	path1 << TEST_MEDIA_PATH << "interlaced.png";
+	Clip clip1(path1.str());
+	clip1.Id("ABC");
+	clip1.Layer(1);
+	clip1.Position(0);
+	clip1.End(10);
+	std::string reader_json = clip1.Reader()->Json();
+	t.AddClip(&clip1);
+
+	// The clip's reader is mapped to the timeline's frame rate
+	CHECK(clip1.Reader()->Name() == "FrameMapper");
+
+	// Fade the clip out after frame 30
+	std::stringstream json_change1;
+	json_change1 << "[{\"type\":\"update\",\"key\":[\"clips\",{\"id\":\"ABC\"}],\"value\":{\"id\":\"ABC\",\"alpha\":{\"Points\":["
+		<< "{\"co\":{\"X\":1.0,\"Y\":1.0},\"interpolation\":1},"
+		<< "{\"co\":{\"X\":30.0,\"Y\":1.0},\"interpolation\":1}]}},\"partial\":false}]";
+	t.ApplyJsonDiff(json_change1.str());
+
+	t.GetFrame(10);
+	t.GetFrame(60);
+	CHECK(t.GetCache()->GetFrame(10) != nullptr);
+	CHECK(t.GetCache()->GetFrame(60) != nullptr);
+
+	// Add a point after frame 30: frames before it are still cached (and the unchanged
+	// reader, as the editor sends it, doesn't change any frames)
+	std::stringstream json_change2;
+	json_change2 << "[{\"type\":\"update\",\"key\":[\"clips\",{\"id\":\"ABC\"}],\"value\":{\"id\":\"ABC\",\"alpha\":{\"Points\":["
+		<< "{\"co\":{\"X\":1.0,\"Y\":1.0},\"interpolation\":1},"
+		<< "{\"co\":{\"X\":30.0,\"Y\":1.0},\"interpolation\":1},"
+		<< "{\"co\":{\"X\":90.0,\"Y\":0.0},\"interpolation\":1}]},"
+		<< "\"reader\":" << reader_json << "},\"partial\":false}]";
+	t.ApplyJsonDiff(json_change2.str());
+
+	CHECK(t.GetCache()->GetFrame(10) != nullptr);
+	CHECK(t.GetCache()->GetFrame(60) == nullptr);
+
+	// Moving the clip clears all of its frames
+	std::stringstream json_change3;
+	json_change3 << "[{\"type\":\"update\",\"key\":[\"clips\",{\"id\":\"ABC\"}],\"value\":{\"id\":\"ABC\",\"position\":1.0},\"partial\":false}]";
+	t.ApplyJsonDiff(json_change3.str());
+
+	CHECK(t.GetCache()->GetFrame(10) == nullptr);
+
+	t.Close();
+}
+
 TEST_CASE( "ApplyJSONDiff Update Reader Info", "[libopenshot][timeline]" )
 {
 	// Create a timeline